@@ -12,21 +12,33 @@ let package = Package(
     dependencies: [
         .package(url: "https://github.com/AudioKit/AudioKit.git", .upToNextMajor(from: "5.6.5")),
         .package(url: "https://github.com/AudioKit/AudioKitEX.git", .upToNextMajor(from: "5.6.2")),
+        .package(url: "https://github.com/apple/swift-atomics.git", .upToNextMajor(from: "1.2.0")),
     ],
     targets: [
+        // The pull-model playback core: Foundation and Atomics only, so it
+        // builds and renders offline anywhere Swift runs
+        .target(
+            name: "PerpetualCore",
+            dependencies: [
+                .product(name: "Atomics", package: "swift-atomics")
+            ],
+            path: "Sources/PerpetualCore"
+        ),
         .executableTarget(
             name: "Perpetual",
             dependencies: [
+                "PerpetualCore",
                 .product(name: "AudioKit", package: "AudioKit"),
-                .product(name: "AudioKitEX", package: "AudioKitEX")
+                .product(name: "AudioKitEX", package: "AudioKitEX"),
+                .product(name: "Atomics", package: "swift-atomics")
             ],
             path: "Sources/Perpetual",
             resources: []
         ),
         .testTarget(
             name: "PerpetualTests",
-            dependencies: ["Perpetual"],
-            path: "Tests"
+            dependencies: ["PerpetualCore"],
+            path: "Tests/PerpetualTests"
         ),
     ]
 )
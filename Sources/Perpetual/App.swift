@@ -1,7 +1,17 @@
 import SwiftUI
 import AVFoundation
 
+/// Runs a command-line command when launched with one, the app otherwise
 @main
+enum PerpetualMain {
+    static func main() {
+        if CommandLineTool.handles(CommandLine.arguments) {
+            CommandLineTool.run(CommandLine.arguments)
+        }
+        PerpetualApp.main()
+    }
+}
+
 struct PerpetualApp: App {
     @NSApplicationDelegateAdaptor(AppDelegate.self) var appDelegate
     
@@ -41,6 +51,16 @@ struct FileCommands: Commands {
                 EventBus.shared.publishOpenFile()
             }
             .keyboardShortcut("o")
+            
+            Button("Add to Queue...") {
+                EventBus.shared.publishAddToQueue()
+            }
+            .keyboardShortcut("o", modifiers: [.command, .shift])
+            
+            Button("Export Extended Loop...") {
+                EventBus.shared.publishExportLoop()
+            }
+            .keyboardShortcut("e", modifiers: [.command, .shift])
         }
     }
 }
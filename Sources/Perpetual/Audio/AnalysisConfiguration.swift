@@ -0,0 +1,103 @@
+import Foundation
+
+/**
+ * AnalysisConfiguration
+ *
+ * The knobs of a structure analysis: feature resolution, how many loop
+ * pairs survive each stage of the search, the similarity weights and
+ * thresholds, and which seam metrics are measured. The presets trade
+ * accuracy for speed; loop points cached by one configuration are not
+ * reused by another.
+ */
+struct AnalysisConfiguration: Codable, Equatable {
+    /// Weights of each feature in the similarity between two feature frames
+    struct FeatureWeights: Codable, Equatable {
+        var rms: Float = 1.5               // Volume changes
+        var spectralCentroid: Float = 1.0  // Timbre changes
+        var spectralFlux: Float = 3.0      // Heavily emphasize spectral changes
+        var zeroCrossingRate: Float = 0.5  // Noise vs. tone
+    }
+
+    /// Preset name, shown in the CLI and the benchmarks
+    var name: String
+
+    // MARK: Features
+
+    /// Samples averaged into one before features are taken (1 analyzes at the file's rate)
+    var decimation: Int = 1
+
+    /// Feature window and hop, in samples at the analysis rate
+    var windowSize: Int = 8192
+    var hopSize: Int = 4096
+
+    var featureWeights = FeatureWeights()
+
+    // MARK: Structure
+
+    /// Shortest section or loop considered, in seconds
+    var minSectionDuration: Double = 2.0
+
+    /// Similarity above which the matrix is enhanced along its diagonals
+    var enhancementThreshold: Float = 0.7
+
+    /// Average diagonal similarity at which two regions count as a repeat
+    var patternThreshold: Float = 0.75
+    var repetitionThreshold: Float = 0.7
+
+    // MARK: Loop Search
+
+    /// Feature frames compared on each side of a seam in the coarse pass
+    var coarseContextFrames: Int = 8
+
+    /// Pairs refined on the STFT, and pairs aligned and fully evaluated
+    var coarseSurvivorCount: Int = 48
+    var refinedSurvivorCount: Int = 16
+
+    /// STFT hop used to refine surviving pairs, in samples
+    var refinementHopSize: Int = 512
+
+    /// Whether seams are scored for harmonic (chroma) continuity
+    var measuresHarmonicContinuity: Bool = true
+
+    /// Frames between feature frames at the file's rate
+    var featureHop: Int {
+        return hopSize * decimation
+    }
+
+    // MARK: - Presets
+
+    /// Half-rate features at twice the hop, a narrow search and no chroma
+    static let fast = AnalysisConfiguration(name: "fast", decimation: 2, windowSize: 4096, hopSize: 4096,
+                                            coarseSurvivorCount: 24, refinedSurvivorCount: 6,
+                                            refinementHopSize: 1024, measuresHarmonicContinuity: false)
+
+    static let balanced = AnalysisConfiguration(name: "balanced")
+
+    /// Twice the feature density and a search that keeps most ranked pairs
+    static let thorough = AnalysisConfiguration(name: "thorough", hopSize: 2048, coarseContextFrames: 16,
+                                                coarseSurvivorCount: 256, refinedSurvivorCount: 48,
+                                                refinementHopSize: 256)
+
+    static let presets: [AnalysisConfiguration] = [.fast, .balanced, .thorough]
+
+    /// The preset with this name, if any
+    static func preset(named name: String) -> AnalysisConfiguration? {
+        return presets.first { $0.name == name.lowercased() }
+    }
+
+    /**
+     * Short stable hash of every setting, so results from differently
+     * configured analyses never share a cache entry.
+     */
+    var fingerprint: String {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = .sortedKeys
+        guard let data = try? encoder.encode(self) else { return name }
+
+        var hash: UInt64 = 0xcbf29ce484222325
+        for byte in data {
+            hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+        }
+        return String(hash, radix: 16)
+    }
+}
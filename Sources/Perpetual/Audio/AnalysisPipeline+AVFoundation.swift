@@ -0,0 +1,67 @@
+#if canImport(AVFoundation)
+import AVFoundation
+
+extension AnalysisPipeline {
+    /**
+     * Analyzes a file, decoding it front to back exactly once. The pipeline
+     * opens its own AVAudioFile, used only on the decode queue.
+     *
+     * - Returns: nil if the file can't be opened or its format can't be buffered
+     */
+    convenience init?(url: URL, chunkFrames: Int = AnalysisPipeline.defaultChunkFrames,
+                      slotCount: Int = AnalysisPipeline.defaultSlotCount) {
+        guard let file = try? AVAudioFile(forReading: url),
+              let scratch = AVAudioPCMBuffer(pcmFormat: file.processingFormat,
+                                             frameCapacity: AVAudioFrameCount(chunkFrames)),
+              scratch.floatChannelData != nil else { return nil }
+
+        let channelCount = Int(file.processingFormat.channelCount)
+
+        self.init(channelCount: channelCount,
+                  frameCount: Int(file.length),
+                  sampleRate: file.processingFormat.sampleRate,
+                  decoder: { startFrame, frameCount, destination in
+                      do {
+                          // Chunks arrive in order, so this only seeks on the first one
+                          if file.framePosition != AVAudioFramePosition(startFrame) {
+                              file.framePosition = AVAudioFramePosition(startFrame)
+                          }
+                          try file.read(into: scratch, frameCount: AVAudioFrameCount(min(frameCount, chunkFrames)))
+                      } catch {
+                          print("Failed to decode analysis chunk at frame \(startFrame): \(error)")
+                          return 0
+                      }
+
+                      guard let source = scratch.floatChannelData else { return 0 }
+                      let decoded = Int(scratch.frameLength)
+                      for channel in 0..<channelCount {
+                          destination[channel].update(from: source[channel], count: decoded)
+                      }
+                      return decoded
+                  },
+                  chunkFrames: chunkFrames,
+                  slotCount: slotCount)
+    }
+}
+
+extension LoudnessAccumulator {
+    /**
+     * Measures a file's loudness in one decode pass.
+     *
+     * - Parameter shouldContinue: Polled per chunk; returning false abandons the pass
+     * - Returns: nil if the file can't be opened or the pass was abandoned
+     */
+    static func measure(url: URL, shouldContinue: @escaping () -> Bool = { true }) -> Measurement? {
+        guard let pipeline = AnalysisPipeline(url: url) else { return nil }
+        let accumulator = LoudnessAccumulator()
+        pipeline.add(accumulator)
+
+        do {
+            try pipeline.run { _ in shouldContinue() }
+        } catch {
+            return nil
+        }
+        return accumulator.measurement
+    }
+}
+#endif
@@ -0,0 +1,270 @@
+import Foundation
+import PerpetualCore
+
+/**
+ * AnalysisConsumer
+ *
+ * One stage fed by the analysis pipeline. Consumers see every chunk exactly
+ * once, in order, and keep only the state they need between chunks, so none
+ * of them has to hold the whole file.
+ */
+protocol AnalysisConsumer: AnyObject {
+    /// Called once before the first chunk
+    func begin(sampleRate: Double, channelCount: Int, frameCount: Int)
+
+    /// Called for each chunk in order; never concurrently with itself
+    func consume(_ chunk: AnalysisPipeline.Chunk)
+
+    /// Called after the last chunk
+    func finish()
+}
+
+/**
+ * AnalysisPipeline
+ *
+ * Decodes a file once, in fixed-size chunks, and hands every chunk to all
+ * registered consumers (waveform pyramid, feature table, loudness, repeat
+ * hasher, ...). Decoding runs on its own queue a few chunks ahead of the
+ * consumers, and the consumers of a chunk run in parallel, so analysis
+ * overlaps decoding and the whole run takes about as long as the slowest
+ * of decode and the heaviest consumer.
+ *
+ * Memory is the chunk ring (`slotCount` × `chunkFrames` frames) plus
+ * whatever the consumers keep.
+ */
+final class AnalysisPipeline {
+    /// A decoded chunk, valid only for the duration of `consume`
+    struct Chunk {
+        /// First frame of the chunk in the file
+        let startFrame: Int
+
+        /// Frames in the chunk
+        let frameCount: Int
+
+        /// De-interleaved channel pointers
+        let channels: UnsafePointer<UnsafeMutablePointer<Float>>
+        let channelCount: Int
+
+        /// Samples of one channel
+        func samples(_ channel: Int) -> UnsafePointer<Float> {
+            return UnsafePointer(channels[channel])
+        }
+    }
+
+    /// Errors specific to the pipeline
+    enum PipelineError: Error, LocalizedError {
+        case cancelled
+        case decodeFailed(frame: Int)
+
+        var errorDescription: String? {
+            switch self {
+            case .cancelled:
+                return "Analysis was cancelled"
+            case .decodeFailed(let frame):
+                return "Failed to decode audio at frame \(frame)"
+            }
+        }
+    }
+
+    /// Default chunk length in frames
+    static let defaultChunkFrames = 65536
+
+    /// Chunks decoded ahead of the consumers
+    static let defaultSlotCount = 4
+
+    let channelCount: Int
+    let frameCount: Int
+    let sampleRate: Double
+    let chunkFrames: Int
+
+    /// Chunks that may be decoded ahead of the consumers
+    let slotCount: Int
+
+    private let decoder: StreamedPCM.Decoder
+    private var consumers: [AnalysisConsumer] = []
+
+    /**
+     * - Parameters:
+     *   - decoder: Decodes sequential chunks; called on the decode queue only
+     *   - chunkFrames: Frames per chunk
+     *   - slotCount: Chunks that may be decoded ahead of the consumers
+     */
+    init(channelCount: Int, frameCount: Int, sampleRate: Double,
+         decoder: @escaping StreamedPCM.Decoder,
+         chunkFrames: Int = AnalysisPipeline.defaultChunkFrames,
+         slotCount: Int = AnalysisPipeline.defaultSlotCount) {
+        self.channelCount = max(1, channelCount)
+        self.frameCount = max(0, frameCount)
+        self.sampleRate = sampleRate
+        self.decoder = decoder
+        self.chunkFrames = max(1, chunkFrames)
+        self.slotCount = max(2, slotCount)
+    }
+
+    /// Adds a consumer; all consumers must be added before `run`
+    func add(_ consumer: AnalysisConsumer) {
+        consumers.append(consumer)
+    }
+
+    /**
+     * Decodes the whole file and feeds every chunk to the consumers.
+     * Blocking; call off the main thread.
+     *
+     * - Parameter progress: Called after each chunk with 0...1; return false to cancel
+     * - Throws: PipelineError
+     */
+    func run(progress: ((Double) -> Bool)? = nil) throws {
+        let slotSamples = chunkFrames * channelCount
+        let storage = UnsafeMutablePointer<Float>.allocate(capacity: slotSamples * slotCount)
+        let tables = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: channelCount * slotCount)
+        defer {
+            storage.deallocate()
+            tables.deallocate()
+        }
+        for slot in 0..<slotCount {
+            for channel in 0..<channelCount {
+                (tables + slot * channelCount + channel)
+                    .initialize(to: storage + slot * slotSamples + channel * chunkFrames)
+            }
+        }
+
+        // Slots cycle decode → consume → decode; the semaphores order every hand-off
+        let free = DispatchSemaphore(value: slotCount)
+        let filled = DispatchSemaphore(value: 0)
+        let decodedFrames = UnsafeMutablePointer<Int>.allocate(capacity: slotCount)
+        decodedFrames.initialize(repeating: 0, count: slotCount)
+        defer { decodedFrames.deallocate() }
+
+        let cancelLock = NSLock()
+        var isCancelled = false
+
+        // A semaphore must be back at its starting value when it is freed, so
+        // waits and signals on `free` are counted and evened up at the end
+        var freeWaits = 0
+        var freeSignals = 0
+        let chunkCount = (frameCount + chunkFrames - 1) / chunkFrames
+        let decoder = self.decoder
+        let chunkFrames = self.chunkFrames
+        let channelCount = self.channelCount
+        let frameCount = self.frameCount
+        let slotCount = self.slotCount
+        let finished = DispatchGroup()
+
+        DispatchQueue.global(qos: .userInitiated).async(group: finished) {
+            for chunk in 0..<chunkCount {
+                free.wait()
+                freeWaits += 1
+                cancelLock.lock()
+                let stop = isCancelled
+                cancelLock.unlock()
+
+                let slot = chunk % slotCount
+                let startFrame = chunk * chunkFrames
+                let wanted = min(chunkFrames, frameCount - startFrame)
+                let decoded = stop ? 0 : decoder(startFrame, wanted, tables + slot * channelCount)
+                decodedFrames[slot] = min(decoded, wanted)
+                filled.signal()
+
+                if stop || decoded <= 0 {
+                    return
+                }
+            }
+        }
+
+        for consumer in consumers {
+            consumer.begin(sampleRate: sampleRate, channelCount: channelCount, frameCount: frameCount)
+        }
+
+        var failure: PipelineError?
+        var processed = 0
+
+        for chunk in 0..<chunkCount {
+            filled.wait()
+            let slot = chunk % slotCount
+            let frames = decodedFrames[slot]
+            guard frames > 0 else {
+                failure = .decodeFailed(frame: chunk * chunkFrames)
+                break
+            }
+
+            let block = Chunk(startFrame: chunk * chunkFrames,
+                              frameCount: frames,
+                              channels: tables + slot * channelCount,
+                              channelCount: channelCount)
+
+            // Consumers are independent; run them side by side on the same chunk
+            let consumers = self.consumers
+            DispatchQueue.concurrentPerform(iterations: consumers.count) { index in
+                consumers[index].consume(block)
+            }
+
+            processed += frames
+            free.signal()
+            freeSignals += 1
+
+            if let progress = progress, !progress(Double(processed) / Double(max(1, frameCount))) {
+                failure = .cancelled
+                break
+            }
+        }
+
+        if failure != nil {
+            // Unblock the decoder so it can see the cancellation and exit
+            cancelLock.lock()
+            isCancelled = true
+            cancelLock.unlock()
+            free.signal()
+            freeSignals += 1
+        }
+        finished.wait()
+
+        // The decoder has exited; return the slots it was still holding
+        while freeSignals < freeWaits {
+            free.signal()
+            freeSignals += 1
+        }
+
+        if let failure = failure {
+            throw failure
+        }
+
+        for consumer in consumers {
+            consumer.finish()
+        }
+    }
+}
+
+/**
+ * ChannelCapture
+ *
+ * Copies one channel into caller-owned memory, for stages that still need
+ * random access to the samples after the pipeline has run.
+ */
+final class ChannelCapture: AnalysisConsumer {
+    private let channel: Int
+    private let destination: UnsafeMutablePointer<Float>
+    private let capacity: Int
+
+    /// Frames copied so far
+    private(set) var capturedFrames = 0
+
+    init(channel: Int, into destination: UnsafeMutablePointer<Float>, capacity: Int) {
+        self.channel = channel
+        self.destination = destination
+        self.capacity = capacity
+    }
+
+    func begin(sampleRate: Double, channelCount: Int, frameCount: Int) {
+        capturedFrames = 0
+    }
+
+    func consume(_ chunk: AnalysisPipeline.Chunk) {
+        let count = min(chunk.frameCount, capacity - chunk.startFrame)
+        guard count > 0 else { return }
+        let source = chunk.samples(min(channel, chunk.channelCount - 1))
+        (destination + chunk.startFrame).update(from: source, count: count)
+        capturedFrames = chunk.startFrame + count
+    }
+
+    func finish() {}
+}
@@ -0,0 +1,319 @@
+import AVFoundation
+
+/**
+ * AnalysisScheduler
+ *
+ * Admits analysis jobs by priority under a memory budget and a concurrency
+ * limit. A full structure analysis holds the mono PCM and an N×N similarity
+ * matrix (twice), so its footprint grows with the square of track length;
+ * jobs declare an estimate up front and wait until it fits.
+ *
+ * Higher priorities go first. When a job can't be admitted, running jobs of
+ * lower priority are preempted: their tasks are cancelled (the analyzer
+ * checks between phases) and they are re-queued to start over once there is
+ * room. Concurrency stays below the core count so the render thread and the
+ * UI always have a core to run on.
+ */
+final class AnalysisScheduler {
+    /// Who is waiting on a job, most urgent last
+    enum Priority: Int, Comparable {
+        /// Filling in the library index
+        case backfill
+
+        /// Preparing a queued track
+        case preload
+
+        /// The track on screen
+        case foreground
+
+        static func < (lhs: Priority, rhs: Priority) -> Bool {
+            return lhs.rawValue < rhs.rawValue
+        }
+
+        /// Task priority the job runs at
+        var taskPriority: TaskPriority {
+            switch self {
+            case .backfill:
+                return .background
+            case .preload:
+                return .utility
+            case .foreground:
+                return .userInitiated
+            }
+        }
+    }
+
+    /// Whether a job builds the self-similarity matrix
+    enum MatrixMode {
+        /// Streaming measurements only (loudness, waveform)
+        case none
+
+        /// Full structure analysis: dense matrix plus its enhanced copy
+        case full
+    }
+
+    static let shared = AnalysisScheduler()
+
+    /// Most memory admitted jobs may hold together, in bytes
+    let memoryBudget: Int
+
+    /// Most jobs running at once
+    let maxConcurrentJobs: Int
+
+    /// One request to run, waiting or admitted
+    private final class Ticket {
+        let priority: Priority
+        let bytes: Int
+        let sequence: Int
+
+        /// Resumed with true when admitted, false if the caller gave up waiting
+        var continuation: CheckedContinuation<Bool, Never>?
+        var isCancelled = false
+
+        /// Set when the scheduler wants the running job to stop
+        var isPreempted = false
+        var preempt: (() -> Void)?
+
+        init(priority: Priority, bytes: Int, sequence: Int) {
+            self.priority = priority
+            self.bytes = bytes
+            self.sequence = sequence
+        }
+    }
+
+    private let lock = NSLock()
+    private var waiting: [Ticket] = []
+    private var running: [Ticket] = []
+    private var reservedBytes = 0
+    private var nextSequence = 0
+
+    /**
+     * - Parameters:
+     *   - memoryBudget: Bytes admitted jobs may hold (defaults to a quarter of physical memory)
+     *   - maxConcurrentJobs: Jobs run at once (defaults to half the cores)
+     */
+    init(memoryBudget: Int = Int(ProcessInfo.processInfo.physicalMemory / 4),
+         maxConcurrentJobs: Int = max(1, ProcessInfo.processInfo.activeProcessorCount / 2)) {
+        self.memoryBudget = max(1, memoryBudget)
+        self.maxConcurrentJobs = max(1, maxConcurrentJobs)
+    }
+
+    // MARK: - Footprint
+
+    /**
+     * Estimated peak memory of analyzing a track.
+     *
+     * The pipeline's slot ring is fixed; a full analysis adds the captured
+     * first channel and two N×N float matrices, N being one feature per
+     * `featureHop` frames.
+     */
+    static func footprint(duration: TimeInterval, sampleRate: Double, channelCount: Int,
+                          matrixMode: MatrixMode,
+                          featureHop: Int = AnalysisConfiguration.balanced.featureHop) -> Int {
+        let floatSize = MemoryLayout<Float>.size
+        let slots = AnalysisPipeline.defaultChunkFrames * AnalysisPipeline.defaultSlotCount * channelCount * floatSize
+        let frames = Int(duration * sampleRate)
+
+        switch matrixMode {
+        case .none:
+            return slots
+        case .full:
+            let featureCount = frames / max(1, featureHop) + 1
+            return slots + frames * floatSize + 2 * featureCount * featureCount * floatSize
+        }
+    }
+
+    /// Estimated peak memory of analyzing a file, from its header
+    static func footprint(of url: URL, matrixMode: MatrixMode,
+                          featureHop: Int = AnalysisConfiguration.balanced.featureHop) -> Int? {
+        guard let file = try? AVAudioFile(forReading: url) else { return nil }
+        let format = file.processingFormat
+        return footprint(duration: Double(file.length) / format.sampleRate, sampleRate: format.sampleRate,
+                         channelCount: Int(format.channelCount), matrixMode: matrixMode, featureHop: featureHop)
+    }
+
+    // MARK: - Running Jobs
+
+    /**
+     * Runs `operation` once the scheduler admits it. If it is preempted by
+     * a more urgent job it is re-queued and run again from the start, so the
+     * caller only ever sees a finished result, its own cancellation, or a
+     * real error.
+     *
+     * - Parameters:
+     *   - priority: Who is waiting on the result
+     *   - bytes: Estimated peak memory (clamped to the budget, so oversized jobs run alone)
+     *   - operation: The job; should stop promptly when its task is cancelled
+     */
+    func run<T>(priority: Priority, footprint bytes: Int,
+                operation: @escaping () async throws -> T) async throws -> T {
+        while true {
+            let ticket = makeTicket(priority: priority, bytes: min(max(0, bytes), memoryBudget))
+            guard await admit(ticket) else { throw CancellationError() }
+
+            let work = Task(priority: priority.taskPriority) {
+                try await operation()
+            }
+            setPreemptionHandler(of: ticket) {
+                work.cancel()
+            }
+
+            let result = await withTaskCancellationHandler {
+                await work.result
+            } onCancel: {
+                work.cancel()
+            }
+
+            let wasPreempted = release(ticket)
+            if wasPreempted, case .failure = result, !Task.isCancelled {
+                continue
+            }
+            return try result.get()
+        }
+    }
+
+    private func makeTicket(priority: Priority, bytes: Int) -> Ticket {
+        lock.lock()
+        defer { lock.unlock() }
+        nextSequence += 1
+        return Ticket(priority: priority, bytes: bytes, sequence: nextSequence)
+    }
+
+    /**
+     * Waits in line until the ticket fits. Returns false if the calling task
+     * is cancelled first.
+     */
+    private func admit(_ ticket: Ticket) async -> Bool {
+        return await withTaskCancellationHandler {
+            await withCheckedContinuation { (continuation: CheckedContinuation<Bool, Never>) in
+                lock.lock()
+                guard !ticket.isCancelled else {
+                    lock.unlock()
+                    continuation.resume(returning: false)
+                    return
+                }
+                ticket.continuation = continuation
+                waiting.append(ticket)
+                let actions = schedule()
+                lock.unlock()
+                actions()
+            }
+        } onCancel: {
+            lock.lock()
+            ticket.isCancelled = true
+            var abandoned: CheckedContinuation<Bool, Never>?
+            if let index = waiting.firstIndex(where: { $0 === ticket }) {
+                waiting.remove(at: index)
+                abandoned = ticket.continuation
+                ticket.continuation = nil
+            }
+            let actions = schedule()
+            lock.unlock()
+            abandoned?.resume(returning: false)
+            actions()
+        }
+    }
+
+    /// Installs how to stop an admitted job, stopping it at once if it was already preempted
+    private func setPreemptionHandler(of ticket: Ticket, _ handler: @escaping () -> Void) {
+        lock.lock()
+        ticket.preempt = handler
+        let preemptNow = ticket.isPreempted
+        lock.unlock()
+
+        if preemptNow {
+            handler()
+        }
+    }
+
+    /// Returns a finished job's memory and slot; reports whether it was preempted
+    private func release(_ ticket: Ticket) -> Bool {
+        lock.lock()
+        if let index = running.firstIndex(where: { $0 === ticket }) {
+            running.remove(at: index)
+            reservedBytes -= ticket.bytes
+        }
+        let actions = schedule()
+        let wasPreempted = ticket.isPreempted
+        lock.unlock()
+
+        actions()
+        return wasPreempted
+    }
+
+    /**
+     * Admits waiting jobs in priority order while they fit. The first job
+     * that doesn't fit blocks everything behind it, so a large urgent job
+     * isn't starved by small ones; if lower-priority jobs are running it
+     * preempts enough of them to make room.
+     *
+     * Called with the lock held. Returns the resumptions and cancellations
+     * to perform once it is released.
+     */
+    private func schedule() -> () -> Void {
+        waiting.sort { $0.priority != $1.priority ? $0.priority > $1.priority : $0.sequence < $1.sequence }
+
+        var admitted: [CheckedContinuation<Bool, Never>] = []
+        var preempted: [() -> Void] = []
+
+        while let next = waiting.first {
+            if running.count < maxConcurrentJobs && reservedBytes + next.bytes <= memoryBudget {
+                waiting.removeFirst()
+                running.append(next)
+                reservedBytes += next.bytes
+                if let continuation = next.continuation {
+                    admitted.append(continuation)
+                }
+                next.continuation = nil
+                continue
+            }
+
+            // Make room by stopping the least urgent, most recently started jobs below it
+            let victims = running
+                .filter { $0.priority < next.priority && !$0.isPreempted }
+                .sorted { $0.priority != $1.priority ? $0.priority < $1.priority : $0.sequence > $1.sequence }
+            let pendingBytes = running.filter { $0.isPreempted }.reduce(0) { $0 + $1.bytes }
+            var freedSlots = running.filter { $0.isPreempted }.count
+            var freedBytes = pendingBytes
+
+            for victim in victims {
+                if running.count - freedSlots < maxConcurrentJobs
+                    && reservedBytes - freedBytes + next.bytes <= memoryBudget {
+                    break
+                }
+                victim.isPreempted = true
+                if let handler = victim.preempt {
+                    preempted.append(handler)
+                }
+                freedSlots += 1
+                freedBytes += victim.bytes
+            }
+            break
+        }
+
+        return {
+            admitted.forEach { $0.resume(returning: true) }
+            preempted.forEach { $0() }
+        }
+    }
+}
+
+// MARK: - Structure Analysis
+
+extension MusicStructureAnalyzer {
+    /**
+     * Runs a full analysis through the shared scheduler, waiting for room if
+     * other analyses are holding the memory budget.
+     *
+     * - Parameters:
+     *   - url: The URL of the audio file to analyze
+     *   - priority: Who is waiting on the result
+     */
+    func analyzeAudioFile(_ url: URL, priority: AnalysisScheduler.Priority) async throws {
+        let scheduler = AnalysisScheduler.shared
+        let bytes = AnalysisScheduler.footprint(of: url, matrixMode: .full, featureHop: configuration.featureHop) ?? 0
+        try await scheduler.run(priority: priority, footprint: bytes) {
+            try await self.analyzeAudioFile(url)
+        }
+    }
+}
@@ -1,25 +1,57 @@
 import AVFoundation
+import Atomics
 import Combine
+import PerpetualCore
 
 /**
  * AudioManager
  *
  * A class responsible for audio playback with seamless, sample-accurate looping.
- * Uses AVAudioEngine and buffer-based playback to achieve perfect loops without
- * audible gaps or artifacts at loop points.
+ * Playback is pulled through a `LoopRenderer`, which reads the resident buffer
+ * in place via an `AVAudioSourceNode`, so loop points and region transitions
+ * land on exact sample boundaries with no buffer copies. Very long files are
+ * streamed through a fixed ring of decoded chunks instead of being loaded whole.
  *
  * Key features:
  * - Sample-accurate loop point control
- * - Buffer-based playback for seamless transitions
+ * - Pull-model rendering from a single resident buffer
  * - High-precision position tracking
  * - Support for infinite or counted loops
+ * - Multi-region segment graph playback
+ * - Gapless play queue with background preload and pre-analysis
  */
 class AudioManager: ObservableObject {
     /// The core audio processing engine
     private let audioEngine = AVAudioEngine()
     
-    /// Node responsible for audio playback
-    private let playerNode = AVAudioPlayerNode()
+    /// Render core for the loaded file
+    private var renderer: LoopRenderer?
+    
+    /// Deck hosting the renderer, with the next queued track armed behind it
+    private var deck: PlaybackDeck?
+    
+    /// Source node pulling from the deck
+    private var sourceNode: AVAudioSourceNode?
+    
+    /// Chunk-ring source when the current file is streamed rather than resident
+    private var streamedPCM: StreamedPCM?
+    
+    /// Files longer than this are streamed instead of read into memory
+    static let residentDurationLimit: TimeInterval = 20 * 60
+    
+    /// How far ahead of the play position a streamed file is decoded
+    private static let prefetchDuration: TimeInterval = 3
+    
+    /// Renderer and node playing pre-rendered seam clips
+    private var auditionRenderer: LoopRenderer?
+    private var auditionNode: AVAudioSourceNode?
+    private var auditionBank: SeamAuditioner.Bank?
+    
+    /// Incremented per audition request so stale clip banks are dropped
+    private var auditionGeneration = 0
+    
+    /// Set on the main thread to cancel the running export; read by the export thread
+    private let isExportCancelled = ManagedAtomic<Bool>(false)
     
     /// Reference to the currently loaded audio file
     private var _audioFile: AVAudioFile?
@@ -49,13 +81,32 @@ class AudioManager: ObservableObject {
     @Published var duration: TimeInterval = 0
     
     /// Start point of the loop in seconds
-    @Published var loopStartTime: TimeInterval = 0
+    @Published var loopStartTime: TimeInterval = 0 {
+        didSet {
+            if loopStartTime != oldValue && !isUpdatingLoopPoints {
+                sendLoopPoints(timing: .nextSeam)
+            }
+        }
+    }
     
     /// End point of the loop in seconds
-    @Published var loopEndTime: TimeInterval = 0
+    @Published var loopEndTime: TimeInterval = 0 {
+        didSet {
+            if loopEndTime != oldValue && !isUpdatingLoopPoints {
+                sendLoopPoints(timing: .nextSeam)
+            }
+        }
+    }
     
     /// Number of times to repeat the loop (0 = infinite)
-    @Published var loopCount: Int = 0
+    @Published var loopCount: Int = 0 {
+        didSet {
+            if loopCount != oldValue {
+                refreshLoopGraph()
+                armNextTrack()
+            }
+        }
+    }
     
     /// Current iteration of the loop during playback
     @Published var currentLoopIteration: Int = 0
@@ -63,10 +114,94 @@ class AudioManager: ObservableObject {
     /// Most recent error encountered during file operations
     @Published var lastError: Error?
     
+    /// Segment graph being played, if custom graph playback is active
+    @Published private(set) var segmentGraph: SegmentGraph?
+    
+    /// Name of the graph region currently playing
+    @Published var currentRegionName: String?
+    
+    /// Candidates whose seam clips are rendered and ready to audition
+    @Published private(set) var auditionReadyIDs: Set<UUID> = []
+    
+    /// Candidate whose seam is being auditioned
+    @Published private(set) var auditioningCandidateID: UUID?
+    
+    /// Progress of the running export (nil = no export running)
+    @Published private(set) var exportProgress: Double?
+    
+    /// Live meters of what the renderer is playing
+    let levelMeter = LevelMeter()
+    
+    /// Seam quality of the loop handles while they are dragged
+    let seamScorer = LiveSeamScorer()
+    
+    /// Whether the audio engine is running (it starts on first play and sleeps when idle)
+    @Published private(set) var isEngineRunning = false
+    
+    /// Time from the last play request to the first rendered frame
+    @Published private(set) var lastStartLatency: TimeInterval?
+    
+    /// Whether the last start had to wake the engine first
+    @Published private(set) var lastStartWokeEngine = false
+    
+    /// EBU R128 loudness of the loaded track, once measured
+    @Published private(set) var loudness: LoudnessAccumulator.Measurement?
+    
+    /// Gain the renderer applies to reach `normalizationTarget` (linear)
+    @Published private(set) var normalizationGain: Float = 1
+    
+    /// Whether tracks are played at a common loudness
+    @Published var isLoudnessNormalized = true {
+        didSet {
+            applyNormalizationGain()
+        }
+    }
+    
+    /// Loudness every track is brought to when normalizing, in LUFS
+    @Published var normalizationTarget: Float = LoudnessAccumulator.defaultTarget {
+        didSet {
+            applyNormalizationGain()
+        }
+    }
+    
+    /// Tracks waiting to play after the current one, in order
+    @Published private(set) var queue: [QueuedTrack] = []
+    
+    /// Queued tracks that are decoded and resolved, ready to start instantly
+    @Published private(set) var readyTrackIDs: Set<UUID> = []
+    
+    /// Memory held by preloaded resident tracks, in bytes
+    @Published private(set) var preloadedBytes = 0
+    
+    /// How many upcoming tracks are prepared ahead of time
+    var preloadCount = 2 {
+        didSet {
+            refreshQueue()
+        }
+    }
+    
+    /// Most memory preloaded tracks may hold; tracks that don't fit are streamed
+    var preloadMemoryBudget = 512 * 1024 * 1024 {
+        didSet {
+            refreshQueue()
+        }
+    }
+    
+    /// Seconds paused or stopped before the engine is suspended (nil = never suspend)
+    var idleSuspendInterval: TimeInterval? = 30 {
+        didSet {
+            if !isPlaying {
+                scheduleIdleSuspend()
+            }
+        }
+    }
+    
     // MARK: - Private Properties
     
-    /// Buffer containing the entire audio file for seamless looping
-    private var audioBuffer: AVAudioPCMBuffer?
+    /// Buffer containing the entire audio file for seamless looping (nil when streamed)
+    private var audioBuffer: AVAudioPCMBuffer? {
+        didSet { seamScorer.attach(audioBuffer) }
+    }
     
     /// Provides access to the audio buffer for analysis
     var getPCMBuffer: AVAudioPCMBuffer? {
@@ -76,20 +211,45 @@ class AudioManager: ObservableObject {
     /// Sample rate of the loaded audio file
     private var sampleRate: Double = 44100
     
-    /// Timer for tracking playback position
+    /// Timer for tracking playback position and refreshing the meters
     private var positionTimer: Timer?
     
-    /// Reference time when playback started
-    private var playbackStartTime: TimeInterval = 0
+    /// Position and meter refresh interval; display rate is all the UI can show
+    private static let displayInterval: TimeInterval = 1.0 / 30
+    
+    /// One-shot timer that suspends the engine after `idleSuspendInterval`
+    private var idleTimer: Timer?
+    
+    /// Uptime of the play request whose first rendered frame hasn't been seen yet
+    private var startRequestUptime: UInt64?
+    
+    /// Incremented per load so a late loudness measurement can't apply to another track;
+    /// the measurement checks it off the main thread
+    private let loudnessGeneration = ManagedAtomic<Int>(0)
+    
+    /// Queued tracks that finished preparing, and the ones still being prepared
+    private var preparedTracks: [UUID: PreparedTrack] = [:]
+    private var preparationTasks: [UUID: Task<Void, Never>] = [:]
     
-    /// Time position when playback was paused
-    private var pausedTime: TimeInterval = 0
+    /// Bytes set aside for each preload that decodes resident
+    private var preloadReservations: [UUID: Int] = [:]
     
-    /// Most recent loop start time for position calculations
-    private var lastLoopStartTime: TimeInterval = 0
+    /// Next track's renderer, armed on the deck to follow the current one
+    private var armedTrack: (id: UUID, renderer: LoopRenderer, loopCount: Int)?
     
-    /// System time when playback started/resumed
-    private var systemStartTime: CFTimeInterval = 0
+    /// Deck hand-offs already adopted by the main thread
+    private var observedHandoffs = 0
+    
+    /// Whether playback is paused (renderer keeps its place)
+    private var isPaused = false
+    
+    /// Set while `setLoopPoints` assigns both points, so they're sent once
+    private var isUpdatingLoopPoints = false
+    
+    /// Whether the loop points describe a region to repeat
+    private var hasLoopRegion: Bool {
+        return loopEndTime > loopStartTime && (loopStartTime > 0 || loopEndTime < duration)
+    }
     
     // MARK: - Error Types
     
@@ -124,6 +284,7 @@ class AudioManager: ObservableObject {
     
     /**
      * Initializes the AudioManager and sets up the audio engine.
+     * The engine itself isn't started until something plays.
      */
     init() {
         setupAudioEngine()
@@ -134,42 +295,120 @@ class AudioManager: ObservableObject {
      */
     deinit {
         positionTimer?.invalidate()
+        idleTimer?.invalidate()
+        preparationTasks.values.forEach { $0.cancel() }
         audioEngine.stop()
     }
     
     // MARK: - Audio Engine Setup
     
     /**
-     * Configures the audio engine and connects components.
-     * Sets up the signal chain and starts the audio engine.
-     *
-     * - Throws: AudioManagerError if engine fails to start
+     * Configures the audio engine's output chain.
+     * Source nodes are attached per file once the format is known; the engine
+     * is started by `startEngineIfNeeded()` on demand.
      */
     private func setupAudioEngine() {
-        // Connect audio components
-        audioEngine.attach(playerNode)
-        audioEngine.connect(playerNode, to: audioEngine.mainMixerNode, format: nil)
+        // Touch the mixer so the engine has a complete output chain before starting
+        _ = audioEngine.mainMixerNode
+    }
+    
+    /**
+     * Starts (or wakes) the audio engine if it isn't running and cancels any
+     * pending idle suspension.
+     *
+     * - Returns: Whether the engine is running
+     */
+    @discardableResult
+    private func startEngineIfNeeded() -> Bool {
+        idleTimer?.invalidate()
+        idleTimer = nil
         
-        // Configure for low latency
-        audioEngine.mainMixerNode.outputFormat(forBus: 0)
+        guard !audioEngine.isRunning else { return true }
         
-        // Start the engine
         do {
             try audioEngine.start()
+            isEngineRunning = true
+            return true
         } catch {
             lastError = AudioManagerError.engineStartFailed(error)
             print("Failed to start audio engine: \(error)")
+            return false
         }
     }
     
+    /**
+     * Arms the idle timer while nothing is playing. Stopping the engine
+     * releases the output device and its I/O thread, so an idle app costs
+     * nothing until the next play.
+     */
+    private func scheduleIdleSuspend() {
+        idleTimer?.invalidate()
+        idleTimer = nil
+        
+        guard let interval = idleSuspendInterval, audioEngine.isRunning else { return }
+        
+        idleTimer = Timer.scheduledTimer(withTimeInterval: interval, repeats: false) { [weak self] _ in
+            self?.suspendEngineIfIdle()
+        }
+        // The exact moment doesn't matter; let the system coalesce the wake-up
+        idleTimer?.tolerance = interval * 0.2
+    }
+    
+    /**
+     * Stops the engine if nothing has started playing since the idle timer was armed.
+     * Renderers keep their place, so a paused track resumes where it was.
+     */
+    private func suspendEngineIfIdle() {
+        idleTimer = nil
+        guard !isPlaying, auditioningCandidateID == nil, audioEngine.isRunning else { return }
+        
+        audioEngine.stop()
+        isEngineRunning = false
+    }
+    
+    /**
+     * Replaces the renderer, its deck and the deck's source node for a newly
+     * loaded source.
+     */
+    private func installRenderer(for pcm: PCMSource) throws {
+        let newRenderer = makeRenderer(for: pcm)
+        let newDeck = PlaybackDeck(channelCount: pcm.channelCount, sampleRate: pcm.sampleRate)
+        guard let node = newDeck.makeSourceNode() else {
+            throw AudioManagerError.invalidFormat
+        }
+        
+        if let oldNode = sourceNode {
+            audioEngine.detach(oldNode)
+        }
+        
+        audioEngine.attach(node)
+        audioEngine.connect(node, to: audioEngine.mainMixerNode, format: newDeck.outputFormat)
+        newDeck.play(newRenderer)
+        
+        deck = newDeck
+        sourceNode = node
+        armedTrack = nil
+        observedHandoffs = 0
+        renderer = newRenderer
+        levelMeter.attach(to: newRenderer.meterRing, sampleRate: pcm.sampleRate)
+        armNextTrack()
+    }
+    
+    /// A renderer for `pcm` with a meter tap
+    private func makeRenderer(for pcm: PCMSource) -> LoopRenderer {
+        // Half a second of metering headroom covers a few missed display frames
+        return LoopRenderer(pcm: pcm, meterCapacity: Int(pcm.sampleRate / 2))
+    }
+    
     // MARK: - File Loading
     
     /**
      * Loads an audio file into memory for playback.
      *
      * Reads the entire audio file into a buffer to enable seamless looping.
-     * This approach ensures no gaps occur at loop points by allowing precise 
-     * buffer scheduling.
+     * The renderer reads this buffer in place, so no gaps occur at loop points.
+     * Files longer than `residentDurationLimit` are streamed instead, so their
+     * playback memory stays constant.
      *
      * - Parameter url: The URL of the audio file to load
      * - Throws: AudioManagerError if file cannot be loaded, buffer creation fails,
@@ -183,6 +422,10 @@ class AudioManager: ObservableObject {
             // Create audio file object
             let file = try AVAudioFile(forReading: url)
             
+            // Release the previous file's playback state
+            stop()
+            releaseAudition()
+            
             // Check that file has valid frame count
             let frameCount = file.length
             guard frameCount > 0 else {
@@ -196,6 +439,28 @@ class AudioManager: ObservableObject {
             sampleRate = file.processingFormat.sampleRate
             duration = Double(frameCount) / sampleRate
             
+            audioBuffer = nil
+            streamedPCM = nil
+            
+            if duration > AudioManager.residentDurationLimit {
+                guard let streamed = StreamedPCM(url: url) else {
+                    throw AudioManagerError.invalidFormat
+                }
+                streamedPCM = streamed
+                try installRenderer(for: streamed)
+                prepareNormalization(for: url)
+                
+                // Decode the opening chunks before the first play
+                streamed.prefetch([0..<Int(AudioManager.prefetchDuration * sampleRate)])
+                
+                DispatchQueue.main.async {
+                    self.loopEndTime = self.duration
+                    self.currentTime = 0
+                    self.currentLoopIteration = 0
+                }
+                return
+            }
+            
             // Create buffer with capacity for entire file
             guard let buffer = AVAudioPCMBuffer(pcmFormat: file.processingFormat, 
                                               frameCapacity: UInt32(frameCount)) else {
@@ -207,8 +472,13 @@ class AudioManager: ObservableObject {
             try file.read(into: buffer)
             buffer.frameLength = UInt32(frameCount)
             
-            // Store buffer for playback
+            // Store buffer for playback and hand it to a fresh renderer
+            guard let pcm = ResidentPCM(buffer: buffer) else {
+                throw AudioManagerError.invalidFormat
+            }
             audioBuffer = buffer
+            try installRenderer(for: pcm)
+            prepareNormalization(for: url)
             
             // Update UI-related properties on main thread
             DispatchQueue.main.async {
@@ -233,34 +503,43 @@ class AudioManager: ObservableObject {
     /**
      * Starts or resumes audio playback.
      *
-     * If loop points are set, playback will start from the loop start point.
-     * Otherwise, it starts from the current position or the beginning if at 0.
+     * A paused track resumes where it left off. Otherwise, if loop points are
+     * set, playback starts from the loop start point; if not, it starts from
+     * the current position or the beginning.
      */
     func play() {
-        guard !isPlaying, let buffer = audioBuffer else { return }
+        guard !isPlaying, let renderer = renderer else { return }
         
-        // Determine start position based on loop settings
-        let startPosition: TimeInterval
+        stopAudition()
         
-        if loopStartTime > 0 && loopEndTime > loopStartTime {
-            // If loop points are set, start from loop start
-            startPosition = loopStartTime
-            currentTime = loopStartTime
-        } else {
-            // Otherwise start from current position or beginning
-            startPosition = max(0, currentTime)
-        }
+        let wokeEngine = !audioEngine.isRunning
+        guard startEngineIfNeeded() else { return }
         
-        // Record timing for accurate tracking
-        systemStartTime = CACurrentMediaTime()
-        playbackStartTime = startPosition
-        lastLoopStartTime = loopStartTime
+        if !isPaused {
+            if let graph = segmentGraph {
+                renderer.setGraph(graph)
+            } else {
+                // Determine start position based on loop settings
+                let startPosition: TimeInterval
+                if hasLoopRegion {
+                    startPosition = loopStartTime
+                    currentTime = loopStartTime
+                } else {
+                    startPosition = currentTime < duration ? max(0, currentTime) : 0
+                }
+                
+                currentLoopIteration = 0
+                renderer.setGraph(makeLoopGraph(), frame: frame(for: startPosition))
+            }
+            prefetchUpcomingAudio()
+        }
         
+        isPaused = false
         isPlaying = true
-        scheduleFromTime(startPosition)
-        playerNode.play()
+        markStart(of: renderer, wokeEngine: wokeEngine)
+        renderer.setRunning(true)
         
-        // Start position tracking with higher frequency
+        // Start position tracking
         startTrackingPosition()
     }
     
@@ -268,10 +547,14 @@ class AudioManager: ObservableObject {
      * Pauses audio playback while maintaining the current position.
      */
     func pause() {
-        playerNode.pause()
+        guard isPlaying else { return }
+        adoptHandedOffTrack()
+        
+        renderer?.setRunning(false)
         isPlaying = false
-        pausedTime = currentTime
+        isPaused = true
         stopTrackingPosition()
+        scheduleIdleSuspend()
     }
     
     /**
@@ -281,171 +564,715 @@ class AudioManager: ObservableObject {
      * Otherwise, it resets to the beginning of the track.
      */
     func stop() {
-        playerNode.stop()
+        adoptHandedOffTrack()
+        renderer?.setRunning(false)
+        stopAudition()
         isPlaying = false
+        isPaused = false
+        
+        // Leaving custom graph playback returns to the plain loop
+        segmentGraph = nil
+        currentRegionName = nil
         
         // When stopping, if loop points are set, reset to loop start
         // Otherwise reset to beginning
-        if loopStartTime > 0 && loopEndTime > loopStartTime {
+        if hasLoopRegion {
             currentTime = loopStartTime
         } else {
             currentTime = 0
         }
         
         currentLoopIteration = 0
-        pausedTime = 0
         stopTrackingPosition()
+        scheduleIdleSuspend()
     }
     
     /**
      * Sets the loop start and end points for repeated playback.
      *
      * If not playing, updates the current position to the loop start.
-     * If playing, the new loop points will take effect at the next loop iteration.
+     * If playing, the new points are sent to the renderer as a command; by
+     * default the current pass finishes on the old end and the next pass
+     * starts on the new start, with no rescheduling.
+     *
+     * Assigning `loopStartTime` or `loopEndTime` directly (e.g. from a
+     * dragged marker) takes the same path with `.nextSeam` timing.
      *
      * - Parameters:
      *   - start: Loop start point in seconds
      *   - end: Loop end point in seconds
+     *   - timing: When the renderer should apply the change
      */
-    func setLoopPoints(start: TimeInterval, end: TimeInterval) {
+    func setLoopPoints(start: TimeInterval, end: TimeInterval,
+                       timing: LoopRenderer.LoopPointTiming = .nextSeam) {
+        isUpdatingLoopPoints = true
         loopStartTime = max(0, min(start, duration))
         loopEndTime = max(loopStartTime, min(end, duration))
+        isUpdatingLoopPoints = false
         
         // If we're not playing and loop points are valid,
         // move current position to loop start
-        if !isPlaying && loopStartTime > 0 && loopEndTime > loopStartTime {
+        if !isPlaying && !isPaused && hasLoopRegion {
             currentTime = loopStartTime
         }
         
-        // If playing, we need to reschedule with new loop points
-        if isPlaying {
-            lastLoopStartTime = loopStartTime
-        }
+        sendLoopPoints(timing: timing)
     }
     
     /**
      * Seeks to a specific time position in the audio.
      *
+     * During playback this is a read-position jump in the renderer, applied
+     * within one hardware buffer under a short crossfade. Nothing is stopped,
+     * copied or rescheduled, so scrubbing stays cheap.
+     *
      * - Parameter time: Destination time in seconds
      */
     func seek(to time: TimeInterval) {
         let clampedTime = max(0, min(time, duration))
         currentTime = clampedTime
         
-        if isPlaying {
-            // Stop current playback
-            playerNode.stop()
+        if isPlaying || isPaused {
+            renderer?.seek(toFrame: frame(for: clampedTime))
+            prefetchUpcomingAudio()
+        }
+    }
+    
+    // MARK: - Segment Graph Playback
+    
+    /**
+     * Plays a segment graph from the resident buffer.
+     *
+     * Regions are read in place, so region changes never copy audio and
+     * queued transitions land exactly on the next region boundary.
+     *
+     * - Parameters:
+     *   - graph: The graph to play
+     *   - region: Region to start in (defaults to the graph entry)
+     */
+    func playSegmentGraph(_ graph: SegmentGraph, from region: Int? = nil) {
+        guard let renderer = renderer else { return }
+        
+        stop()
+        
+        let wokeEngine = !audioEngine.isRunning
+        guard startEngineIfNeeded() else { return }
+        
+        segmentGraph = graph
+        renderer.setGraph(graph, region: region)
+        prefetchUpcomingAudio()
+        markStart(of: renderer, wokeEngine: wokeEngine)
+        renderer.setRunning(true)
+        
+        isPlaying = true
+        startTrackingPosition()
+    }
+    
+    /**
+     * Queues a transition to the named region at the next region boundary.
+     *
+     * - Parameter regionName: Name of the target region in the playing graph
+     */
+    func queueTransition(to regionName: String) {
+        guard let graph = segmentGraph,
+              let index = graph.index(named: regionName) else { return }
+        renderer?.queueTransition(to: index)
+        prefetchUpcomingAudio()
+    }
+    
+    // MARK: - Play Queue
+    
+    /**
+     * Adds files to the end of the play queue. The next `preloadCount` of
+     * them are decoded and analyzed in the background, so each starts the
+     * instant the one before it finishes its loop iterations.
+     */
+    func enqueue(_ urls: [URL]) {
+        queue.append(contentsOf: urls.map { QueuedTrack(url: $0) })
+        refreshQueue()
+    }
+    
+    /**
+     * Removes a track from the queue, dropping anything preloaded for it.
+     */
+    func removeFromQueue(_ id: UUID) {
+        queue.removeAll { $0.id == id }
+        discardPreparation(id)
+        refreshQueue()
+    }
+    
+    /**
+     * Skips to the first queued track. A preloaded track of the same format
+     * starts at the next render block; anything else is loaded the usual way.
+     */
+    func playNextTrack() {
+        adoptHandedOffTrack()
+        guard let next = queue.first else { return }
+        
+        if let prepared = preparedTracks[next.id], let deck = deck, deck.accepts(prepared.pcm) {
+            stopAudition()
+            let wokeEngine = !audioEngine.isRunning
+            guard startEngineIfNeeded() else { return }
             
-            // Update timing references
-            systemStartTime = CACurrentMediaTime()
-            playbackStartTime = clampedTime
-            lastLoopStartTime = loopStartTime
+            let newRenderer: LoopRenderer
+            if let armed = armedTrack, armed.id == next.id {
+                newRenderer = armed.renderer
+            } else {
+                newRenderer = makeQueuedRenderer(for: prepared)
+            }
+            
+            // Disarm first so the renderer is never both current and successor
+            deck.queueNext(nil)
+            armedTrack = nil
+            markStart(of: newRenderer, wokeEngine: wokeEngine)
+            deck.play(newRenderer)
+            adopt(prepared, id: next.id, renderer: newRenderer)
             
-            // Restart from new position
-            scheduleFromTime(clampedTime)
-            playerNode.play()
+            isPaused = false
+            isPlaying = true
+            startTrackingPosition()
+            return
+        }
+        
+        // Not preloaded yet, or it needs a different output format
+        queue.removeFirst()
+        discardPreparation(next.id)
+        do {
+            try loadAudioFile(url: next.url)
+            setLoopPoints(start: 0, end: duration)
+            EventBus.shared.publishTrackChanged(next.url)
+            play()
+        } catch {
+            print("Failed to load queued track \(next.url.lastPathComponent): \(error.localizedDescription)")
         }
+        refreshQueue()
     }
     
-    // MARK: - Internal Playback Functions
-    
     /**
-     * Schedules audio playback from a specific time position.
+     * Starts preparing the tracks within `preloadCount` of the head of the
+     * queue, drops preparations that fell out of that window, and arms the
+     * next track on the deck once it is ready.
      *
-     * Creates a buffer segment from the specified time to either the loop end
-     * or the track end, depending on loop settings.
+     * A track decodes resident only if it fits in what is left of
+     * `preloadMemoryBudget`; otherwise it is streamed, which costs a fixed
+     * chunk ring whatever its length.
+     */
+    private func refreshQueue() {
+        let upcoming = queue.prefix(max(0, preloadCount))
+        let upcomingIDs = Set(upcoming.map { $0.id })
+        
+        for id in Set(preparedTracks.keys).union(preparationTasks.keys) where !upcomingIDs.contains(id) {
+            discardPreparation(id)
+        }
+        
+        for track in upcoming where preparedTracks[track.id] == nil && preparationTasks[track.id] == nil {
+            var resident = false
+            if let bytes = TrackPreloader.residentBytes(of: track.url), preloadedBytes + bytes <= preloadMemoryBudget {
+                preloadReservations[track.id] = bytes
+                preloadedBytes += bytes
+                resident = true
+            }
+            
+            let id = track.id
+            let url = track.url
+            preparationTasks[id] = Task.detached(priority: .background) { [weak self] in
+                let prepared = await TrackPreloader.prepare(url: url, resident: resident)
+                DispatchQueue.main.async {
+                    self?.finishPreparation(id, prepared)
+                }
+            }
+        }
+        
+        armNextTrack()
+    }
+    
+    /**
+     * Stores a finished preparation, unless its track left the queue meanwhile.
+     */
+    private func finishPreparation(_ id: UUID, _ prepared: PreparedTrack?) {
+        guard preparationTasks.removeValue(forKey: id) != nil else { return }
+        
+        guard let prepared = prepared else {
+            print("Failed to prepare queued track")
+            queue.removeAll { $0.id == id }
+            discardPreparation(id)
+            refreshQueue()
+            return
+        }
+        
+        preparedTracks[id] = prepared
+        readyTrackIDs.insert(id)
+        armNextTrack()
+    }
+    
+    /**
+     * Cancels or releases whatever was prepared for a track and returns its
+     * share of the preload budget.
+     */
+    private func discardPreparation(_ id: UUID) {
+        preparationTasks.removeValue(forKey: id)?.cancel()
+        preparedTracks[id] = nil
+        readyTrackIDs.remove(id)
+        preloadedBytes -= preloadReservations.removeValue(forKey: id) ?? 0
+    }
+    
+    /**
+     * Arms the first queued track behind the current one, so the deck hands
+     * over within the render block where the current graph ends. Re-arms
+     * when the loop count changes; disarms when there is nothing to follow
+     * or the next track needs a different output format.
+     */
+    private func armNextTrack() {
+        guard let deck = deck,
+              let next = queue.first,
+              let prepared = preparedTracks[next.id],
+              deck.accepts(prepared.pcm) else {
+            if armedTrack != nil {
+                deck?.queueNext(nil)
+                armedTrack = nil
+            }
+            return
+        }
+        
+        if let armed = armedTrack, armed.id == next.id, armed.loopCount == loopCount {
+            return
+        }
+        
+        let newRenderer = makeQueuedRenderer(for: prepared)
+        deck.queueNext(newRenderer)
+        armedTrack = (next.id, newRenderer, loopCount)
+    }
+    
+    /**
+     * A running renderer for a prepared track, starting from its beginning
+     * with the current loop count and its own normalization gain.
+     */
+    private func makeQueuedRenderer(for prepared: PreparedTrack) -> LoopRenderer {
+        let pcm = prepared.pcm
+        let loopStartFrame = Int((prepared.loopStart * pcm.sampleRate).rounded())
+        let loopEndFrame = Int((prepared.loopEnd * pcm.sampleRate).rounded())
+        let hasLoop = loopEndFrame > loopStartFrame && (loopStartFrame > 0 || loopEndFrame < pcm.frameCount)
+        
+        let newRenderer = makeRenderer(for: pcm)
+        newRenderer.setGraph(AudioManager.loopGraph(frameCount: pcm.frameCount,
+                                                    loop: hasLoop ? loopStartFrame..<loopEndFrame : nil,
+                                                    loopCount: loopCount))
+        newRenderer.setGain(normalizationGain(for: prepared.loudness))
+        newRenderer.setRunning(true)
+        return newRenderer
+    }
+    
+    /**
+     * Takes on the armed track once the deck has handed over to it. Called
+     * before anything addresses the renderer, so controls never reach the
+     * track that just ended.
+     */
+    private func adoptHandedOffTrack() {
+        guard let deck = deck, deck.handoffs != observedHandoffs else { return }
+        observedHandoffs = deck.handoffs
+        deck.drainRetiredRenderers()
+        
+        guard let armed = armedTrack, let prepared = preparedTracks[armed.id] else { return }
+        armedTrack = nil
+        adopt(prepared, id: armed.id, renderer: armed.renderer)
+    }
+    
+    /**
+     * Makes a prepared track the loaded one, with `renderer` (already on the
+     * deck) playing it, and moves the queue along.
+     */
+    private func adopt(_ prepared: PreparedTrack, id: UUID, renderer newRenderer: LoopRenderer) {
+        releaseAudition()
+        
+        _audioFile = prepared.file
+        _audioFileURL = prepared.url
+        sampleRate = prepared.pcm.sampleRate
+        duration = prepared.pcm.duration
+        audioBuffer = prepared.buffer
+        streamedPCM = prepared.streamedPCM
+        renderer = newRenderer
+        levelMeter.attach(to: newRenderer.meterRing, sampleRate: sampleRate)
+        
+        segmentGraph = nil
+        currentRegionName = nil
+        isUpdatingLoopPoints = true
+        loopStartTime = prepared.loopStart
+        loopEndTime = prepared.loopEnd
+        isUpdatingLoopPoints = false
+        currentTime = 0
+        currentLoopIteration = 0
+        
+        if let measurement = prepared.loudness {
+            loudnessGeneration.wrappingIncrement(ordering: .relaxed)
+            loudness = measurement
+            applyNormalizationGain()
+        } else {
+            prepareNormalization(for: prepared.url)
+        }
+        
+        // The track now counts as loaded, not preloaded
+        queue.removeAll { $0.id == id }
+        discardPreparation(id)
+        EventBus.shared.publishTrackChanged(prepared.url)
+        refreshQueue()
+    }
+    
+    // MARK: - Seam Audition
+    
+    /**
+     * Renders seam clips for the best candidates in the background, so each
+     * seam can then be heard instantly with `auditionSeam(of:)`.
      *
-     * - Parameter time: Start time in seconds
+     * - Parameters:
+     *   - candidates: Candidates to prepare, best first
+     *   - count: How many of them to render
+     *   - leadTime: Seconds of audio on each side of the seam
      */
-    private func scheduleFromTime(_ time: TimeInterval) {
-        guard let buffer = audioBuffer else { return }
+    func prepareSeamAudition(for candidates: [MusicStructureAnalyzer.LoopCandidate], count: Int = 8,
+                             leadTime: TimeInterval = 2) {
+        guard let renderer = renderer else { return }
         
-        let startFrame = AVAudioFramePosition(time * sampleRate)
-        let endFrame: AVAudioFramePosition
+        stopAudition()
+        auditionGeneration += 1
+        auditionReadyIDs = []
         
-        // If loop points are set, use loop end; otherwise use track end
-        if loopStartTime > 0 && loopEndTime > loopStartTime && time >= loopStartTime {
-            endFrame = AVAudioFramePosition(loopEndTime * sampleRate)
+        let generation = auditionGeneration
+        let rate = sampleRate
+        let seams = candidates.prefix(count).map {
+            SeamAuditioner.Seam(id: $0.id,
+                                startFrame: Int(($0.startTime * rate).rounded()),
+                                endFrame: Int(($0.endTime * rate).rounded()))
+        }
+        
+        // Streamed files get their own ring so clip rendering can't evict playback chunks
+        let source: PCMSource?
+        if streamedPCM != nil, let url = audioFileURL {
+            source = StreamedPCM(url: url)
         } else {
-            endFrame = AVAudioFramePosition(duration * sampleRate)
+            source = renderer.pcm
+        }
+        guard let trackSource = source, !seams.isEmpty else { return }
+        
+        DispatchQueue.global(qos: .utility).async {
+            let bank = SeamAuditioner.renderBank(from: trackSource,
+                                                 seams: seams,
+                                                 leadFrames: Int(leadTime * rate),
+                                                 gapFrames: Int(0.4 * rate))
+            
+            DispatchQueue.main.async {
+                guard generation == self.auditionGeneration else { return }
+                self.installAudition(bank)
+            }
+        }
+    }
+    
+    /**
+     * Plays the seam clip of `candidate` on repeat, pausing normal playback.
+     * Switching candidates restarts the new clip within one render block.
+     */
+    func auditionSeam(of candidate: MusicStructureAnalyzer.LoopCandidate) {
+        guard let auditionRenderer = auditionRenderer,
+              let bank = auditionBank,
+              let region = bank.regions[candidate.id] else { return }
+        
+        pause()
+        guard startEngineIfNeeded() else { return }
+        auditionRenderer.setGraph(bank.graph, region: region)
+        auditionRenderer.setRunning(true)
+        auditioningCandidateID = candidate.id
+    }
+    
+    /**
+     * Stops seam audition. Prepared clips are kept.
+     */
+    func stopAudition() {
+        guard auditioningCandidateID != nil else { return }
+        auditionRenderer?.setRunning(false)
+        auditioningCandidateID = nil
+        
+        if !isPlaying {
+            scheduleIdleSuspend()
+        }
+    }
+    
+    /**
+     * Attaches a source node for a freshly rendered clip bank, replacing the previous one.
+     */
+    private func installAudition(_ bank: SeamAuditioner.Bank) {
+        let newRenderer = LoopRenderer(pcm: bank.pcm)
+        guard let node = newRenderer.makeSourceNode() else { return }
+        
+        if let oldNode = auditionNode {
+            audioEngine.detach(oldNode)
         }
         
-        let framesToPlay = AVAudioFrameCount(endFrame - startFrame)
+        audioEngine.attach(node)
+        audioEngine.connect(node, to: audioEngine.mainMixerNode, format: newRenderer.outputFormat)
         
-        // Don't schedule empty segments
-        guard framesToPlay > 0 else { return }
+        newRenderer.setGain(normalizationGain)
+        auditionRenderer = newRenderer
+        auditionNode = node
+        auditionBank = bank
+        auditionReadyIDs = Set(bank.regions.keys)
+    }
+    
+    /**
+     * Detaches the audition node and drops its clips, e.g. when a new file loads.
+     */
+    private func releaseAudition() {
+        stopAudition()
+        auditionGeneration += 1
+        if let node = auditionNode {
+            audioEngine.detach(node)
+        }
+        auditionNode = nil
+        auditionRenderer = nil
+        auditionBank = nil
+        auditionReadyIDs = []
+    }
+    
+    // MARK: - Loudness Normalization
+    
+    /**
+     * Looks up the loaded track's loudness in the analysis cache, or measures
+     * it in the background (a single decode pass) and caches the result.
+     */
+    private func prepareNormalization(for url: URL) {
+        let generation = loudnessGeneration.wrappingIncrementThenLoad(ordering: .relaxed)
+        loudness = nil
+        applyNormalizationGain()
         
-        // Create a buffer for the segment from current position to end point
-        guard let segmentBuffer = AVAudioPCMBuffer(pcmFormat: buffer.format, frameCapacity: framesToPlay) else {
-            lastError = AudioManagerError.bufferCreationFailed
+        if let cached = AnalysisCache.shared.entry(for: url)?.loudness {
+            loudness = cached
+            applyNormalizationGain()
             return
         }
         
-        // Copy audio data for the current segment
-        let sourceChannels = Int(buffer.format.channelCount)
-        for channel in 0..<sourceChannels {
-            guard let sourcePtr = buffer.floatChannelData?[channel],
-                  let destPtr = segmentBuffer.floatChannelData?[channel] else {
-                continue
+        DispatchQueue.global(qos: .utility).async {
+            guard let measurement = LoudnessAccumulator.measure(url: url, shouldContinue: {
+                generation == self.loudnessGeneration.load(ordering: .relaxed)
+            }) else { return }
+            AnalysisCache.shared.update(url) { $0.loudness = measurement }
+            
+            DispatchQueue.main.async {
+                guard generation == self.loudnessGeneration.load(ordering: .relaxed) else { return }
+                self.loudness = measurement
+                self.applyNormalizationGain()
             }
-            destPtr.update(from: sourcePtr + Int(startFrame), count: Int(framesToPlay))
         }
-        segmentBuffer.frameLength = framesToPlay
+    }
+    
+    /**
+     * Sends the gain for the current loudness and settings to the renderers.
+     * The gain is applied as samples are copied out of the source, so it
+     * costs one multiply per sample.
+     */
+    private func applyNormalizationGain() {
+        let gain = normalizationGain(for: loudness)
+        normalizationGain = gain
+        renderer?.setGain(gain)
+        auditionRenderer?.setGain(gain)
         
-        // Schedule with completion handler for looping
-        playerNode.scheduleBuffer(segmentBuffer, at: nil, options: [], completionHandler: { [weak self] in
-            DispatchQueue.main.async {
-                self?.handleBufferCompletion()
+        if let armed = armedTrack {
+            armed.renderer.setGain(normalizationGain(for: preparedTracks[armed.id]?.loudness))
+        }
+    }
+    
+    /// Playback gain for a track of the given loudness under the current settings
+    private func normalizationGain(for loudness: LoudnessAccumulator.Measurement?) -> Float {
+        guard isLoudnessNormalized else { return 1 }
+        return loudness?.normalizationGain(target: normalizationTarget) ?? 1
+    }
+    
+    // MARK: - Export
+    
+    /**
+     * Opens audio for offline work: resident for normal files, streamed
+     * through a chunk ring past `residentDurationLimit`.
+     */
+    static func makeSource(for url: URL) throws -> PCMSource {
+        let file = try AVAudioFile(forReading: url)
+        let duration = Double(file.length) / file.processingFormat.sampleRate
+        
+        if duration > residentDurationLimit {
+            guard let streamed = StreamedPCM(url: url) else {
+                throw AudioManagerError.invalidFormat
             }
-        })
+            return streamed
+        }
+        return try ResidentPCM(url: url)
     }
     
     /**
-     * Handles completion of buffer playback for looping.
+     * Exports the current loop as an extended file in the background: intro,
+     * loop iterations (or a target length) and a cosine fade-out.
      *
-     * Called when the current buffer segment finishes playing.
-     * Schedules the next segment if in loop mode, otherwise stops playback.
+     * - Parameters:
+     *   - url: Destination file; the extension picks the encoding
+     *   - iterations: Loop iterations before the fade
+     *   - targetDuration: If set, total length instead of a fixed iteration count
+     *   - fadeDuration: Length of the fade-out in seconds
+     *   - completion: Called on the main thread with the frames written or an error
      */
-    private func handleBufferCompletion() {
-        guard isPlaying else { return }
+    func exportExtendedLoop(to url: URL, iterations: Int, targetDuration: TimeInterval? = nil,
+                            fadeDuration: TimeInterval = 10,
+                            completion: @escaping (Result<Int, Error>) -> Void) {
+        guard let renderer = renderer, exportProgress == nil else { return }
         
-        // Check if we have valid loop points
-        if loopStartTime > 0 && loopEndTime > loopStartTime {
-            currentLoopIteration += 1
-            
-            // Check if we should continue looping
-            if loopCount == 0 || currentLoopIteration < loopCount {
-                // Update timing for the new loop
-                systemStartTime = CACurrentMediaTime()
-                playbackStartTime = loopStartTime
-                currentTime = loopStartTime
-                
-                // Schedule next loop
-                scheduleFromTime(loopStartTime)
-            } else {
-                // Stop looping
-                stop()
+        // Streamed files get their own ring so the export can't evict playback chunks
+        let source: PCMSource
+        if streamedPCM != nil, let fileURL = audioFileURL {
+            guard let streamed = StreamedPCM(url: fileURL) else {
+                completion(.failure(AudioManagerError.invalidFormat))
+                return
             }
+            source = streamed
         } else {
-            // No loop points set, just stop at end
-            stop()
+            source = renderer.pcm
+        }
+        
+        let settings = LoopExporter.Settings(loopStartFrame: frame(for: loopStartTime),
+                                             loopEndFrame: frame(for: loopEndTime),
+                                             iterations: iterations,
+                                             targetDuration: targetDuration,
+                                             fadeDuration: fadeDuration)
+        let exporter = LoopExporter(source: source, settings: settings)
+        
+        exportProgress = 0
+        isExportCancelled.store(false, ordering: .relaxed)
+        
+        DispatchQueue.global(qos: .userInitiated).async {
+            var lastReported = 0.0
+            let result = Result<Int, Error> {
+                try exporter.export(to: url) { progress in
+                    // Throttle UI updates to whole percents
+                    if progress - lastReported >= 0.01 || progress >= 1 {
+                        lastReported = progress
+                        DispatchQueue.main.async { self.exportProgress = progress }
+                    }
+                    return !self.isExportCancelled.load(ordering: .relaxed)
+                }
+            }
+            
+            DispatchQueue.main.async {
+                self.exportProgress = nil
+                if case .failure(let error) = result {
+                    print("Export failed: \(error.localizedDescription)")
+                }
+                completion(result)
+            }
+        }
+    }
+    
+    /**
+     * Cancels the running export; its completion reports `ExportError.cancelled`.
+     */
+    func cancelExport() {
+        isExportCancelled.store(true, ordering: .relaxed)
+    }
+    
+    // MARK: - Internal Playback Functions
+    
+    /**
+     * Builds the graph for plain playback: lead-in plus loop region when loop
+     * points are set, otherwise the whole track once.
+     */
+    private func makeLoopGraph() -> SegmentGraph {
+        return AudioManager.loopGraph(frameCount: renderer?.pcm.frameCount ?? 0,
+                                      loop: hasLoopRegion ? frame(for: loopStartTime)..<frame(for: loopEndTime) : nil,
+                                      loopCount: loopCount)
+    }
+    
+    /**
+     * Lead-in plus `loop` repeated `loopCount` times (0 = forever), or the
+     * whole track once when there is no loop.
+     */
+    private static func loopGraph(frameCount: Int, loop: Range<Int>?, loopCount: Int) -> SegmentGraph {
+        if let loop = loop {
+            return SegmentGraph.singleLoop(frameCount: frameCount,
+                                           loopStartFrame: loop.lowerBound,
+                                           loopEndFrame: loop.upperBound,
+                                           loopCount: loopCount)
+        }
+        
+        var graph = SegmentGraph()
+        graph.addRegion(name: "Track", startFrame: 0, endFrame: frameCount, behavior: .sequential)
+        return graph
+    }
+    
+    /**
+     * Forwards the current loop points to the renderer. The playing loop graph
+     * is edited in place; only switching between looping and straight playback
+     * needs a new graph.
+     */
+    private func sendLoopPoints(timing: LoopRenderer.LoopPointTiming) {
+        guard let renderer = renderer, isPlaying || isPaused, segmentGraph == nil else { return }
+        
+        let playingLoop = renderer.graph?.loopRegion != nil
+        if hasLoopRegion && playingLoop {
+            renderer.setLoopPoints(startFrame: frame(for: loopStartTime),
+                                   endFrame: frame(for: loopEndTime),
+                                   timing: timing)
+        } else if hasLoopRegion != playingLoop && loopEndTime > loopStartTime {
+            // Markers crossed mid-drag (end before start) leave the playing loop alone
+            refreshLoopGraph()
         }
+        prefetchUpcomingAudio()
+    }
+    
+    /**
+     * Sends a rebuilt loop graph to the renderer, keeping the current play
+     * position. Custom segment graphs are left alone.
+     */
+    private func refreshLoopGraph() {
+        guard let renderer = renderer, isPlaying || isPaused, segmentGraph == nil else { return }
+        renderer.setGraph(makeLoopGraph(), frame: renderer.position.frame)
+        prefetchUpcomingAudio()
+    }
+    
+    /**
+     * Asks a streamed source to decode what the renderer will read next,
+     * following loop wraps. Resident files need nothing.
+     */
+    private func prefetchUpcomingAudio() {
+        guard let streamed = streamedPCM, let renderer = renderer else { return }
+        streamed.prefetch(renderer.upcomingReads(frames: Int(AudioManager.prefetchDuration * sampleRate)))
+    }
+    
+    /**
+     * The zero crossing of the first channel nearest `time`, for snapping
+     * loop handles. Nil for streamed tracks or when none is within `radius`.
+     */
+    func nearestZeroCrossing(to time: TimeInterval, within radius: TimeInterval) -> TimeInterval? {
+        guard let buffer = audioBuffer, let channelData = buffer.floatChannelData else { return nil }
+        let crossing = SnapIndex.nearestZeroCrossing(in: channelData[0], frameCount: Int(buffer.frameLength),
+                                                     around: frame(for: time), radius: Int(radius * sampleRate))
+        return crossing.map { Double($0) / sampleRate }
+    }
+    
+    /**
+     * Converts a time in seconds to a frame index in the resident buffer.
+     */
+    private func frame(for time: TimeInterval) -> Int {
+        return Int((time * sampleRate).rounded())
     }
     
     // MARK: - Position Tracking
     
     /**
-     * Starts the timer for tracking playback position.
+     * Starts the timer for tracking playback position and refreshing the meters.
      *
-     * Uses a high-frequency timer to achieve near sample-accurate position tracking.
+     * The renderer publishes the exact frame it plays, so accuracy doesn't
+     * depend on the tick rate; one display-rate timer with a loose tolerance
+     * drives both and lets the system coalesce its wake-ups.
      */
     private func startTrackingPosition() {
-        // Use a higher frequency timer for more accurate tracking
         positionTimer?.invalidate()
-        positionTimer = Timer.scheduledTimer(withTimeInterval: 0.01, repeats: true) { [weak self] _ in
+        positionTimer = Timer.scheduledTimer(withTimeInterval: AudioManager.displayInterval, repeats: true) { [weak self] _ in
             self?.updateCurrentTime()
+            self?.levelMeter.update()
         }
-        positionTimer?.tolerance = 0.001 // Very tight tolerance
+        positionTimer?.tolerance = AudioManager.displayInterval / 4
     }
     
     /**
@@ -454,42 +1281,68 @@ class AudioManager: ObservableObject {
     private func stopTrackingPosition() {
         positionTimer?.invalidate()
         positionTimer = nil
+        levelMeter.reset()
+    }
+    
+    /**
+     * Asks the renderer to timestamp its first frame for this start, so
+     * `lastStartLatency` can be reported once playback is audible.
+     */
+    private func markStart(of renderer: LoopRenderer, wokeEngine: Bool) {
+        renderer.markStart()
+        startRequestUptime = DispatchTime.now().uptimeNanoseconds
+        lastStartWokeEngine = wokeEngine
     }
     
     /**
-     * Updates the current time based on elapsed system time.
+     * Publishes the start latency once the renderer has stamped its first frame.
+     */
+    private func recordStartLatency(from renderer: LoopRenderer) {
+        guard let requested = startRequestUptime, let rendered = renderer.firstFrameTime else { return }
+        startRequestUptime = nil
+        lastStartLatency = Double(rendered &- requested) / 1_000_000_000
+    }
+    
+    /**
+     * Updates the current time from the renderer's published position.
      *
-     * Calculates the current playback position using precise time measurements
-     * rather than relying on AVAudioPlayerNode's less accurate position reporting.
+     * The renderer reports the exact frame it will read next, so the displayed
+     * position follows loop wraps and region transitions precisely.
      */
     private func updateCurrentTime() {
         guard isPlaying else { return }
+        adoptHandedOffTrack()
+        guard let renderer = renderer, let graph = renderer.graph else { return }
         
-        // Calculate time based on system time elapsed since play started
-        let currentSystemTime = CACurrentMediaTime()
-        let elapsedTime = currentSystemTime - systemStartTime
+        renderer.drainRetiredGraphs()
+        recordStartLatency(from: renderer)
+        prefetchUpcomingAudio()
         
-        // Calculate where we should be
-        if loopStartTime > 0 && loopEndTime > loopStartTime {
-            // We're in loop mode
-            let loopDuration = loopEndTime - loopStartTime
-            let timeSinceLoopStart = elapsedTime.truncatingRemainder(dividingBy: loopDuration)
-            let calculatedTime = lastLoopStartTime + timeSinceLoopStart
-            
-            // Clamp to loop boundaries
-            let newTime = max(loopStartTime, min(calculatedTime, loopEndTime))
-            
-            DispatchQueue.main.async {
-                self.currentTime = newTime
+        // Ignore positions reported before the renderer picked up the latest graph or seek
+        guard renderer.isCaughtUp, !renderer.hasPendingSeek else { return }
+        
+        let position = renderer.position
+        if position.isFinished {
+            if armedTrack != nil {
+                // The deck is already playing the next track; adopt it next tick
+                return
             }
-        } else {
-            // Normal playback mode
-            let calculatedTime = playbackStartTime + elapsedTime
-            let newTime = max(0, min(calculatedTime, duration))
-            
-            DispatchQueue.main.async {
-                self.currentTime = newTime
+            if queue.isEmpty {
+                stop()
+            } else {
+                playNextTrack()
             }
+            return
+        }
+        
+        guard graph.regions.indices.contains(position.region) else { return }
+        let region = graph.regions[position.region]
+        
+        currentTime = Double(position.frame) / sampleRate
+        currentLoopIteration = region.behavior == .sequential ? 0 : position.iteration
+        
+        if segmentGraph != nil {
+            currentRegionName = region.name
         }
     }
 }
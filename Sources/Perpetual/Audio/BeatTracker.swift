@@ -0,0 +1,280 @@
+import Accelerate
+import Foundation
+
+/**
+ * BeatTracker
+ *
+ * Finds the beats and downbeats a loop handle can snap to. Onsets are the
+ * spectral flux of short frames centered every `hopSize` samples, whatever
+ * the analysis preset's feature hop. The tempo comes from the onset
+ * autocorrelation, with its peak interpolated between lags, and the beats
+ * are then placed by dynamic programming: each beat is the strongest onset
+ * about one period after the one before, so the grid follows the music
+ * instead of laying one phase across the whole track. Every beat finally
+ * moves onto the steepest energy rise next to it. Nothing is returned when
+ * the onsets show no steady pulse.
+ */
+enum BeatTracker {
+    struct Grid {
+        /// Beat times in seconds, ascending
+        var beats: [TimeInterval]
+
+        /// Every fourth beat from the most accented one; empty when no phase stands out
+        var downbeats: [TimeInterval]
+
+        /// Seconds per beat
+        var period: TimeInterval
+    }
+
+    /// Samples between onset frames (~6ms at 44.1kHz)
+    static let hopSize = 256
+    private static let fftSize = 1024
+
+    /// Tempos searched, in beats per minute
+    private static let tempoRange: ClosedRange<Double> = 60...200
+
+    /// Tempo the search leans towards when half or double tempo correlates as well
+    private static let preferredTempo = 120.0
+
+    /// Autocorrelation, relative to lag zero, a period needs to count as a pulse
+    private static let minimumPeriodicity: Float = 0.15
+
+    /// How strictly the gap between beats is held to the period
+    private static let tightness: Float = 100
+
+    /// How much stronger than the average phase the downbeat phase must be
+    private static let downbeatAccent: Float = 1.1
+
+    /// Samples per segment when moving a beat onto its attack
+    private static let attackSegmentSize = 64
+
+    /// Smallest rise (a doubling of the level) that counts as an attack
+    private static let minimumAttackRise: Float = log(2)
+
+    /**
+     * - Parameters:
+     *   - samples: Mono samples
+     *   - frameCount: Samples in `samples`
+     *   - sampleRate: Rate of `samples`
+     * - Returns: nil when no steady beat is found
+     */
+    static func track(samples: UnsafePointer<Float>, frameCount: Int, sampleRate: Double) -> Grid? {
+        let onsets = onsetStrength(of: samples, frameCount: frameCount)
+        guard let period = beatPeriod(of: onsets, sampleRate: sampleRate) else { return nil }
+
+        let beatFrames = placeBeats(on: onsets, period: period)
+        guard beatFrames.count >= 4 else { return nil }
+
+        let beats = beatFrames.map { frame -> TimeInterval in
+            Double(attackSample(near: frame * hopSize, in: samples, frameCount: frameCount)) / sampleRate
+        }
+        return Grid(beats: beats,
+                    downbeats: downbeats(of: beats, strengths: beatFrames.map { onsets[$0] }),
+                    period: period * Double(hopSize) / sampleRate)
+    }
+
+    // MARK: - Onsets
+
+    /**
+     * Half-wave rectified flux of the log-compressed spectrum, one value per
+     * frame; frame `i` is centered on sample `i * hopSize`.
+     */
+    private static func onsetStrength(of samples: UnsafePointer<Float>, frameCount: Int) -> [Float] {
+        guard frameCount > fftSize, let spectrum = ShortTimeSpectrum(fftSize: fftSize) else { return [] }
+        let binCount = spectrum.binCount
+        var onsets = [Float](repeating: 0, count: frameCount / hopSize + 1)
+
+        var scratch = [Float](repeating: 0, count: binCount * 3)
+        scratch.withUnsafeMutableBufferPointer { buffer in
+            var previous = buffer.baseAddress!
+            var current = previous + binCount
+            let rise = current + binCount
+            var scale = 1000 / Float(fftSize)
+            var zero: Float = 0
+            var length = Int32(binCount)
+
+            for frame in onsets.indices {
+                spectrum.magnitudes(of: samples, frameCount: frameCount, centeredAt: frame * hopSize, into: current)
+                vDSP_vsmul(current, 1, &scale, current, 1, vDSP_Length(binCount))
+                vvlog1pf(current, current, &length)
+
+                if frame > 0 {
+                    vDSP_vsub(previous, 1, current, 1, rise, 1, vDSP_Length(binCount))
+                    vDSP_vthres(rise, 1, &zero, rise, 1, vDSP_Length(binCount))
+
+                    // Bin 0 packs DC with Nyquist; leave it out
+                    var flux: Float = 0
+                    vDSP_sve(rise + 1, 1, &flux, vDSP_Length(binCount - 1))
+                    onsets[frame] = flux
+                }
+                swap(&previous, &current)
+            }
+        }
+        return onsets
+    }
+
+    // MARK: - Tempo
+
+    /**
+     * Frames per beat: the strongest autocorrelation peak of the onsets in
+     * the tempo range, weighted towards `preferredTempo`, refined to a
+     * fraction of a frame with a parabola through the peak and its
+     * neighbours. nil without a clear peak.
+     */
+    private static func beatPeriod(of onsets: [Float], sampleRate: Double) -> Double? {
+        let framesPerSecond = sampleRate / Double(hopSize)
+        let shortestLag = Int(60 / tempoRange.upperBound * framesPerSecond)
+        let longestLag = Int((60 / tempoRange.lowerBound * framesPerSecond).rounded(.up))
+        guard shortestLag > 1, onsets.count > longestLag * 4 else { return nil }
+
+        // Correlate the deviation from the mean, so a steady level doesn't read as a pulse
+        var centered = [Float](repeating: 0, count: onsets.count)
+        var mean: Float = 0
+        vDSP_meanv(onsets, 1, &mean, vDSP_Length(onsets.count))
+        var negativeMean = -mean
+        vDSP_vsadd(onsets, 1, &negativeMean, &centered, 1, vDSP_Length(onsets.count))
+
+        // One lag past each end of the range, so the edges can still be peaks
+        var energy: Float = 0
+        var correlation = [Float](repeating: 0, count: longestLag + 2)
+        centered.withUnsafeBufferPointer { values in
+            let base = values.baseAddress!
+            vDSP_svesq(base, 1, &energy, vDSP_Length(values.count))
+            for lag in (shortestLag - 1)...(longestLag + 1) {
+                vDSP_dotpr(base, 1, base + lag, 1, &correlation[lag], vDSP_Length(values.count - lag))
+            }
+        }
+        guard energy > 0 else { return nil }
+
+        var best: Int?
+        var bestScore: Float = 0
+        for lag in shortestLag...longestLag
+        where correlation[lag] > correlation[lag - 1] && correlation[lag] >= correlation[lag + 1] {
+            let periodicity = correlation[lag] / energy
+            guard periodicity >= minimumPeriodicity else { continue }
+
+            let octaves = log2(60 * framesPerSecond / Double(lag) / preferredTempo)
+            let score = periodicity * Float(exp(-0.5 * octaves * octaves))
+            if score > bestScore {
+                best = lag
+                bestScore = score
+            }
+        }
+        guard let lag = best else { return nil }
+
+        let left = correlation[lag - 1]
+        let peak = correlation[lag]
+        let right = correlation[lag + 1]
+        let curvature = left - 2 * peak + right
+        let offset = curvature < 0 ? 0.5 * (left - right) / curvature : 0
+        return Double(lag) + Double(offset)
+    }
+
+    // MARK: - Beats
+
+    /**
+     * Beat frames by dynamic programming. A frame scores its own onset
+     * strength plus the best score of a frame half a period to two periods
+     * earlier, less a penalty that grows with how far that gap strays from
+     * the period. The beats are read back from the best frame in the last
+     * period, then trimmed at either end where no onset sits under them.
+     */
+    private static func placeBeats(on onsets: [Float], period: Double) -> [Int] {
+        let count = onsets.count
+        var level: Float = 0
+        vDSP_rmsqv(onsets, 1, &level, vDSP_Length(count))
+        guard level > 0 else { return [] }
+
+        var strength = [Float](repeating: 0, count: count)
+        var scale = 1 / level
+        vDSP_vsmul(onsets, 1, &scale, &strength, 1, vDSP_Length(count))
+
+        let shortestGap = max(1, Int((period / 2).rounded()))
+        let longestGap = max(shortestGap, Int((period * 2).rounded()))
+        let penalties = (shortestGap...longestGap).map { gap -> Float in
+            let stretch = Float(log(Double(gap) / period))
+            return -tightness * stretch * stretch
+        }
+
+        var score = strength
+        var previousBeat = [Int](repeating: -1, count: count)
+        if shortestGap < count {
+            for frame in shortestGap..<count {
+                var best = -Float.infinity
+                for gap in shortestGap...min(longestGap, frame) {
+                    let candidate = score[frame - gap] + penalties[gap - shortestGap]
+                    if candidate > best {
+                        best = candidate
+                        previousBeat[frame] = frame - gap
+                    }
+                }
+                score[frame] += best
+            }
+        }
+
+        let lastPeriod = max(0, count - Int(period.rounded(.up)))
+        guard var frame = (lastPeriod..<count).max(by: { score[$0] < score[$1] }) else { return [] }
+
+        var beats: [Int] = []
+        while frame >= 0 {
+            beats.append(frame)
+            frame = previousBeat[frame]
+        }
+        beats.reverse()
+
+        // The chain carries on through silence at either end; drop those beats
+        var beatLevel: Float = 0
+        let beatStrengths = beats.map { strength[$0] }
+        vDSP_rmsqv(beatStrengths, 1, &beatLevel, vDSP_Length(beatStrengths.count))
+        let threshold = beatLevel / 2
+        guard let first = beats.firstIndex(where: { strength[$0] >= threshold }),
+              let last = beats.lastIndex(where: { strength[$0] >= threshold }) else { return [] }
+        return Array(beats[first...last])
+    }
+
+    /**
+     * The start of the steepest level rise within two hops of `center`,
+     * measured on short RMS segments; `center` itself when nothing rises.
+     */
+    private static func attackSample(near center: Int, in samples: UnsafePointer<Float>, frameCount: Int) -> Int {
+        let segmentSize = attackSegmentSize
+        let start = max(0, center - 2 * hopSize)
+        let segmentCount = (min(frameCount, center + 2 * hopSize) - start) / segmentSize
+        guard segmentCount > 1 else { return center }
+
+        return withUnsafeTemporaryAllocation(of: Float.self, capacity: segmentCount) { levels in
+            let base = levels.baseAddress!
+            SeamEnvelope.segmentRMS(of: UnsafeBufferPointer(start: samples + start, count: segmentCount * segmentSize),
+                                    segmentSize: segmentSize, into: base)
+
+            var attack = center
+            var steepest = minimumAttackRise
+            for segment in 1..<segmentCount {
+                let rise = log(base[segment] + 1e-5) - log(base[segment - 1] + 1e-5)
+                if rise > steepest {
+                    steepest = rise
+                    attack = start + segment * segmentSize
+                }
+            }
+            return attack
+        }
+    }
+
+    /**
+     * Every fourth beat from the phase whose beats carry the strongest
+     * onsets, when that phase is clearly accented; empty otherwise.
+     */
+    private static func downbeats(of beats: [TimeInterval], strengths: [Float]) -> [TimeInterval] {
+        guard beats.count >= 8 else { return [] }
+
+        let phaseStrengths = (0..<4).map { phase -> Float in
+            let accents = stride(from: phase, to: strengths.count, by: 4).map { strengths[$0] }
+            return accents.reduce(0, +) / Float(accents.count)
+        }
+        let average = phaseStrengths.reduce(0, +) / 4
+        guard let phase = phaseStrengths.indices.max(by: { phaseStrengths[$0] < phaseStrengths[$1] }),
+              phaseStrengths[phase] >= average * downbeatAccent else { return [] }
+
+        return stride(from: phase, to: beats.count, by: 4).map { beats[$0] }
+    }
+}
@@ -0,0 +1,187 @@
+import Foundation
+
+/**
+ * ExactRepeatHasher
+ *
+ * Finds passages that repeat sample for sample, as in ripped game music
+ * where the loop was simply written out twice. A rolling hash of the last
+ * `windowFrames` samples of the first channel is kept per frame; windows
+ * whose hash falls on a content-defined anchor are remembered, and a later
+ * window with the same hash marks a repeat at that lag. Matches at one lag
+ * are merged into runs, so memory is one entry per ~`anchorSpacing`
+ * frames rather than the audio itself.
+ */
+final class ExactRepeatHasher: AnalysisConsumer {
+    /// A passage that occurs twice
+    struct Repeat {
+        /// Where the passage first occurs
+        let sourceFrame: Int
+
+        /// Where it occurs again
+        let repeatFrame: Int
+
+        /// Length of the repeated passage
+        let frameCount: Int
+
+        /// Distance between the two occurrences
+        var lag: Int {
+            return repeatFrame - sourceFrame
+        }
+    }
+
+    /// Samples hashed per window
+    let windowFrames: Int
+
+    /// Average frames between anchors (a power of two)
+    let anchorSpacing: Int
+
+    /// Shortest run reported
+    let minimumFrames: Int
+
+    /// Repeats found, longest first (filled in by `finish`)
+    private(set) var repeats: [Repeat] = []
+
+    // Rolling hash over sample bit patterns: h = Σ x[i]·B^(W-1-i) mod 2^64
+    private static let base: UInt64 = 0x100000001b3
+    private let outgoingFactor: UInt64
+    private var hash: UInt64 = 0
+    private var history: [UInt32]
+    private var historyIndex = 0
+    private var framesSeen = 0
+
+    /// Samples in the window loud enough to count; near-silent windows are skipped
+    private var audibleCount = 0
+    private static let audibleThreshold: Float = 1e-4
+
+    /// Anchor hash → frame where its window ends
+    private var anchors: [UInt64: Int] = [:]
+
+    /// Run being extended: lag, first matched window start, last matched window end
+    private var runLag = 0
+    private var runStart = 0
+    private var runEnd = 0
+    private var runs: [Repeat] = []
+
+    /**
+     * - Parameters:
+     *   - windowFrames: Samples per hashed window
+     *   - anchorSpacing: Average spacing of remembered windows
+     *   - minimumFrames: Shortest repeat reported
+     */
+    init(windowFrames: Int = 4096, anchorSpacing: Int = 256, minimumFrames: Int = 44100) {
+        self.windowFrames = max(1, windowFrames)
+        var spacing = 1
+        while spacing < max(1, anchorSpacing) {
+            spacing <<= 1
+        }
+        self.anchorSpacing = spacing
+        self.minimumFrames = minimumFrames
+        self.history = [UInt32](repeating: 0, count: self.windowFrames)
+
+        var factor: UInt64 = 1
+        for _ in 0..<(self.windowFrames - 1) {
+            factor = factor &* ExactRepeatHasher.base
+        }
+        self.outgoingFactor = factor
+    }
+
+    // MARK: - AnalysisConsumer
+
+    func begin(sampleRate: Double, channelCount: Int, frameCount: Int) {
+        hash = 0
+        history = [UInt32](repeating: 0, count: windowFrames)
+        historyIndex = 0
+        framesSeen = 0
+        audibleCount = 0
+        anchors = [:]
+        anchors.reserveCapacity(frameCount / anchorSpacing)
+        runLag = 0
+        runs = []
+        repeats = []
+    }
+
+    func consume(_ chunk: AnalysisPipeline.Chunk) {
+        let samples = chunk.samples(0)
+        let anchorMask = UInt64(anchorSpacing - 1)
+        let audibleThreshold = ExactRepeatHasher.audibleThreshold
+        let windowFrames = self.windowFrames
+        let outgoingFactor = self.outgoingFactor
+
+        // Per-sample state lives in locals for the hot loop
+        var hash = self.hash
+        var historyIndex = self.historyIndex
+        var framesSeen = self.framesSeen
+        var audibleCount = self.audibleCount
+
+        history.withUnsafeMutableBufferPointer { history in
+            for index in 0..<chunk.frameCount {
+                let sample = samples[index]
+                let incoming = sample.bitPattern
+
+                // Slide the window: drop the oldest sample, add the new one
+                let outgoing = history[historyIndex]
+                if framesSeen >= windowFrames {
+                    hash = hash &- UInt64(outgoing) &* outgoingFactor
+                    if abs(Float(bitPattern: outgoing)) > audibleThreshold {
+                        audibleCount -= 1
+                    }
+                }
+                hash = hash &* ExactRepeatHasher.base &+ UInt64(incoming)
+                if abs(sample) > audibleThreshold {
+                    audibleCount += 1
+                }
+                history[historyIndex] = incoming
+                historyIndex = historyIndex + 1 == windowFrames ? 0 : historyIndex + 1
+                framesSeen += 1
+
+                // Identical windows have identical hashes, so both sides pick the same anchors
+                guard framesSeen >= windowFrames, hash & anchorMask == 0,
+                      audibleCount * 2 >= windowFrames else { continue }
+
+                if let earlierEnd = anchors[hash] {
+                    extendRun(lag: framesSeen - earlierEnd, windowEnd: framesSeen)
+                } else {
+                    anchors[hash] = framesSeen
+                }
+            }
+        }
+
+        self.hash = hash
+        self.historyIndex = historyIndex
+        self.framesSeen = framesSeen
+        self.audibleCount = audibleCount
+    }
+
+    func finish() {
+        closeRun()
+        anchors = [:]
+        repeats = runs.sorted { $0.frameCount > $1.frameCount }
+        runs = []
+    }
+
+    // MARK: - Runs
+
+    /// Adds a matched window to the current run, or starts a new one
+    private func extendRun(lag: Int, windowEnd: Int) {
+        let windowStart = windowEnd - windowFrames
+
+        // Anchors are sparse, so consecutive matches overlap while the repeat continues
+        if runLag == lag && windowStart <= runEnd {
+            runEnd = windowEnd
+            return
+        }
+
+        closeRun()
+        runLag = lag
+        runStart = windowStart
+        runEnd = windowEnd
+    }
+
+    private func closeRun() {
+        guard runLag > 0 else { return }
+        if runEnd - runStart >= minimumFrames {
+            runs.append(Repeat(sourceFrame: runStart - runLag, repeatFrame: runStart, frameCount: runEnd - runStart))
+        }
+        runLag = 0
+    }
+}
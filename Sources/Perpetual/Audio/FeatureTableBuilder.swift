@@ -0,0 +1,196 @@
+import Accelerate
+import Foundation
+
+/**
+ * FeatureTableBuilder
+ *
+ * Builds the structure analyzer's feature table (RMS, spectral centroid,
+ * spectral flux and zero-crossing rate per window) from streamed chunks.
+ * Only the samples of the window still being filled are kept, and each
+ * window is transformed once: its power spectrum serves both the centroid
+ * and, kept for the next window, the flux. With a decimation above one,
+ * each run of that many samples is averaged into one before windowing.
+ */
+final class FeatureTableBuilder: AnalysisConsumer {
+    let windowSize: Int
+    let hopSize: Int
+    let decimation: Int
+
+    /// Features per window, in order
+    private(set) var features: [MusicStructureAnalyzer.AudioFeatures] = []
+
+    private var sampleRate: Double = 44100
+
+    /// First-channel samples not yet fully consumed by a window
+    private var pending: [Float] = []
+
+    /// Offset into `pending` where the next window starts
+    private var windowStart = 0
+
+    /// Frame in the file of `pending[0]`, at the decimated rate
+    private var pendingOrigin = 0
+
+    /// Samples left over from the last chunk that don't fill a decimation run
+    private var undecimated: [Float] = []
+    private var decimationFilter: [Float]
+
+    // MARK: - STFT
+
+    private let log2n: vDSP_Length
+    private let fftSetup: FFTSetup
+    private var window: [Float]
+    private var windowed: [Float]
+    private var real: [Float]
+    private var imaginary: [Float]
+    private var power: [Float]
+    private var previousPower: [Float]
+    private var difference: [Float]
+    private var binFrequencies: [Float]
+
+    /**
+     * - Parameters:
+     *   - windowSize: Window length in frames at the decimated rate (a power of two)
+     *   - hopSize: Frames between window starts at the decimated rate
+     *   - decimation: Input samples per analyzed sample
+     */
+    init(windowSize: Int = 8192, hopSize: Int = 4096, decimation: Int = 1) {
+        self.log2n = vDSP_Length(log2(Double(windowSize)))
+        self.windowSize = 1 << Int(log2n)
+        self.hopSize = max(1, hopSize)
+        self.decimation = max(1, decimation)
+        self.decimationFilter = [Float](repeating: 1 / Float(max(1, decimation)), count: max(1, decimation))
+        self.fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
+
+        let half = self.windowSize / 2
+        window = [Float](repeating: 0, count: self.windowSize)
+        vDSP_hann_window(&window, vDSP_Length(self.windowSize), Int32(0))
+        windowed = [Float](repeating: 0, count: self.windowSize)
+        real = [Float](repeating: 0, count: half)
+        imaginary = [Float](repeating: 0, count: half)
+        power = [Float](repeating: 0, count: half)
+        previousPower = [Float](repeating: 0, count: half)
+        difference = [Float](repeating: 0, count: half)
+        binFrequencies = []
+    }
+
+    deinit {
+        vDSP_destroy_fftsetup(fftSetup)
+    }
+
+    // MARK: - AnalysisConsumer
+
+    func begin(sampleRate: Double, channelCount: Int, frameCount: Int) {
+        self.sampleRate = sampleRate / Double(decimation)
+        features = []
+        features.reserveCapacity(max(0, (frameCount / decimation - windowSize) / hopSize + 1))
+        pending = []
+        pending.reserveCapacity(windowSize + AnalysisPipeline.defaultChunkFrames)
+        windowStart = 0
+        pendingOrigin = 0
+        undecimated = []
+
+        let binWidth = Float(self.sampleRate) / Float(windowSize)
+        binFrequencies = (0..<windowSize / 2).map { Float($0) * binWidth }
+    }
+
+    func consume(_ chunk: AnalysisPipeline.Chunk) {
+        let samples = UnsafeBufferPointer(start: chunk.samples(0), count: chunk.frameCount)
+        if decimation == 1 {
+            pending.append(contentsOf: samples)
+        } else {
+            appendDecimated(samples)
+        }
+
+        while pending.count - windowStart >= windowSize {
+            analyzeWindow(at: windowStart)
+            windowStart += hopSize
+        }
+
+        // Drop samples no later window needs
+        if windowStart > 0 {
+            let drop = min(windowStart, pending.count)
+            pending.removeFirst(drop)
+            pendingOrigin += drop
+            windowStart -= drop
+        }
+    }
+
+    func finish() {
+        pending = []
+        undecimated = []
+    }
+
+    /// Box-filters and downsamples a chunk onto the end of `pending`
+    private func appendDecimated(_ samples: UnsafeBufferPointer<Float>) {
+        undecimated.append(contentsOf: samples)
+        let outputCount = undecimated.count / decimation
+        guard outputCount > 0 else { return }
+
+        let start = pending.count
+        pending.append(contentsOf: repeatElement(0, count: outputCount))
+        pending.withUnsafeMutableBufferPointer { output in
+            vDSP_desamp(undecimated, vDSP_Stride(decimation), decimationFilter,
+                        output.baseAddress! + start, vDSP_Length(outputCount), vDSP_Length(decimation))
+        }
+        undecimated.removeFirst(outputCount * decimation)
+    }
+
+    // MARK: - Features
+
+    private func analyzeWindow(at offset: Int) {
+        let half = windowSize / 2
+        let isFirst = features.isEmpty
+        var rms: Float = 0
+        var zeroCrossings = 0
+
+        pending.withUnsafeBufferPointer { buffer in
+            let samples = buffer.baseAddress! + offset
+            vDSP_rmsqv(samples, 1, &rms, vDSP_Length(windowSize))
+            vDSP_vmul(samples, 1, window, 1, &windowed, 1, vDSP_Length(windowSize))
+
+            for index in 1..<windowSize where (samples[index] >= 0) != (samples[index - 1] >= 0) {
+                zeroCrossings += 1
+            }
+        }
+
+        // Power spectrum of the windowed frame
+        real.withUnsafeMutableBufferPointer { realPointer in
+            imaginary.withUnsafeMutableBufferPointer { imaginaryPointer in
+                var split = DSPSplitComplex(realp: realPointer.baseAddress!, imagp: imaginaryPointer.baseAddress!)
+                windowed.withUnsafeBufferPointer { input in
+                    input.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: half) { complex in
+                        vDSP_ctoz(complex, 2, &split, 1, vDSP_Length(half))
+                    }
+                }
+                vDSP_fft_zrip(fftSetup, &split, 1, log2n, FFTDirection(FFT_FORWARD))
+                vDSP_zvmags(&split, 1, &power, 1, vDSP_Length(half))
+            }
+        }
+
+        var total: Float = 0
+        var weighted: Float = 0
+        vDSP_sve(power, 1, &total, vDSP_Length(half))
+        vDSP_dotpr(power, 1, binFrequencies, 1, &weighted, vDSP_Length(half))
+
+        // Flux: summed increases in power since the previous window
+        var flux: Float = 0
+        if !isFirst {
+            var zero: Float = 0
+            difference.withUnsafeMutableBufferPointer { buffer in
+                let increases = buffer.baseAddress!
+                vDSP_vsub(previousPower, 1, power, 1, increases, 1, vDSP_Length(half))
+                vDSP_vthr(increases, 1, &zero, increases, 1, vDSP_Length(half))
+                vDSP_sve(increases, 1, &flux, vDSP_Length(half))
+            }
+        }
+        swap(&power, &previousPower)
+
+        features.append(MusicStructureAnalyzer.AudioFeatures(
+            timeOffset: Double(pendingOrigin + offset) / sampleRate,
+            rms: rms,
+            spectralCentroid: total > 0 ? weighted / total : 0,
+            spectralFlux: flux,
+            zeroCrossingRate: Float(zeroCrossings) / Float(windowSize)
+        ))
+    }
+}
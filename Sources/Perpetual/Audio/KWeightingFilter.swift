@@ -0,0 +1,80 @@
+import Accelerate
+import Foundation
+
+/**
+ * KWeightingFilter
+ *
+ * The ITU-R BS.1770 K-weighting curve (a high-shelf pre-filter followed by
+ * the RLB high-pass) as a two-section vDSP biquad cascade. Coefficients are
+ * derived for the actual sample rate rather than hard-coded for 48 kHz.
+ * One instance filters one channel and keeps its state between calls.
+ */
+final class KWeightingFilter {
+    private let setup: vDSP_biquad_Setup
+
+    /// Filter state: two delay elements per section plus two
+    private var delay = [Float](repeating: 0, count: 6)
+
+    init(sampleRate: Double) {
+        setup = vDSP_biquad_CreateSetup(KWeightingFilter.coefficients(sampleRate: sampleRate), 2)!
+    }
+
+    deinit {
+        vDSP_biquad_DestroySetup(setup)
+    }
+
+    /**
+     * Filters `count` samples read from `input` with the given stride (so an
+     * interleaved buffer can be filtered in place per channel) into `output`.
+     */
+    func process(_ input: UnsafePointer<Float>, stride: Int, into output: UnsafeMutablePointer<Float>, count: Int) {
+        guard count > 0 else { return }
+        vDSP_biquad(setup, &delay, input, vDSP_Stride(stride), output, 1, vDSP_Length(count))
+    }
+
+    /// Clears the filter state
+    func reset() {
+        for index in delay.indices {
+            delay[index] = 0
+        }
+    }
+
+    /**
+     * Biquad coefficients for both stages as b0, b1, b2, a1, a2 per section,
+     * computed with the bilinear transform used by the reference implementation.
+     */
+    static func coefficients(sampleRate: Double) -> [Double] {
+        // Stage 1: high-shelf pre-filter
+        var f0 = 1681.974450955533
+        let gain = 3.999843853973347
+        var q = 0.7071752369554196
+        var k = tan(Double.pi * f0 / sampleRate)
+        let vh = pow(10, gain / 20)
+        let vb = pow(vh, 0.4996667741545416)
+        var a0 = 1 + k / q + k * k
+
+        let shelf = [
+            (vh + vb * k / q + k * k) / a0,
+            2 * (k * k - vh) / a0,
+            (vh - vb * k / q + k * k) / a0,
+            2 * (k * k - 1) / a0,
+            (1 - k / q + k * k) / a0
+        ]
+
+        // Stage 2: RLB high-pass
+        f0 = 38.13547087602444
+        q = 0.5003270373238773
+        k = tan(Double.pi * f0 / sampleRate)
+        a0 = 1 + k / q + k * k
+
+        let highPass = [
+            1,
+            -2,
+            1,
+            2 * (k * k - 1) / a0,
+            (1 - k / q + k * k) / a0
+        ]
+
+        return shelf + highPass
+    }
+}
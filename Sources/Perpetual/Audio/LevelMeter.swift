@@ -0,0 +1,271 @@
+import Accelerate
+import Combine
+import Foundation
+import PerpetualCore
+
+/**
+ * LevelMeter
+ *
+ * The UI-side consumer of the renderer's metering ring. Drains the ring on
+ * the main thread and publishes per-channel peak and RMS, momentary loudness
+ * (400 ms, K-weighted, in LUFS) and a coarse log-spaced spectrum at display
+ * rate. All audio-thread work stays in the ring write; everything here runs
+ * off the render thread.
+ */
+final class LevelMeter: ObservableObject {
+    /// A snapshot of the meters
+    struct Levels {
+        /// Per-channel sample peak in dBFS
+        var peak: [Float]
+
+        /// Per-channel RMS in dBFS
+        var rms: [Float]
+
+        /// Momentary loudness in LUFS
+        var momentaryLoudness: Float
+
+        /// Band levels in dB, low to high
+        var spectrum: [Float]
+
+        static func silent(channelCount: Int) -> Levels {
+            return Levels(peak: Array(repeating: LevelMeter.floor, count: channelCount),
+                          rms: Array(repeating: LevelMeter.floor, count: channelCount),
+                          momentaryLoudness: LevelMeter.floor,
+                          spectrum: Array(repeating: LevelMeter.floor, count: LevelMeter.bandCount))
+        }
+    }
+
+    /// Lowest level shown, in dB
+    static let floor: Float = -70
+
+    /// Number of spectrum bands
+    static let bandCount = 24
+
+    /// How fast displayed peaks fall, in dB per second
+    private static let peakFallRate: Float = 24
+
+    private static let fftSize = 2048
+
+    @Published private(set) var levels = Levels.silent(channelCount: 2)
+
+    // MARK: - Source
+
+    private var ring: SPSCSampleRing?
+    private var sampleRate: Double = 44100
+    private var channelCount = 2
+    private var readBuffer: [Float] = []
+
+    // MARK: - Loudness
+
+    private var filters: [KWeightingFilter] = []
+    private var filtered: [Float] = []
+
+    /// K-weighted power of the last four 100 ms blocks, and the block being filled
+    private var blockPowers: [Float] = []
+    private var blockSum: Float = 0
+    private var blockFrames = 0
+
+    // MARK: - Spectrum
+
+    private let log2n = vDSP_Length(log2(Double(LevelMeter.fftSize)))
+    private let fftSetup: FFTSetup
+    private var window = [Float](repeating: 0, count: LevelMeter.fftSize)
+
+    /// Latest mono samples, oldest first
+    private var history = [Float](repeating: 0, count: LevelMeter.fftSize)
+
+    private var lastUpdate = Date()
+
+    init() {
+        fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
+        vDSP_hann_window(&window, vDSP_Length(LevelMeter.fftSize), Int32(vDSP_HANN_NORM))
+    }
+
+    deinit {
+        vDSP_destroy_fftsetup(fftSetup)
+    }
+
+    /**
+     * Starts reading from a renderer's metering ring.
+     */
+    func attach(to ring: SPSCSampleRing?, sampleRate: Double) {
+        self.ring = ring
+        self.sampleRate = sampleRate
+        channelCount = ring?.channelCount ?? 2
+        readBuffer = [Float](repeating: 0, count: (ring?.capacity ?? 0) * channelCount)
+        filtered = [Float](repeating: 0, count: ring?.capacity ?? 0)
+        filters = (0..<channelCount).map { _ in KWeightingFilter(sampleRate: sampleRate) }
+        reset()
+    }
+
+    /**
+     * Drops the meters to silence, e.g. when playback stops.
+     */
+    func reset() {
+        filters.forEach { $0.reset() }
+        blockPowers = []
+        blockSum = 0
+        blockFrames = 0
+        history = [Float](repeating: 0, count: LevelMeter.fftSize)
+        levels = Levels.silent(channelCount: channelCount)
+    }
+
+    /**
+     * Drains the ring and republishes the meters. Call at display rate from
+     * the main thread.
+     */
+    func update() {
+        guard let ring = ring else { return }
+
+        let frames = readBuffer.withUnsafeMutableBufferPointer { buffer in
+            ring.read(into: buffer.baseAddress!, maxFrames: ring.capacity)
+        }
+
+        let now = Date()
+        let elapsed = Float(now.timeIntervalSince(lastUpdate))
+        lastUpdate = now
+
+        var next = levels
+        let fallen = LevelMeter.peakFallRate * elapsed
+
+        for channel in 0..<channelCount {
+            var peak: Float = 0
+            var meanSquare: Float = 0
+            if frames > 0 {
+                readBuffer.withUnsafeBufferPointer { buffer in
+                    let samples = buffer.baseAddress! + channel
+                    vDSP_maxmgv(samples, vDSP_Stride(channelCount), &peak, vDSP_Length(frames))
+                    vDSP_measqv(samples, vDSP_Stride(channelCount), &meanSquare, vDSP_Length(frames))
+                }
+            }
+
+            // Peaks fall back slowly so short transients stay visible
+            next.peak[channel] = max(decibels(peak), levels.peak[channel] - fallen)
+            next.rms[channel] = frames > 0 ? decibels(sqrt(meanSquare)) : LevelMeter.floor
+        }
+
+        if frames > 0 {
+            accumulateLoudness(frames: frames)
+            appendHistory(frames: frames)
+            next.spectrum = spectrum()
+        }
+
+        if !blockPowers.isEmpty {
+            let power = blockPowers.reduce(0, +) / Float(blockPowers.count)
+            next.momentaryLoudness = max(LevelMeter.floor, -0.691 + 10 * log10(max(power, 1e-12)))
+        }
+
+        levels = next
+    }
+
+    // MARK: - Measurements
+
+    private func decibels(_ amplitude: Float) -> Float {
+        return max(LevelMeter.floor, 20 * log10(max(amplitude, 1e-9)))
+    }
+
+    /**
+     * K-weights the new frames and folds their power into 100 ms blocks; the
+     * last four blocks make up the 400 ms momentary window.
+     */
+    private func accumulateLoudness(frames: Int) {
+        let framesPerBlock = max(1, Int(sampleRate / 10))
+        var position = 0
+
+        while position < frames {
+            let count = min(frames - position, framesPerBlock - blockFrames)
+
+            for channel in 0..<channelCount {
+                var sumOfSquares: Float = 0
+                readBuffer.withUnsafeBufferPointer { input in
+                    filtered.withUnsafeMutableBufferPointer { output in
+                        filters[channel].process(input.baseAddress! + position * channelCount + channel,
+                                                 stride: channelCount,
+                                                 into: output.baseAddress!,
+                                                 count: count)
+                        vDSP_svesq(output.baseAddress!, 1, &sumOfSquares, vDSP_Length(count))
+                    }
+                }
+                // BS.1770 weights front channels equally
+                blockSum += sumOfSquares
+            }
+
+            blockFrames += count
+            position += count
+
+            if blockFrames == framesPerBlock {
+                blockPowers.append(blockSum / Float(framesPerBlock))
+                if blockPowers.count > 4 {
+                    blockPowers.removeFirst()
+                }
+                blockSum = 0
+                blockFrames = 0
+            }
+        }
+    }
+
+    /// Appends the mono mix of the new frames to the spectrum history
+    private func appendHistory(frames: Int) {
+        let keep = min(frames, LevelMeter.fftSize)
+        let first = frames - keep
+        var mono = [Float](repeating: 0, count: keep)
+
+        for channel in 0..<channelCount {
+            for index in 0..<keep {
+                mono[index] += readBuffer[(first + index) * channelCount + channel]
+            }
+        }
+
+        history.removeFirst(keep)
+        history.append(contentsOf: mono.map { $0 / Float(channelCount) })
+    }
+
+    /**
+     * Band levels of the history, in log-spaced bands from 40 Hz up to 16 kHz
+     * (or Nyquist).
+     */
+    private func spectrum() -> [Float] {
+        let size = LevelMeter.fftSize
+        let half = size / 2
+        var windowed = [Float](repeating: 0, count: size)
+        vDSP_vmul(history, 1, window, 1, &windowed, 1, vDSP_Length(size))
+
+        var real = [Float](repeating: 0, count: half)
+        var imaginary = [Float](repeating: 0, count: half)
+        var magnitudes = [Float](repeating: 0, count: half)
+
+        real.withUnsafeMutableBufferPointer { realPointer in
+            imaginary.withUnsafeMutableBufferPointer { imaginaryPointer in
+                var split = DSPSplitComplex(realp: realPointer.baseAddress!, imagp: imaginaryPointer.baseAddress!)
+                windowed.withUnsafeBufferPointer { input in
+                    input.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: half) { complex in
+                        vDSP_ctoz(complex, 2, &split, 1, vDSP_Length(half))
+                    }
+                }
+                vDSP_fft_zrip(fftSetup, &split, 1, log2n, FFTDirection(FFT_FORWARD))
+                vDSP_zvabs(&split, 1, &magnitudes, 1, vDSP_Length(half))
+            }
+        }
+
+        let binWidth = sampleRate / Double(size)
+        let lowest = 40.0
+        let highest = min(16000, sampleRate / 2)
+        var bands = [Float](repeating: LevelMeter.floor, count: LevelMeter.bandCount)
+
+        for band in 0..<LevelMeter.bandCount {
+            let low = lowest * pow(highest / lowest, Double(band) / Double(LevelMeter.bandCount))
+            let high = lowest * pow(highest / lowest, Double(band + 1) / Double(LevelMeter.bandCount))
+            let firstBin = max(1, Int(low / binWidth))
+            let lastBin = min(half - 1, max(firstBin, Int(high / binWidth)))
+
+            var peak: Float = 0
+            for bin in firstBin...lastBin {
+                peak = max(peak, magnitudes[bin])
+            }
+            // The packed real FFT scales by 2, the Hann window halves the level
+            bands[band] = decibels(peak / Float(size) * 2)
+        }
+
+        return bands
+    }
+}
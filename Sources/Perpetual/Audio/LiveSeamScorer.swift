@@ -0,0 +1,128 @@
+import AVFoundation
+import Atomics
+import Combine
+import Foundation
+
+/**
+ * LiveSeamScorer
+ *
+ * Scores the loop seam while a loop handle is dragged. Drag updates are
+ * debounced and scored on a private queue with the track's SeamMetrics
+ * engine, whose boundary cache keeps the handle that isn't moving
+ * measured; each update only measures the side being dragged. A newer
+ * request makes every older one stale: pending ones never start and
+ * finished ones are not published.
+ *
+ * Scoring has a budget of about 2 ms. When a full measurement runs over
+ * it, the rest of the drag is scored with a lighter engine (shorter
+ * windows, no chroma) and the readout is marked as an estimate; the
+ * release of the handle is always scored in full.
+ */
+final class LiveSeamScorer: ObservableObject {
+    /// The latest seam quality (0-10), nil when the track can't be scored
+    @Published private(set) var quality: Float?
+
+    /// Whether `quality` came from the lighter engine
+    @Published private(set) var isEstimate = false
+
+    /// Quiet period after a drag update before it is scored
+    static let debounceInterval: TimeInterval = 0.016
+
+    /// Time one live evaluation may take before the lighter engine takes over
+    static let latencyBudget: TimeInterval = 0.002
+
+    private let queue = DispatchQueue(label: "com.perpetual.seamscorer", qos: .userInteractive)
+
+    /// Incremented per request; only the latest one is scored and published
+    private let generation = ManagedAtomic<Int>(0)
+
+    /// Debounced request waiting to run (main thread)
+    private var pendingWork: DispatchWorkItem?
+
+    // Touched only on `queue`; the buffer keeps the engines' samples alive
+    private var buffer: AVAudioPCMBuffer?
+    private var fullEngine: SeamMetrics?
+    private var fastEngine: SeamMetrics?
+    private var overBudget = false
+
+    /**
+     * Scores seams in `buffer` from now on; nil (a streamed track) turns
+     * scoring off. Safe to call from any thread.
+     */
+    func attach(_ buffer: AVAudioPCMBuffer?) {
+        generation.wrappingIncrement(ordering: .relaxed)
+        queue.async {
+            self.buffer = buffer
+            self.overBudget = false
+            if let buffer = buffer, let channelData = buffer.floatChannelData {
+                let frameCount = Int(buffer.frameLength)
+                let sampleRate = buffer.format.sampleRate
+                self.fullEngine = SeamMetrics(samples: channelData[0], frameCount: frameCount, sampleRate: sampleRate)
+                self.fastEngine = SeamMetrics(samples: channelData[0], frameCount: frameCount, sampleRate: sampleRate,
+                                              windowDuration: 0.125, measuresHarmonicContinuity: false)
+            } else {
+                self.fullEngine = nil
+                self.fastEngine = nil
+            }
+            DispatchQueue.main.async {
+                self.quality = nil
+                self.isEstimate = false
+            }
+        }
+    }
+
+    /**
+     * Scores the seam after a drag update, once updates pause for
+     * `debounceInterval`. Call on the main thread.
+     */
+    func update(loopStart: TimeInterval, loopEnd: TimeInterval) {
+        schedule(loopStart: loopStart, loopEnd: loopEnd, final: false, delay: Self.debounceInterval)
+    }
+
+    /**
+     * Scores the seam where the handle was released, in full and without
+     * waiting. Call on the main thread.
+     */
+    func finish(loopStart: TimeInterval, loopEnd: TimeInterval) {
+        schedule(loopStart: loopStart, loopEnd: loopEnd, final: true, delay: 0)
+    }
+
+    private func schedule(loopStart: TimeInterval, loopEnd: TimeInterval, final: Bool, delay: TimeInterval) {
+        pendingWork?.cancel()
+        let request = generation.wrappingIncrementThenLoad(ordering: .relaxed)
+
+        let work = DispatchWorkItem { [weak self] in
+            self?.score(loopStart: loopStart, loopEnd: loopEnd, final: final, request: request)
+        }
+        pendingWork = work
+        queue.asyncAfter(deadline: .now() + delay, execute: work)
+    }
+
+    /// Runs on `queue`
+    private func score(loopStart: TimeInterval, loopEnd: TimeInterval, final: Bool, request: Int) {
+        guard generation.load(ordering: .relaxed) == request,
+              let fullEngine = fullEngine, let fastEngine = fastEngine else { return }
+
+        let estimate = overBudget && !final
+        let engine = estimate ? fastEngine : fullEngine
+        let seam = SeamMetrics.Seam(startFrame: Int(loopStart * engine.sampleRate),
+                                    endFrame: Int(loopEnd * engine.sampleRate))
+
+        let began = DispatchTime.now()
+        let score = engine.score(seam)
+        let elapsed = Double(DispatchTime.now().uptimeNanoseconds - began.uptimeNanoseconds) / 1e9
+
+        if final {
+            // The next drag starts with the full engine again
+            overBudget = false
+        } else if !estimate && elapsed > Self.latencyBudget {
+            overBudget = true
+        }
+
+        DispatchQueue.main.async {
+            guard self.generation.load(ordering: .relaxed) == request else { return }
+            self.quality = score.quality
+            self.isEstimate = estimate
+        }
+    }
+}
@@ -0,0 +1,69 @@
+import Foundation
+
+/**
+ * LoopCandidateStore
+ *
+ * Collects loop candidates as the analysis stages produce them, so each
+ * stage can publish what it has without waiting for the rest. A candidate
+ * for the same seam as one already stored replaces it when it comes from
+ * the same or a later stage; coarse candidates are dropped once the full
+ * search has reported.
+ */
+struct LoopCandidateStore {
+    typealias Candidate = MusicStructureAnalyzer.LoopCandidate
+
+    /// Most candidates kept
+    let capacity: Int
+
+    /// Start and end distance within which two candidates are the same seam
+    let tolerance: TimeInterval
+
+    /// Tagged loops first, then best quality first
+    private(set) var candidates: [Candidate] = []
+
+    init(capacity: Int = 15, tolerance: TimeInterval = 0.01) {
+        self.capacity = capacity
+        self.tolerance = tolerance
+    }
+
+    /**
+     * Adds a stage's candidates.
+     *
+     * - Returns: Whether the stored list changed
+     */
+    @discardableResult
+    mutating func merge(_ incoming: [Candidate]) -> Bool {
+        var changed = false
+        for candidate in incoming {
+            if let index = candidates.firstIndex(where: { isSameSeam($0, candidate) }) {
+                guard candidate.source >= candidates[index].source else { continue }
+                candidates[index] = candidate
+            } else {
+                candidates.append(candidate)
+            }
+            changed = true
+        }
+
+        if changed {
+            candidates.sort { ($0.source == .tagged ? 1 : 0, $0.quality) > ($1.source == .tagged ? 1 : 0, $1.quality) }
+            if candidates.count > capacity {
+                candidates.removeLast(candidates.count - capacity)
+            }
+        }
+        return changed
+    }
+
+    /// Replaces the coarse candidates with the full search's results
+    mutating func finish(with refined: [Candidate]) {
+        candidates.removeAll { $0.source == .coarse }
+        merge(refined)
+    }
+
+    mutating func removeAll() {
+        candidates = []
+    }
+
+    private func isSameSeam(_ a: Candidate, _ b: Candidate) -> Bool {
+        return abs(a.startTime - b.startTime) < tolerance && abs(a.endTime - b.endTime) < tolerance
+    }
+}
@@ -0,0 +1,78 @@
+#if canImport(AVFoundation)
+import AVFoundation
+
+extension LoopExporter {
+    /**
+     * File settings for an export destination, chosen by path extension:
+     * m4a/aac encode to AAC, everything else is written as linear PCM.
+     */
+    static func fileSettings(for url: URL, sampleRate: Double, channelCount: Int) -> [String: Any] {
+        switch url.pathExtension.lowercased() {
+        case "m4a", "aac":
+            return [
+                AVFormatIDKey: kAudioFormatMPEG4AAC,
+                AVSampleRateKey: sampleRate,
+                AVNumberOfChannelsKey: channelCount,
+                AVEncoderBitRateKey: 256_000
+            ]
+        default:
+            return [
+                AVFormatIDKey: kAudioFormatLinearPCM,
+                AVSampleRateKey: sampleRate,
+                AVNumberOfChannelsKey: channelCount,
+                AVLinearPCMBitDepthKey: 24,
+                AVLinearPCMIsFloatKey: false,
+                AVLinearPCMIsBigEndianKey: false,
+                AVLinearPCMIsNonInterleaved: false
+            ]
+        }
+    }
+
+    /**
+     * Streams the export into an audio file, one block at a time. A
+     * cancelled or failed export deletes the partial file.
+     *
+     * - Parameters:
+     *   - url: Destination; the extension picks the encoding
+     *   - progress: Called after each block with 0...1; return false to cancel
+     * - Returns: Number of frames written
+     * - Throws: ExportError, or an AVAudioFile error if the file can't be created
+     */
+    @discardableResult
+    func export(to url: URL, progress: ((Double) -> Bool)? = nil) throws -> Int {
+        guard let format = AVAudioFormat(standardFormatWithSampleRate: source.sampleRate,
+                                         channels: AVAudioChannelCount(source.channelCount)),
+              let buffer = AVAudioPCMBuffer(pcmFormat: format,
+                                            frameCapacity: AVAudioFrameCount(settings.blockSize)),
+              let channels = buffer.floatChannelData else {
+            throw AudioManager.AudioManagerError.invalidFormat
+        }
+
+        // The file is opened and written in a closure so it is closed by the
+        // time a cancelled or failed export removes what it wrote
+        var isCreated = false
+        do {
+            return try { () throws -> Int in
+                let file = try AVAudioFile(forWriting: url,
+                                           settings: LoopExporter.fileSettings(for: url,
+                                                                               sampleRate: source.sampleRate,
+                                                                               channelCount: source.channelCount),
+                                           commonFormat: .pcmFormatFloat32,
+                                           interleaved: false)
+                isCreated = true
+
+                return try run(into: channels, write: { frames in
+                    buffer.frameLength = AVAudioFrameCount(frames)
+                    try file.write(from: buffer)
+                }, progress: progress)
+            }()
+        } catch {
+            // Don't leave a truncated file at the destination
+            if isCreated {
+                try? FileManager.default.removeItem(at: url)
+            }
+            throw error
+        }
+    }
+}
+#endif
@@ -0,0 +1,143 @@
+import Foundation
+import PerpetualCore
+
+/**
+ * LoopExporter
+ *
+ * Renders an extended version of a track — intro, N loop iterations (or a
+ * target length) and a cosine fade-out — through a LoopRenderer in
+ * fixed-size blocks, handing each block to a writer as soon as it is ready.
+ * Memory use is one block regardless of how long the export runs, and
+ * rendering is a plain copy, so exports run many times faster than real time.
+ */
+struct LoopExporter {
+    /// What to render
+    struct Settings {
+        /// Loop region in source frames
+        var loopStartFrame: Int
+        var loopEndFrame: Int
+
+        /// Number of full loop iterations before the fade
+        var iterations: Int = 2
+
+        /// If set, overrides `iterations`: total length of the export, fade included
+        var targetDuration: TimeInterval?
+
+        /// Length of the fade-out, which keeps looping underneath
+        var fadeDuration: TimeInterval = 10
+
+        /// Frames rendered per block
+        var blockSize: Int = 16384
+    }
+
+    /// Errors specific to exporting
+    enum ExportError: Error, LocalizedError {
+        case invalidLoop
+        case cancelled
+        case writeFailed(Error)
+
+        var errorDescription: String? {
+            switch self {
+            case .invalidLoop:
+                return "Loop end must come after loop start"
+            case .cancelled:
+                return "Export was cancelled"
+            case .writeFailed(let error):
+                return "Failed to write export: \(error.localizedDescription)"
+            }
+        }
+    }
+
+    let source: PCMSource
+    let settings: Settings
+
+    /// Frames of the exported audio
+    var totalFrames: Int {
+        let introFrames = max(0, settings.loopStartFrame)
+        let loopFrames = max(0, settings.loopEndFrame - settings.loopStartFrame)
+
+        if let target = settings.targetDuration {
+            return max(introFrames + fadeFrames, Int(target * source.sampleRate))
+        }
+        return introFrames + loopFrames * max(1, settings.iterations) + fadeFrames
+    }
+
+    /// Frames of the fade-out at the end of the export
+    var fadeFrames: Int {
+        return max(0, Int(settings.fadeDuration * source.sampleRate))
+    }
+
+    /**
+     * Renders the export block by block.
+     *
+     * - Parameters:
+     *   - destination: Channel table with room for `settings.blockSize` frames
+     *   - write: Called with the number of frames rendered into `destination`
+     *   - progress: Called after each block with 0...1; return false to cancel
+     * - Returns: Number of frames written
+     * - Throws: ExportError
+     */
+    @discardableResult
+    func run(into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+             write: (Int) throws -> Void,
+             progress: ((Double) -> Bool)? = nil) throws -> Int {
+        let loopStart = max(0, min(settings.loopStartFrame, source.frameCount))
+        let loopEnd = max(0, min(settings.loopEndFrame, source.frameCount))
+        guard loopEnd > loopStart else { throw ExportError.invalidLoop }
+
+        // Loop forever; the export length decides where it stops
+        let renderer = LoopRenderer(pcm: source)
+        renderer.setGraph(SegmentGraph.singleLoop(frameCount: source.frameCount,
+                                                  loopStartFrame: loopStart,
+                                                  loopEndFrame: loopEnd,
+                                                  loopCount: 0))
+        renderer.setRunning(true)
+
+        let streamed = source as? StreamedPCM
+        let total = totalFrames
+        let fadeStart = total - fadeFrames
+        let blockSize = max(1, settings.blockSize)
+        var written = 0
+
+        while written < total {
+            let count = min(blockSize, total - written)
+
+            // Offline rendering outruns the decoder; make the next blocks resident first
+            if let streamed = streamed {
+                streamed.prefetch(renderer.upcomingReads(frames: blockSize * 4))
+                streamed.waitForPrefetch()
+            }
+
+            renderer.render(frameCount: count, into: destination)
+            applyFade(to: destination, count: count, firstFrame: written, fadeStart: fadeStart)
+
+            do {
+                try write(count)
+            } catch {
+                throw ExportError.writeFailed(error)
+            }
+            written += count
+
+            if let progress = progress, !progress(Double(written) / Double(total)) {
+                throw ExportError.cancelled
+            }
+        }
+
+        return written
+    }
+
+    /// Applies the cosine fade-out to the frames of a block that fall inside it
+    private func applyFade(to destination: UnsafePointer<UnsafeMutablePointer<Float>>, count: Int,
+                           firstFrame: Int, fadeStart: Int) {
+        let fadeLength = fadeFrames
+        guard fadeLength > 0, firstFrame + count > fadeStart else { return }
+
+        for index in max(0, fadeStart - firstFrame)..<count {
+            let progress = Float(firstFrame + index - fadeStart) / Float(fadeLength)
+            let gain = cos(min(1, progress) * .pi / 2)
+            for channel in 0..<source.channelCount {
+                destination[channel][index] *= gain
+            }
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#if canImport(AVFoundation)
+import AVFoundation
+import PerpetualCore
+
+extension ResidentPCM {
+    /**
+     * Wraps the channel memory of a de-interleaved float buffer without copying.
+     * The buffer is retained for as long as the ResidentPCM lives.
+     */
+    convenience init?(buffer: AVAudioPCMBuffer) {
+        guard let channelData = buffer.floatChannelData,
+              !buffer.format.isInterleaved else { return nil }
+
+        self.init(channels: channelData,
+                  channelCount: Int(buffer.format.channelCount),
+                  frameCount: Int(buffer.frameLength),
+                  sampleRate: buffer.format.sampleRate,
+                  owner: buffer)
+    }
+}
+
+extension ResidentPCM {
+    /**
+     * Reads a whole file into memory.
+     *
+     * - Throws: AudioManagerError if the file is empty or can't be buffered
+     */
+    convenience init(url: URL) throws {
+        let file = try AVAudioFile(forReading: url)
+        guard file.length > 0 else { throw AudioManager.AudioManagerError.emptyFile }
+        guard let buffer = AVAudioPCMBuffer(pcmFormat: file.processingFormat,
+                                            frameCapacity: AVAudioFrameCount(file.length)) else {
+            throw AudioManager.AudioManagerError.bufferCreationFailed
+        }
+        try file.read(into: buffer)
+
+        guard let channelData = buffer.floatChannelData, !buffer.format.isInterleaved else {
+            throw AudioManager.AudioManagerError.invalidFormat
+        }
+        self.init(channels: channelData,
+                  channelCount: Int(buffer.format.channelCount),
+                  frameCount: Int(buffer.frameLength),
+                  sampleRate: buffer.format.sampleRate,
+                  owner: buffer)
+    }
+}
+
+extension StreamedPCM {
+    /**
+     * Streams a file through the chunk ring. The source opens its own
+     * AVAudioFile, used only on the decode queue.
+     *
+     * - Returns: nil if the file can't be opened or its format can't be buffered
+     */
+    convenience init?(url: URL, chunkFrames: Int = StreamedPCM.defaultChunkFrames,
+                      slotCount: Int = StreamedPCM.defaultSlotCount) {
+        guard let file = try? AVAudioFile(forReading: url),
+              let scratch = AVAudioPCMBuffer(pcmFormat: file.processingFormat,
+                                             frameCapacity: AVAudioFrameCount(chunkFrames)),
+              scratch.floatChannelData != nil else { return nil }
+
+        let channelCount = Int(file.processingFormat.channelCount)
+
+        self.init(channelCount: channelCount,
+                  frameCount: Int(file.length),
+                  sampleRate: file.processingFormat.sampleRate,
+                  decoder: { startFrame, frameCount, destination in
+                      do {
+                          file.framePosition = AVAudioFramePosition(startFrame)
+                          try file.read(into: scratch, frameCount: AVAudioFrameCount(min(frameCount, chunkFrames)))
+                      } catch {
+                          print("Failed to decode chunk at frame \(startFrame): \(error)")
+                          return 0
+                      }
+
+                      guard let source = scratch.floatChannelData else { return 0 }
+                      let decoded = Int(scratch.frameLength)
+                      for channel in 0..<channelCount {
+                          destination[channel].update(from: source[channel], count: decoded)
+                      }
+                      return decoded
+                  },
+                  chunkFrames: chunkFrames,
+                  slotCount: slotCount)
+    }
+}
+
+extension LoopRenderer {
+    /// Standard de-interleaved float format matching the resident PCM
+    var outputFormat: AVAudioFormat? {
+        return AVAudioFormat(standardFormatWithSampleRate: pcm.sampleRate,
+                             channels: AVAudioChannelCount(pcm.channelCount))
+    }
+
+    /**
+     * Creates a source node that pulls from this renderer.
+     *
+     * The render block only rewrites the preallocated pointer table and calls
+     * `render`, so it stays free of locks, allocations and ObjC messaging.
+     */
+    func makeSourceNode() -> AVAudioSourceNode? {
+        guard let format = outputFormat else { return nil }
+        let channelCount = pcm.channelCount
+
+        return AVAudioSourceNode(format: format) { [unowned self] _, _, frameCount, audioBufferList in
+            let buffers = UnsafeMutableAudioBufferListPointer(audioBufferList)
+            guard buffers.count >= channelCount else { return kAudioUnitErr_InvalidParameter }
+
+            for channel in 0..<channelCount {
+                guard let data = buffers[channel].mData else { return kAudioUnitErr_InvalidParameter }
+                self.outputChannels[channel] = data.assumingMemoryBound(to: Float.self)
+            }
+
+            self.render(frameCount: Int(frameCount), into: self.outputChannels)
+            return noErr
+        }
+    }
+}
+
+extension PlaybackDeck {
+    /// Standard de-interleaved float format shared by every hosted renderer
+    var outputFormat: AVAudioFormat? {
+        return AVAudioFormat(standardFormatWithSampleRate: sampleRate,
+                             channels: AVAudioChannelCount(channelCount))
+    }
+
+    /**
+     * Creates a source node that pulls from this deck, with the same
+     * real-time constraints as `LoopRenderer.makeSourceNode()`.
+     */
+    func makeSourceNode() -> AVAudioSourceNode? {
+        guard let format = outputFormat else { return nil }
+        let channelCount = self.channelCount
+
+        return AVAudioSourceNode(format: format) { [unowned self] _, _, frameCount, audioBufferList in
+            let buffers = UnsafeMutableAudioBufferListPointer(audioBufferList)
+            guard buffers.count >= channelCount else { return kAudioUnitErr_InvalidParameter }
+
+            for channel in 0..<channelCount {
+                guard let data = buffers[channel].mData else { return kAudioUnitErr_InvalidParameter }
+                self.outputChannels[channel] = data.assumingMemoryBound(to: Float.self)
+            }
+
+            self.render(frameCount: Int(frameCount), into: self.outputChannels)
+            return noErr
+        }
+    }
+}
+#endif
@@ -6,300 +6,120 @@
 //
 
 import AVFoundation
-import Accelerate
 import Foundation
 
 /// Specialized class for analyzing and debugging loop transitions
 class LoopTransitionAnalyzer {
     private let audioManager: AudioManager
-    private let windowSize: Int = 4096 // ~93ms at 44.1kHz
     
-    init(audioManager: AudioManager) {
-        self.audioManager = audioManager
-    }
-    
-    /// Generate comprehensive debug information about the current loop transition
-    func analyzeLoopTransition() -> String {
-        guard let buffer = audioManager.getPCMBuffer,
-              let channelData = buffer.floatChannelData else {
-            return "Error: No audio buffer available"
+    /// The measured transition at the current loop points
+    struct Report {
+        let fileName: String
+        let loopStart: TimeInterval
+        let loopEnd: TimeInterval
+        let score: SeamMetrics.Score
+        let assessment: String
+        let suggestions: String
+        
+        var metrics: SeamMetrics.Metrics {
+            return score.metrics
         }
         
-        let format = buffer.format
-        
-        let sampleRate = Float(format.sampleRate)
-        let channels = Int(format.channelCount)
-        let channelSamples = channelData[0]
-        
-        // Calculate frame positions
-        let loopEndFrame = Int(audioManager.loopEndTime * Double(sampleRate))
-        let loopStartFrame = Int(audioManager.loopStartTime * Double(sampleRate))
-        let totalFrames = Int(buffer.frameLength)
-        
-        // Ensure we have valid frames to analyze
-        guard loopStartFrame >= 0 && loopEndFrame > loopStartFrame &&
-              loopEndFrame <= totalFrames else {
-            return "Error: Invalid loop points for analysis"
+        /// The quality assessment section
+        var summary: String {
+            return """
+            QUALITY ASSESSMENT
+            -----------------------
+            Overall Score: \(String(format: "%.1f", score.quality))/10
+            Assessment: \(assessment)
+            """
         }
         
-        // Extract samples before loop end and after loop start
-        let preLoopSamples = extractSamples(from: channelSamples, startFrame: max(0, loopEndFrame - windowSize), count: min(windowSize, loopEndFrame))
-        let postLoopSamples = extractSamples(from: channelSamples, startFrame: loopStartFrame, count: min(windowSize, Int(totalFrames - loopStartFrame)))
-        
-        // Basic metrics
-        let preLoopRMS = calculateRMS(preLoopSamples)
-        let postLoopRMS = calculateRMS(postLoopSamples)
-        
-        // Breaking up complex expression
-        let rmsDifference = fabsf(preLoopRMS - postLoopRMS)
-        let maxRMS = max(preLoopRMS, postLoopRMS)
-        let normalizedMaxRMS = max(0.0001, maxRMS)
-        let volumeChange = (rmsDifference / normalizedMaxRMS) * 100
-        
-        // Phase analysis
-        let preLoopEndValue = preLoopSamples.last ?? 0
-        let postLoopStartValue = postLoopSamples.first ?? 0
-        let phaseJump = fabsf(preLoopEndValue - postLoopStartValue)
-        
-        // Zero crossing analysis
-        let preLoopEndsAtZeroCrossing = fabsf(preLoopEndValue) < 0.01
-        let postLoopStartsAtZeroCrossing = fabsf(postLoopStartValue) < 0.01
-        
-        // Spectral analysis
-        let spectralDifference = calculateSpectralDifference(preLoopSamples, postLoopSamples)
-        
-        // Harmonic continuity
-        let harmonicContinuity = calculateHarmonicContinuity(preLoopSamples, postLoopSamples)
-        
-        // RMS envelope continuity
-        let envelopeContinuity = calculateEnvelopeContinuity(preLoopSamples, postLoopSamples)
-        
-        // Loop quality assessment
-        let overallQualityScore = calculateOverallQuality(
-            volumeChange: volumeChange,
-            phaseJump: phaseJump,
-            spectralDifference: spectralDifference,
-            harmonicContinuity: harmonicContinuity,
-            envelopeContinuity: envelopeContinuity
-        )
-        
-        let qualityAssessment = qualityAssessmentString(score: overallQualityScore)
-        let suggestions = generateSuggestions(
-            volumeChange: volumeChange,
-            phaseJump: phaseJump,
-            spectralDifference: spectralDifference,
-            preLoopEndsAtZeroCrossing: preLoopEndsAtZeroCrossing,
-            postLoopStartsAtZeroCrossing: postLoopStartsAtZeroCrossing
-        )
-        
-        // Get filename if available
-        let filename = audioManager.audioFileURL?.lastPathComponent ?? "Unknown file"
-        
-        // Format the results
-        return """
-        LOOP TRANSITION ANALYSIS
-        -----------------------
-        File: \(filename)
-        Loop Start: \(TimeFormatter.formatPrecise(audioManager.loopStartTime))
-        Loop End: \(TimeFormatter.formatPrecise(audioManager.loopEndTime))
-        Loop Duration: \(TimeFormatter.formatPrecise(audioManager.loopEndTime - audioManager.loopStartTime))
-        
-        TECHNICAL METRICS
-        -----------------------
-        Volume Change: \(String(format: "%.2f", volumeChange))% (\(volumeChange < 5 ? "Good" : "Noticeable"))
-        Phase Jump: \(String(format: "%.4f", phaseJump)) (\(phaseJump < 0.1 ? "Good" : "Noticeable"))
-        Zero Crossing at End: \(preLoopEndsAtZeroCrossing ? "Yes (Good)" : "No")
-        Zero Crossing at Start: \(postLoopStartsAtZeroCrossing ? "Yes (Good)" : "No")
-        Spectral Difference: \(String(format: "%.2f", spectralDifference * 100))% (\(spectralDifference < 0.2 ? "Good" : "Noticeable"))
-        Harmonic Continuity: \(String(format: "%.2f", harmonicContinuity * 100))% (\(harmonicContinuity > 0.8 ? "Good" : "Poor"))
-        Envelope Continuity: \(String(format: "%.2f", envelopeContinuity * 100))% (\(envelopeContinuity > 0.8 ? "Good" : "Poor"))
-        
-        QUALITY ASSESSMENT
-        -----------------------
-        Overall Score: \(String(format: "%.1f", overallQualityScore))/10
-        Assessment: \(qualityAssessment)
-        
-        SUGGESTIONS
-        -----------------------
-        \(suggestions)
-        """
-    }
-    
-    // Helper methods
-    
-    private func extractSamples(from buffer: UnsafePointer<Float>, startFrame: Int, count: Int) -> [Float] {
-        var samples = [Float](repeating: 0, count: count)
-        samples.withUnsafeMutableBufferPointer { ptr in
-            ptr.baseAddress!.update(from: buffer.advanced(by: startFrame), count: count)
-        }
-        return samples
-    }
-    
-    private func calculateRMS(_ samples: [Float]) -> Float {
-        var squaredSum: Float = 0
-        vDSP_measqv(samples, 1, &squaredSum, vDSP_Length(samples.count))
-        return sqrt(squaredSum / Float(samples.count))
-    }
-    
-    private func calculateSpectralDifference(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Calculate FFTs
-        let preLoopFFT = calculateFFT(preLoopSamples)
-        let postLoopFFT = calculateFFT(postLoopSamples)
-        
-        // Calculate normalized difference between spectra
-        var totalDifference: Float = 0
-        var totalMagnitude: Float = 0
-        
-        let minSize = min(preLoopFFT.count, postLoopFFT.count)
-        for i in 0..<minSize {
-            let diff = fabsf(preLoopFFT[i] - postLoopFFT[i])
-            totalDifference += diff
-            totalMagnitude += max(preLoopFFT[i], postLoopFFT[i])
+        /// The whole report, as shown and copied by the debug view
+        var text: String {
+            return """
+            LOOP TRANSITION ANALYSIS
+            -----------------------
+            File: \(fileName)
+            Loop Start: \(TimeFormatter.formatPrecise(loopStart))
+            Loop End: \(TimeFormatter.formatPrecise(loopEnd))
+            Loop Duration: \(TimeFormatter.formatPrecise(loopEnd - loopStart))
+            
+            TECHNICAL METRICS
+            -----------------------
+            Volume Change: \(String(format: "%.2f", metrics.volumeChange))% (\(metrics.volumeChange < 5 ? "Good" : "Noticeable"))
+            Phase Jump: \(String(format: "%.4f", metrics.phaseJump)) (\(metrics.phaseJump < 0.1 ? "Good" : "Noticeable"))
+            Zero Crossing at End: \(metrics.zeroEnd ? "Yes (Good)" : "No")
+            Zero Crossing at Start: \(metrics.zeroStart ? "Yes (Good)" : "No")
+            Spectral Difference: \(String(format: "%.2f", metrics.spectralDifference * 100))% (\(metrics.spectralDifference < 0.2 ? "Good" : "Noticeable"))
+            Harmonic Continuity: \(String(format: "%.2f", metrics.harmonicContinuity * 100))% (\(metrics.harmonicContinuity > 0.8 ? "Good" : "Poor"))
+            Envelope Continuity: \(String(format: "%.2f", metrics.envelopeContinuity * 100))% (\(metrics.envelopeContinuity > 0.8 ? "Good" : "Poor"))
+            
+            \(summary)
+            
+            SUGGESTIONS
+            -----------------------
+            \(suggestions)
+            """
         }
-        
-        return totalMagnitude > 0 ? totalDifference / totalMagnitude : 1.0
     }
     
-    private func calculateFFT(_ samples: [Float]) -> [Float] {
-        // Pad to power of 2 if needed
-        let nextPowerOf2 = Int(pow(2, ceil(log2(Float(samples.count)))))
-        var paddedSamples = samples
-        if paddedSamples.count < nextPowerOf2 {
-            paddedSamples.append(contentsOf: [Float](repeating: 0, count: nextPowerOf2 - samples.count))
-        }
-        
-        // Apply window function
-        var windowedSamples = [Float](repeating: 0, count: paddedSamples.count)
-        vDSP_hann_window(&windowedSamples, vDSP_Length(paddedSamples.count), Int32(0))
-        vDSP_vmul(paddedSamples, 1, windowedSamples, 1, &windowedSamples, 1, vDSP_Length(paddedSamples.count))
-        
-        // Setup FFT
-        let log2n = vDSP_Length(log2(Float(paddedSamples.count)))
-        let fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
-        
-        var realp = [Float](repeating: 0, count: paddedSamples.count/2)
-        var imagp = [Float](repeating: 0, count: paddedSamples.count/2)
-        var splitComplex = DSPSplitComplex(realp: &realp, imagp: &imagp)
-        
-        // Convert to split complex format
-        windowedSamples.withUnsafeBufferPointer { ptr in
-            ptr.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: paddedSamples.count/2) { complexPtr in
-                vDSP_ctoz(complexPtr, 2, &splitComplex, 1, vDSP_Length(paddedSamples.count/2))
+    enum AnalysisError: Error, LocalizedError {
+        case noBuffer
+        case invalidLoopPoints
+        
+        var errorDescription: String? {
+            switch self {
+            case .noBuffer:
+                return "No audio buffer available"
+            case .invalidLoopPoints:
+                return "Invalid loop points for analysis"
             }
         }
-        
-        // Perform forward FFT
-        vDSP_fft_zrip(fftSetup, &splitComplex, 1, log2n, FFTDirection(FFT_FORWARD))
-        
-        // Calculate magnitude spectrum
-        var magnitudes = [Float](repeating: 0, count: paddedSamples.count/2)
-        vDSP_zvmags(&splitComplex, 1, &magnitudes, 1, vDSP_Length(paddedSamples.count/2))
-        
-        // Cleanup
-        vDSP_destroy_fftsetup(fftSetup)
-        
-        return magnitudes
     }
     
-    private func calculateHarmonicContinuity(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Get frequency spectra
-        let preLoopFFT = calculateFFT(preLoopSamples)
-        let postLoopFFT = calculateFFT(postLoopSamples)
-        
-        // Focus on lower frequencies (harmonics)
-        let harmonicRange = min(preLoopFFT.count, postLoopFFT.count) / 4
-        
-        // Find correlation between harmonic content
-        var correlation: Float = 0
-        var normPre: Float = 0
-        var normPost: Float = 0
-        
-        for i in 0..<harmonicRange {
-            correlation += preLoopFFT[i] * postLoopFFT[i]
-            normPre += preLoopFFT[i] * preLoopFFT[i]
-            normPost += postLoopFFT[i] * postLoopFFT[i]
-        }
-        
-        let normalization = sqrt(normPre * normPost)
-        return normalization > 0 ? correlation / normalization : 0
+    init(audioManager: AudioManager) {
+        self.audioManager = audioManager
     }
     
-    private func calculateEnvelopeContinuity(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Divide samples into small segments and compare RMS values
-        let segmentSize = 128 // ~3ms at 44.1kHz
-        let preSegmentCount = preLoopSamples.count / segmentSize
-        let postSegmentCount = postLoopSamples.count / segmentSize
-        
-        guard preSegmentCount > 0 && postSegmentCount > 0 else { return 0 }
-        
-        var preEnvelope = [Float]()
-        var postEnvelope = [Float]()
-        
-        // Calculate RMS envelope for pre-loop
-        for i in 0..<preSegmentCount {
-            let startIdx = i * segmentSize
-            let endIdx = min(startIdx + segmentSize, preLoopSamples.count)
-            let segment = Array(preLoopSamples[startIdx..<endIdx])
-            preEnvelope.append(calculateRMS(segment))
-        }
-        
-        // Calculate RMS envelope for post-loop
-        for i in 0..<postSegmentCount {
-            let startIdx = i * segmentSize
-            let endIdx = min(startIdx + segmentSize, postLoopSamples.count)
-            let segment = Array(postLoopSamples[startIdx..<endIdx])
-            postEnvelope.append(calculateRMS(segment))
+    /**
+     * Measures the transition at the current loop points with the same
+     * SeamMetrics engine the loop search ranks candidates with, so the
+     * report agrees with the analyzer's quality scores.
+     */
+    func analyzeLoopTransition() throws -> Report {
+        guard let buffer = audioManager.getPCMBuffer,
+              let channelData = buffer.floatChannelData else {
+            throw AnalysisError.noBuffer
         }
         
-        // Compare the end of pre-envelope with start of post-envelope
-        let comparisonLength = min(3, min(preEnvelope.count, postEnvelope.count))
-        var continuity: Float = 1.0
+        let sampleRate = buffer.format.sampleRate
+        let totalFrames = Int(buffer.frameLength)
+        let seam = SeamMetrics.Seam(startFrame: Int(audioManager.loopStartTime * sampleRate),
+                                    endFrame: Int(audioManager.loopEndTime * sampleRate))
         
-        if comparisonLength > 0 {
-            let preEnd = Array(preEnvelope.suffix(comparisonLength))
-            let postStart = Array(postEnvelope.prefix(comparisonLength))
-            
-            var totalDiff: Float = 0
-            var totalValue: Float = 0
-            
-            for i in 0..<comparisonLength {
-                totalDiff += fabsf(preEnd[i] - postStart[i])
-                totalValue += max(preEnd[i], postStart[i])
-            }
-            
-            continuity = totalValue > 0 ? 1.0 - (totalDiff / totalValue) : 0
+        // Ensure we have valid frames to analyze
+        guard seam.startFrame >= 0 && seam.endFrame > seam.startFrame && seam.endFrame < totalFrames else {
+            throw AnalysisError.invalidLoopPoints
         }
         
-        return continuity
-    }
-    
-    private func calculateOverallQuality(
-        volumeChange: Float,
-        phaseJump: Float,
-        spectralDifference: Float,
-        harmonicContinuity: Float,
-        envelopeContinuity: Float
-    ) -> Float {
-        // Weight factors
-        let volumeWeight: Float = 0.15
-        let phaseWeight: Float = 0.2
-        let spectralWeight: Float = 0.25
-        let harmonicWeight: Float = 0.25
-        let envelopeWeight: Float = 0.15
-        
-        // Convert each metric to a 0-10 scale
-        let volumeScore = 10.0 * (1.0 - min(1.0, volumeChange / 100.0))
-        let phaseScore = 10.0 * (1.0 - min(1.0, phaseJump * 5.0))
-        let spectralScore = 10.0 * (1.0 - min(1.0, spectralDifference * 2.0))
-        let harmonicScore = 10.0 * harmonicContinuity
-        let envelopeScore = 10.0 * envelopeContinuity
-        
-        // Weighted average
-        return volumeWeight * volumeScore +
-               phaseWeight * phaseScore +
-               spectralWeight * spectralScore +
-               harmonicWeight * harmonicScore +
-               envelopeWeight * envelopeScore
+        // The buffer outlives the engine, which only reads the first channel while scoring
+        let score = SeamMetrics(samples: channelData[0], frameCount: totalFrames, sampleRate: sampleRate).score(seam)
+        
+        return Report(
+            fileName: audioManager.audioFileURL?.lastPathComponent ?? "Unknown file",
+            loopStart: audioManager.loopStartTime,
+            loopEnd: audioManager.loopEndTime,
+            score: score,
+            assessment: qualityAssessmentString(score: score.quality),
+            suggestions: generateSuggestions(
+                volumeChange: score.metrics.volumeChange,
+                phaseJump: score.metrics.phaseJump,
+                spectralDifference: score.metrics.spectralDifference,
+                preLoopEndsAtZeroCrossing: score.metrics.zeroEnd,
+                postLoopStartsAtZeroCrossing: score.metrics.zeroStart
+            )
+        )
     }
     
     private func qualityAssessmentString(score: Float) -> String {
@@ -0,0 +1,254 @@
+import Accelerate
+import Foundation
+
+/**
+ * LoudnessAccumulator
+ *
+ * EBU R128 loudness of a whole file, measured as it streams through the
+ * analysis pipeline: integrated loudness (ITU-R BS.1770 gating), maximum
+ * short-term loudness, loudness range (EBU Tech 3342) and true peak. Only
+ * the K-weighted power of each 100 ms block is kept; the gated 400 ms and
+ * 3 s windows are assembled from those when the stream ends.
+ */
+final class LoudnessAccumulator: AnalysisConsumer {
+    /// The measurements of one file
+    struct Measurement: Codable, Equatable {
+        /// Gated loudness over the whole file in LUFS (nil for silence)
+        var integratedLoudness: Float?
+
+        /// Loudest 3 s window in LUFS
+        var maxShortTermLoudness: Float?
+
+        /// Spread of short-term loudness in LU
+        var loudnessRange: Float?
+
+        /// Largest inter-sample peak in dBTP
+        var truePeak: Float
+
+        /// Largest sample in dBFS
+        var samplePeak: Float
+
+        /**
+         * Linear gain that brings the file to `target` LUFS without pushing
+         * its true peak above `ceiling` dBTP. Unity for silence.
+         */
+        func normalizationGain(target: Float = LoudnessAccumulator.defaultTarget,
+                               ceiling: Float = -1) -> Float {
+            guard let integrated = integratedLoudness else { return 1 }
+            let decibels = min(target - integrated, ceiling - truePeak)
+            return pow(10, decibels / 20)
+        }
+    }
+
+    /// Default normalization target in LUFS
+    static let defaultTarget: Float = -16
+
+    /// Oversampling factor of the true-peak meter
+    static let oversampling = 4
+
+    /// Taps per polyphase branch of the true-peak interpolator
+    static let tapsPerPhase = 12
+
+    /// The result, once the stream has ended
+    private(set) var measurement: Measurement?
+
+    /// K-weighted mean square of every complete 100 ms block
+    private(set) var blockPowers: [Float] = []
+
+    private var filters: [KWeightingFilter] = []
+    private var filtered: [Float] = []
+    private var framesPerBlock = 4410
+    private var blockSum: Float = 0
+    private var blockFrames = 0
+    private var samplePeak: Float = 0
+
+    // MARK: - True Peak
+
+    /// Polyphase branches, each reversed for vDSP_conv
+    private let phases: [[Float]] = LoudnessAccumulator.interpolationPhases()
+
+    /// Per channel: the last `tapsPerPhase - 1` samples, followed by the current chunk
+    private var extended: [[Float]] = []
+    private var interpolated: [Float] = []
+    private var truePeak: Float = 0
+
+    // MARK: - AnalysisConsumer
+
+    func begin(sampleRate: Double, channelCount: Int, frameCount: Int) {
+        filters = (0..<channelCount).map { _ in KWeightingFilter(sampleRate: sampleRate) }
+        framesPerBlock = max(1, Int(sampleRate / 10))
+        blockPowers = []
+        blockPowers.reserveCapacity(frameCount / framesPerBlock + 1)
+        blockSum = 0
+        blockFrames = 0
+        samplePeak = 0
+        truePeak = 0
+        extended = Array(repeating: [Float](repeating: 0, count: LoudnessAccumulator.tapsPerPhase - 1),
+                         count: channelCount)
+        measurement = nil
+    }
+
+    func consume(_ chunk: AnalysisPipeline.Chunk) {
+        if filtered.count < chunk.frameCount {
+            filtered = [Float](repeating: 0, count: chunk.frameCount)
+            interpolated = [Float](repeating: 0, count: chunk.frameCount)
+        }
+
+        let channelCount = min(chunk.channelCount, filters.count)
+        for channel in 0..<channelCount {
+            measureTruePeak(chunk.samples(channel), count: chunk.frameCount, channel: channel)
+        }
+
+        var position = 0
+        while position < chunk.frameCount {
+            let count = min(chunk.frameCount - position, framesPerBlock - blockFrames)
+
+            for channel in 0..<channelCount {
+                let samples = chunk.samples(channel) + position
+                var channelPeak: Float = 0
+                var sumOfSquares: Float = 0
+                vDSP_maxmgv(samples, 1, &channelPeak, vDSP_Length(count))
+                samplePeak = max(samplePeak, channelPeak)
+
+                filtered.withUnsafeMutableBufferPointer { output in
+                    filters[channel].process(samples, stride: 1, into: output.baseAddress!, count: count)
+                    vDSP_svesq(output.baseAddress!, 1, &sumOfSquares, vDSP_Length(count))
+                }
+                // BS.1770 weights front channels equally
+                blockSum += sumOfSquares
+            }
+
+            blockFrames += count
+            position += count
+
+            if blockFrames == framesPerBlock {
+                blockPowers.append(blockSum / Float(framesPerBlock))
+                blockSum = 0
+                blockFrames = 0
+            }
+        }
+    }
+
+    func finish() {
+        let shortTerm = LoudnessAccumulator.shortTermLoudness(of: blockPowers)
+        measurement = Measurement(integratedLoudness: LoudnessAccumulator.integratedLoudness(of: blockPowers),
+                                  maxShortTermLoudness: shortTerm.max(),
+                                  loudnessRange: LoudnessAccumulator.loudnessRange(of: shortTerm),
+                                  truePeak: 20 * log10(max(max(truePeak, samplePeak), 1e-9)),
+                                  samplePeak: 20 * log10(max(samplePeak, 1e-9)))
+    }
+
+    /**
+     * Upsamples one channel of a chunk 4× through the polyphase interpolator
+     * and tracks the largest magnitude. Each branch is one vDSP_conv over the
+     * chunk plus the previous chunk's tail.
+     */
+    private func measureTruePeak(_ samples: UnsafePointer<Float>, count: Int, channel: Int) {
+        let history = LoudnessAccumulator.tapsPerPhase - 1
+        extended[channel].append(contentsOf: UnsafeBufferPointer(start: samples, count: count))
+
+        extended[channel].withUnsafeBufferPointer { input in
+            interpolated.withUnsafeMutableBufferPointer { output in
+                for phase in phases {
+                    var peak: Float = 0
+                    vDSP_conv(input.baseAddress!, 1, phase, 1, output.baseAddress!, 1,
+                              vDSP_Length(count), vDSP_Length(phase.count))
+                    vDSP_maxmgv(output.baseAddress!, 1, &peak, vDSP_Length(count))
+                    truePeak = max(truePeak, peak)
+                }
+            }
+        }
+
+        extended[channel].removeFirst(extended[channel].count - history)
+    }
+
+    // MARK: - Gating
+
+    /// Loudness of a mean-square power in LUFS
+    static func loudness(ofPower power: Float) -> Float {
+        return -0.691 + 10 * log10(max(power, 1e-12))
+    }
+
+    /// Mean power of every run of `length` consecutive blocks
+    private static func slidingMeans(of blockPowers: [Float], length: Int) -> [Float] {
+        guard blockPowers.count >= length else { return [] }
+        var means: [Float] = []
+        means.reserveCapacity(blockPowers.count - length + 1)
+
+        var sum = blockPowers[0..<length].reduce(0, +)
+        means.append(sum / Float(length))
+        for index in length..<blockPowers.count {
+            sum += blockPowers[index] - blockPowers[index - length]
+            means.append(max(0, sum) / Float(length))
+        }
+        return means
+    }
+
+    /**
+     * Gated integrated loudness of 100 ms block powers: 400 ms blocks with
+     * 75% overlap, an absolute gate at -70 LUFS and a relative gate 10 LU
+     * below the loudness of the blocks that pass it.
+     */
+    static func integratedLoudness(of blockPowers: [Float]) -> Float? {
+        let gatingBlocks = slidingMeans(of: blockPowers, length: 4)
+
+        let audible = gatingBlocks.filter { loudness(ofPower: $0) > -70 }
+        guard !audible.isEmpty else { return nil }
+
+        let relativeGate = loudness(ofPower: audible.reduce(0, +) / Float(audible.count)) - 10
+        let gated = audible.filter { loudness(ofPower: $0) > relativeGate }
+        guard !gated.isEmpty else { return nil }
+
+        return loudness(ofPower: gated.reduce(0, +) / Float(gated.count))
+    }
+
+    /// Short-term (3 s) loudness every 100 ms, in LUFS
+    static func shortTermLoudness(of blockPowers: [Float]) -> [Float] {
+        return slidingMeans(of: blockPowers, length: 30).map { loudness(ofPower: $0) }
+    }
+
+    /**
+     * Loudness range: the spread between the 10th and 95th percentiles of
+     * short-term loudness, after an absolute gate at -70 LUFS and a relative
+     * gate 20 LU below the gated mean.
+     */
+    static func loudnessRange(of shortTerm: [Float]) -> Float? {
+        let audible = shortTerm.filter { $0 > -70 }
+        guard !audible.isEmpty else { return nil }
+
+        let meanPower = audible.map { pow(10, ($0 + 0.691) / 10) }.reduce(0, +) / Float(audible.count)
+        let relativeGate = loudness(ofPower: meanPower) - 20
+        let gated = audible.filter { $0 > relativeGate }.sorted()
+        guard gated.count > 1 else { return nil }
+
+        let low = gated[Int(Float(gated.count - 1) * 0.10)]
+        let high = gated[Int(Float(gated.count - 1) * 0.95)]
+        return high - low
+    }
+
+    // MARK: - Interpolator
+
+    /**
+     * Branches of a 48-tap windowed-sinc interpolator (4 × 12 taps, the
+     * structure BS.1770 Annex 2 uses), each normalized to unity DC gain and
+     * reversed so vDSP_conv computes a convolution.
+     */
+    private static func interpolationPhases() -> [[Float]] {
+        let factor = oversampling
+        let length = factor * tapsPerPhase
+        let center = Double(length - 1) / 2
+
+        let taps = (0..<length).map { index -> Double in
+            let x = (Double(index) - center) / Double(factor)
+            let sinc = x == 0 ? 1 : sin(Double.pi * x) / (Double.pi * x)
+            let window = 0.5 - 0.5 * cos(2 * Double.pi * (Double(index) + 0.5) / Double(length))
+            return sinc * window
+        }
+
+        return (0..<factor).map { phase in
+            let branch = stride(from: phase, to: length, by: factor).map { taps[$0] }
+            let sum = branch.reduce(0, +)
+            return branch.reversed().map { Float($0 / sum) }
+        }
+    }
+}
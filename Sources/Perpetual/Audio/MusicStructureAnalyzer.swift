@@ -1,5 +1,6 @@
 import AVFoundation
 import Accelerate
+import Atomics
 import Foundation
 import Combine
 
@@ -22,22 +23,59 @@ class MusicStructureAnalyzer: ObservableObject {
     @Published var error: Error? = nil
     
     // New published properties for transition quality assessment
-    @Published var loopCandidates: [LoopCandidate] = []
+    @Published var loopCandidates: [LoopCandidate] = [] {
+        didSet { snapIndex.setCandidates(loopCandidates) }
+    }
     @Published var transitionQuality: Float = 0
     
+    // True while the suggestion comes from an early pass and may still change
+    @Published var isProvisional: Bool = false
+    
+    // Whole-file measurements from the analysis pass
+    @Published var loudness: LoudnessAccumulator.Measurement? = nil
+    @Published var exactRepeats: [ExactRepeatHasher.Repeat] = []
+    
+    // Beats, downbeats and candidate ends for the loop handles to snap to
+    @Published var snapIndex = SnapIndex()
+    
     // Audio features
     private var audioBuffer: AVAudioPCMBuffer? = nil
+    private var seamMetrics: SeamMetrics? = nil
     private var audioFormat: AVAudioFormat? = nil
     private var sampleRate: Double = 44100
     private var features: [AudioFeatures] = []
     private var similarityMatrix: [[Float]]? = nil
     
+    /// Waveform summary from the last analysis
+    private(set) var waveform: WaveformPyramid? = nil
+    
+    /// Sample-exact repeats from the last analysis
+    private var repeatMatches: [ExactRepeatHasher.Repeat] = []
+    
+    /// Candidates from every stage so far, merged as they arrive
+    private var candidateStore = LoopCandidateStore()
+    
+    /// Loop pairs suggested by repeating patterns in the similarity matrix
+    private var patternPairs: [(start: TimeInterval, end: TimeInterval)] = []
+    
     // Analysis parameters
-    private let windowSize: Int = 8192  // For feature extraction
-    private let hopSize: Int = 4096     // 50% overlap
-    private let minSectionDuration: Double = 2.0 // Minimum section length in seconds
+    let configuration: AnalysisConfiguration
+    private var hopSize: Int { configuration.featureHop }  // Frames per feature at the file's rate
+    private var minSectionDuration: Double { configuration.minSectionDuration }
     private let transitionAnalysisWindowSize: Int = 4096 // For loop transition analysis
     
+    // Coarse-to-fine loop search
+    private var coarseContextFrames: Int { configuration.coarseContextFrames }
+    private var coarseSurvivorCount: Int { configuration.coarseSurvivorCount }
+    private var refinementHopSize: Int { configuration.refinementHopSize }
+    private let refinementFFTSize: Int = 2048
+    private let refinementContextFrames: Int = 4    // STFT frames compared on each side of a seam
+    private var refinedSurvivorCount: Int { configuration.refinedSurvivorCount }
+    private let correlationWindowSize: Int = 2048   // Samples cross-correlated to settle the offset
+    private let zeroCrossingSearchFrames: Int = 256 // How far a seam may slide to start on a zero crossing
+    private let quickRepeatCount: Int = 4           // Exact repeats measured in the first pass
+    private let quickCoarseCount: Int = 5           // Feature-ranked pairs shown in the first pass
+    
     // New struct to represent and rank loop candidates
     struct LoopCandidate: Identifiable {
         var id = UUID()
@@ -46,6 +84,24 @@ class MusicStructureAnalyzer: ObservableObject {
         var quality: Float
         var metrics: TransitionMetrics
         
+        /// Analysis stage that found the candidate
+        var source: Source = .refined
+        
+        /// False while `metrics` are placeholders and `quality` an estimate
+        var isMeasured: Bool = true
+        
+        /// Stages in the order their results supersede one another
+        enum Source: Int, Comparable {
+            case coarse       // Feature-level ranking only
+            case exactRepeat  // Sample-identical passages
+            case refined      // Full coarse-to-fine search
+            case tagged       // Loop points in the file's metadata
+            
+            static func < (lhs: Source, rhs: Source) -> Bool {
+                return lhs.rawValue < rhs.rawValue
+            }
+        }
+        
         struct TransitionMetrics {
             var volumeChange: Float
             var phaseJump: Float
@@ -80,6 +136,13 @@ class MusicStructureAnalyzer: ObservableObject {
         }
     }
     
+    /**
+     * - Parameter configuration: Resolution and search settings (defaults to the balanced preset)
+     */
+    init(configuration: AnalysisConfiguration = .balanced) {
+        self.configuration = configuration
+    }
+    
     /**
      * Analyzes an audio file to find its structure and suggest optimal loop points.
      *
@@ -88,42 +151,88 @@ class MusicStructureAnalyzer: ObservableObject {
      */
     func analyzeAudioFile(_ url: URL) async throws {
         // Reset state
+        candidateStore.removeAll()
         DispatchQueue.main.async {
             self.isAnalyzing = true
+            self.isProvisional = false
             self.progress = 0
             self.error = nil
             self.sections = []
             self.loopCandidates = []
+            self.snapIndex = SnapIndex()
         }
         
         do {
-            // Load audio file
-            let audioFile = try AVAudioFile(forReading: url)
-            let processingFormat = audioFile.processingFormat
-            
-            DispatchQueue.main.async {
-                self.sampleRate = processingFormat.sampleRate
-                self.audioFormat = processingFormat
+            // Decode once; every whole-file measurement is taken from the same chunks
+            guard let pipeline = AnalysisPipeline(url: url) else {
+                throw NSError(domain: "MusicStructureAnalyzer", code: 1, userInfo:
+                             [NSLocalizedDescriptionKey: "Failed to open audio file"])
             }
+            let frameCount = pipeline.frameCount
             
-            // Load entire file into buffer for analysis
-            let frameCount = audioFile.length
-            guard let buffer = AVAudioPCMBuffer(pcmFormat: audioFile.processingFormat,
-                                              frameCapacity: AVAudioFrameCount(frameCount)) else {
+            // Loop points written by the composer's tools are shown before decoding starts
+            await publishTaggedLoop(in: url, sampleRate: pipeline.sampleRate, frameCount: frameCount)
+            
+            // Transition scoring still needs random access to the first channel
+            guard let format = AVAudioFormat(standardFormatWithSampleRate: pipeline.sampleRate, channels: 1),
+                  let buffer = AVAudioPCMBuffer(pcmFormat: format, frameCapacity: AVAudioFrameCount(frameCount)),
+                  let captureTarget = buffer.floatChannelData?[0] else {
                 throw NSError(domain: "MusicStructureAnalyzer", code: 1, userInfo:
                              [NSLocalizedDescriptionKey: "Failed to create audio buffer"])
             }
             
-            try audioFile.read(into: buffer)
+            let featureTable = FeatureTableBuilder(windowSize: configuration.windowSize,
+                                                   hopSize: configuration.hopSize,
+                                                   decimation: configuration.decimation)
+            let loudness = LoudnessAccumulator()
+            let repeatHasher = ExactRepeatHasher(minimumFrames: Int(minSectionDuration * pipeline.sampleRate))
+            let pyramid = WaveformPyramid()
+            let capture = ChannelCapture(channel: 0, into: captureTarget, capacity: frameCount)
+            pipeline.add(capture)
+            pipeline.add(featureTable)
+            pipeline.add(loudness)
+            pipeline.add(repeatHasher)
+            pipeline.add(pyramid)
+            
+            // Features are ready as soon as decoding finishes (0-30% of the analysis)
+            try pipeline.run { fraction in
+                DispatchQueue.main.async { self.progress = fraction * 0.3 }
+                return !Task.isCancelled
+            }
+            buffer.frameLength = AVAudioFrameCount(capture.capturedFrames)
+            
+            sampleRate = pipeline.sampleRate
+            audioFormat = format
+            audioBuffer = buffer
+            seamMetrics = SeamMetrics(
+                samples: captureTarget, frameCount: capture.capturedFrames, sampleRate: pipeline.sampleRate,
+                measuresHarmonicContinuity: configuration.measuresHarmonicContinuity)
+            features = featureTable.features
+            waveform = pyramid
+            repeatMatches = repeatHasher.repeats
+            
+            // Loudness is needed for normalization on every later load
+            if let measurement = loudness.measurement {
+                AnalysisCache.shared.update(url) { $0.loudness = measurement }
+            }
+            
+            // Beats come from the resident samples, not the preset's coarse feature hop
+            let beatGrid = BeatTracker.track(samples: captureTarget, frameCount: capture.capturedFrames,
+                                             sampleRate: pipeline.sampleRate)
             
             DispatchQueue.main.async {
-                self.audioBuffer = buffer
-                self.progress = 0.1 // 10% progress after loading file
+                self.loudness = loudness.measurement
+                self.exactRepeats = repeatHasher.repeats
+                // Without a steady beat there is nothing to snap to, rather than a grid that drifts
+                self.snapIndex.setBeats(beatGrid?.beats ?? [], downbeats: beatGrid?.downbeats ?? [])
+                self.progress = 0.3
             }
             
-            // Extract features in chunks
-            try await extractAudioFeatures(from: buffer)
-            DispatchQueue.main.async { self.progress = 0.3 }
+            // A provisional loop from what decoding alone produced
+            await publishQuickCandidates()
+            
+            // Stop before the expensive phases if the job was cancelled or preempted
+            try Task.checkCancellation()
             
             // Build self-similarity matrix
             buildSimilarityMatrix()
@@ -134,228 +243,76 @@ class MusicStructureAnalyzer: ObservableObject {
             DispatchQueue.main.async { self.progress = 0.5 }
             
             // Find transition-based loop candidates
+            try Task.checkCancellation()
             await findOptimalLoopCandidates()
             DispatchQueue.main.async { self.progress = 0.8 }
+            try Task.checkCancellation()
             
             // Apply game music heuristics and select best candidate
             selectBestLoopCandidate()
             
+            // Results are published on the main queue; read them after they land
+            let result = await MainActor.run {
+                (start: self.suggestedLoopStart, end: self.suggestedLoopEnd,
+                 quality: self.transitionQuality, candidates: self.loopCandidates.count)
+            }
+            let foundLoop = result.end > result.start
+            
+            // Remember the loop for the play queue and the library
+            if foundLoop {
+                AnalysisCache.shared.update(url, configuration: configuration) {
+                    $0.loopStart = result.start
+                    $0.loopEnd = result.end
+                }
+            }
+            LibraryIndex.shared?.recordAnalysis(of: url,
+                                                loopStart: foundLoop ? result.start : nil,
+                                                loopEnd: foundLoop ? result.end : nil,
+                                                transitionQuality: foundLoop ? result.quality : nil,
+                                                candidateCount: result.candidates,
+                                                loudness: loudness.measurement)
+            
             DispatchQueue.main.async {
                 self.isAnalyzing = false
+                self.isProvisional = false
                 self.progress = 1.0
             }
         } catch {
             DispatchQueue.main.async {
                 self.isAnalyzing = false
+                self.isProvisional = false
                 self.error = error
             }
             throw error
         }
     }
     
-    private func extractAudioFeatures(from buffer: AVAudioPCMBuffer) async throws {
-        guard let channelData = buffer.floatChannelData else {
-            throw NSError(domain: "MusicStructureAnalyzer", code: 2,
-                         userInfo: [NSLocalizedDescriptionKey: "No channel data in buffer"])
-        }
-        
-        // Get samples from the first channel
-        let samples = channelData[0]
-        let totalFrames = Int(buffer.frameLength)
-        
-        // Extract features with larger windows for macro analysis
-        var features: [AudioFeatures] = []
-        let totalWindows = (totalFrames - windowSize) / hopSize + 1
-        
-        for windowIndex in 0..<totalWindows {
-            // Report progress
-            let progress = Double(windowIndex) / Double(totalWindows)
-            DispatchQueue.main.async {
-                self.progress = 0.1 + progress * 0.2 // 10-30% of the analysis process
-            }
-            
-            // Process in batches to avoid blocking the main thread
-            if windowIndex % 10 == 0 {
-                try await Task.sleep(nanoseconds: 1_000_000) // 1ms pause
-            }
-            
-            let startFrame = windowIndex * hopSize
-            let timeOffset = Double(startFrame) / sampleRate
-            
-            // Extract features for this window
-            let windowSamples = Array(UnsafeBufferPointer(start: samples.advanced(by: startFrame), count: windowSize))
-            
-            // Calculate features
-            let rms = calculateRMS(samples: windowSamples)
-            let spectralCentroid = calculateSpectralCentroid(samples: windowSamples, sampleRate: Float(sampleRate))
-            let spectralFlux = windowIndex > 0 ?
-                calculateSpectralFlux(current: windowSamples, previous: Array(UnsafeBufferPointer(start: samples.advanced(by: (windowIndex-1) * hopSize), count: windowSize))) : 0
-            let zcr = calculateZeroCrossingRate(samples: windowSamples)
-            
-            // Store features
-            features.append(AudioFeatures(
-                timeOffset: timeOffset,
-                rms: rms,
-                spectralCentroid: spectralCentroid,
-                spectralFlux: spectralFlux,
-                zeroCrossingRate: zcr
-            ))
-        }
-        
-        DispatchQueue.main.async {
-            self.features = features
-        }
-    }
-    
-    private func calculateRMS(samples: [Float]) -> Float {
-        guard !samples.isEmpty else { return 0 }
-        
-        // Square all values
-        var squaredSamples = [Float](repeating: 0, count: samples.count)
-        vDSP_vsq(samples, 1, &squaredSamples, 1, vDSP_Length(samples.count))
-        
-        // Calculate mean
-        var mean: Float = 0
-        vDSP_meanv(squaredSamples, 1, &mean, vDSP_Length(samples.count))
-        
-        return sqrt(mean)
-    }
-
-    private func calculateSpectralCentroid(samples: [Float], sampleRate: Float) -> Float {
-        // Setup FFT
-        let log2n = vDSP_Length(log2(Float(samples.count)))
-        let fftSize = Int(1 << log2n)
-        
-        // Zero-pad if needed
-        var paddedSamples = samples
-        if samples.count < fftSize {
-            paddedSamples.append(contentsOf: [Float](repeating: 0, count: fftSize - samples.count))
-        }
-        
-        // Apply window function
-        var windowedSamples = [Float](repeating: 0, count: fftSize)
-        vDSP_hann_window(&windowedSamples, vDSP_Length(fftSize), Int32(0))
-        vDSP_vmul(paddedSamples, 1, windowedSamples, 1, &windowedSamples, 1, vDSP_Length(fftSize))
-        
-        // Prepare FFT
-        let fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
-        
-        var realp = [Float](repeating: 0, count: fftSize/2)
-        var imagp = [Float](repeating: 0, count: fftSize/2)
-        var splitComplex = DSPSplitComplex(realp: &realp, imagp: &imagp)
-        
-        // Convert to split complex format
-        windowedSamples.withUnsafeBufferPointer { ptr in
-            ptr.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: fftSize/2) { complexPtr in
-                vDSP_ctoz(complexPtr, 2, &splitComplex, 1, vDSP_Length(fftSize/2))
-            }
-        }
-        
-        // Perform forward FFT
-        vDSP_fft_zrip(fftSetup, &splitComplex, 1, log2n, FFTDirection(FFT_FORWARD))
-        
-        // Calculate magnitude spectrum
-        var magnitudes = [Float](repeating: 0, count: fftSize/2)
-        vDSP_zvmags(&splitComplex, 1, &magnitudes, 1, vDSP_Length(fftSize/2))
-        
-        // Calculate centroid
-        var sum: Float = 0
-        var weightedSum: Float = 0
-        
-        for bin in 0..<fftSize/2 {
-            let frequency = Float(bin) * sampleRate / Float(fftSize)
-            sum += magnitudes[bin]
-            weightedSum += frequency * magnitudes[bin]
-        }
-        
-        vDSP_destroy_fftsetup(fftSetup)
-        
-        return sum > 0 ? weightedSum / sum : 0
-    }
-
-    private func calculateSpectralFlux(current: [Float], previous: [Float]) -> Float {
-        // Setup FFT
-        let log2n = vDSP_Length(log2(Float(current.count)))
-        let fftSize = Int(1 << log2n)
-        
-        // Calculate magnitude spectra for both windows
-        let currentMagnitudes = calculateMagnitudeSpectrum(samples: current, fftSize: fftSize)
-        let previousMagnitudes = calculateMagnitudeSpectrum(samples: previous, fftSize: fftSize)
-        
-        // Calculate spectral flux (squared difference between magnitude spectra)
-        var diff = [Float](repeating: 0, count: currentMagnitudes.count)
-        vDSP_vsub(previousMagnitudes, 1, currentMagnitudes, 1, &diff, 1, vDSP_Length(currentMagnitudes.count))
-        
-        // Rectify - keep only increases in energy (half-wave rectification)
-        for i in 0..<diff.count {
-            diff[i] = max(0, diff[i])
-        }
-        
-        // Sum the differences
-        var sum: Float = 0
-        vDSP_sve(diff, 1, &sum, vDSP_Length(diff.count))
-        
-        return sum
-    }
-
-    private func calculateMagnitudeSpectrum(samples: [Float], fftSize: Int) -> [Float] {
-        // Apply window function
-        var windowedSamples = [Float](repeating: 0, count: fftSize)
-        let samplesCount = min(samples.count, fftSize)
-        
-        // Copy samples to windowed buffer
-        samples.withUnsafeBufferPointer { ptr in
-            windowedSamples.withUnsafeMutableBufferPointer { dst in
-                dst.baseAddress!.update(from: ptr.baseAddress!, count: samplesCount)
-            }
-        }
-        
-        // Apply Hann window
-        var window = [Float](repeating: 0, count: fftSize)
-        vDSP_hann_window(&window, vDSP_Length(fftSize), Int32(0))
-        vDSP_vmul(windowedSamples, 1, window, 1, &windowedSamples, 1, vDSP_Length(fftSize))
-        
-        // Prepare FFT
-        let log2n = vDSP_Length(log2(Float(fftSize)))
-        let fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
-        
-        var realp = [Float](repeating: 0, count: fftSize/2)
-        var imagp = [Float](repeating: 0, count: fftSize/2)
-        var splitComplex = DSPSplitComplex(realp: &realp, imagp: &imagp)
-        
-        // Convert to split complex format
-        windowedSamples.withUnsafeBufferPointer { ptr in
-            ptr.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: fftSize/2) { complexPtr in
-                vDSP_ctoz(complexPtr, 2, &splitComplex, 1, vDSP_Length(fftSize/2))
-            }
-        }
-        
-        // Perform forward FFT
-        vDSP_fft_zrip(fftSetup, &splitComplex, 1, log2n, FFTDirection(FFT_FORWARD))
-        
-        // Calculate magnitude spectrum
-        var magnitudes = [Float](repeating: 0, count: fftSize/2)
-        vDSP_zvmags(&splitComplex, 1, &magnitudes, 1, vDSP_Length(fftSize/2))
-        
-        vDSP_destroy_fftsetup(fftSetup)
+    /**
+     * Similarity of two feature frames, 0 (unrelated) to 1 (identical)
+     */
+    private func featureSimilarity(_ a: AudioFeatures, _ b: AudioFeatures) -> Float {
+        let rmsDiff = a.rms - b.rms
+        let centroidDiff = a.spectralCentroid - b.spectralCentroid
+        let fluxDiff = a.spectralFlux - b.spectralFlux
+        let zcrDiff = a.zeroCrossingRate - b.zeroCrossingRate
+        
+        // Enhanced normalized Euclidean distance with optimized weights for game music
+        // Specifically tuned to emphasize tonal and rhythmic patterns common in OSTs
+        let weights = configuration.featureWeights
+        let distance = sqrt(
+            pow(rmsDiff * weights.rms, 2) +
+            pow(centroidDiff * weights.spectralCentroid, 2) +
+            pow(fluxDiff * weights.spectralFlux, 2) +
+            pow(zcrDiff * weights.zeroCrossingRate, 2)
+        )
         
-        return magnitudes
+        // Convert distance to similarity (higher value = more similar)
+        return 1.0 - min(1.0, distance / 2.0)
     }
 
-    private func calculateZeroCrossingRate(samples: [Float]) -> Float {
-        var count: Int = 0
-        
-        for i in 1..<samples.count {
-            if (samples[i] >= 0 && samples[i-1] < 0) || (samples[i] < 0 && samples[i-1] >= 0) {
-                count += 1
-            }
-        }
-        
-        return Float(count) / Float(samples.count)
-    }
-    
     private func buildSimilarityMatrix() -> [[Float]] {
         let featureCount = features.count
+        patternPairs = []
         var matrix = [[Float]](repeating: [Float](repeating: 0, count: featureCount), count: featureCount)
         
         // 1. Calculate basic similarity matrix with weighted features
@@ -369,23 +326,7 @@ class MusicStructureAnalyzer: ObservableObject {
             }
             
             for j in 0..<featureCount {
-                // Extract features for comparison
-                let rmsDiff = features[i].rms - features[j].rms
-                let centroidDiff = features[i].spectralCentroid - features[j].spectralCentroid
-                let fluxDiff = features[i].spectralFlux - features[j].spectralFlux
-                let zcrDiff = features[i].zeroCrossingRate - features[j].zeroCrossingRate
-                
-                // Enhanced normalized Euclidean distance with optimized weights for game music
-                // Specifically tuned to emphasize tonal and rhythmic patterns common in OSTs
-                let distance = sqrt(
-                    pow(rmsDiff * 1.5, 2) +        // Volume changes
-                    pow(centroidDiff * 1.0, 2) +   // Timbre changes
-                    pow(fluxDiff * 3.0, 2) +       // Heavily emphasize spectral changes
-                    pow(zcrDiff * 0.5, 2)          // Noise vs. tone
-                )
-                
-                // Convert distance to similarity (higher value = more similar)
-                matrix[i][j] = 1.0 - min(1.0, distance / 2.0)
+                matrix[i][j] = featureSimilarity(features[i], features[j])
             }
         }
         
@@ -404,7 +345,7 @@ class MusicStructureAnalyzer: ObservableObject {
         
         for i in filterSize..<(featureCount - filterSize) {
             for j in filterSize..<(featureCount - filterSize) {
-                if matrix[i][j] > 0.7 {  // Only enhance already similar regions
+                if matrix[i][j] > configuration.enhancementThreshold {  // Only enhance already similar regions
                     // Calculate average of diagonal neighborhood
                     var sum: Float = 0
                     var count: Float = 0
@@ -463,7 +404,7 @@ class MusicStructureAnalyzer: ObservableObject {
                     let avgSimilarity = totalSimilarity / Float(sectionLength)
                     
                     // If we found a highly similar region, it's likely a repeating section
-                    if avgSimilarity > 0.75 {
+                    if avgSimilarity > configuration.patternThreshold {
                         patternCandidates.append((startA, endA, startB, endB, avgSimilarity))
                     }
                 }
@@ -507,7 +448,8 @@ class MusicStructureAnalyzer: ObservableObject {
     }
 
     /**
-     * Helper method to add a candidate loop point if it's valid
+     * Helper method to record a pattern-based loop pair if it's valid. Pairs
+     * are scored later by the coarse-to-fine search along with the others.
      */
     private func addCandidateIfValid(_ startTime: TimeInterval, _ endTime: TimeInterval) {
         guard endTime > startTime else { return }
@@ -518,26 +460,15 @@ class MusicStructureAnalyzer: ObservableObject {
         
         // Avoid loops that are too short or too long relative to the track
         if duration >= minSectionDuration && duration <= totalDuration * 0.8 {
-            // Check for existing similar candidates
-            let duplicate = loopCandidates.contains { candidate in
-                abs(candidate.startTime - startTime) < 0.1 &&
-                abs(candidate.endTime - endTime) < 0.1
+            // Check for existing similar pairs
+            let duplicate = patternPairs.contains { pair in
+                abs(pair.start - startTime) < 0.1 &&
+                abs(pair.end - endTime) < 0.1
             }
             
             if !duplicate {
-                // Evaluate transition quality
-                let metrics = evaluateTransitionQuality(loopStart: startTime, loopEnd: endTime)
-                let quality = calculateOverallQuality(metrics: metrics)
-                
-                // Add as a candidate
-                loopCandidates.append(LoopCandidate(
-                    startTime: startTime,
-                    endTime: endTime,
-                    quality: quality,
-                    metrics: metrics
-                ))
-                
-                print("Added pattern-based candidate: \(TimeFormatter.formatPrecise(startTime)) to \(TimeFormatter.formatPrecise(endTime)) with quality: \(quality)")
+                patternPairs.append((startTime, endTime))
+                print("Added pattern-based pair: \(TimeFormatter.formatPrecise(startTime)) to \(TimeFormatter.formatPrecise(endTime))")
             }
         }
     }
@@ -713,20 +644,8 @@ class MusicStructureAnalyzer: ObservableObject {
             candidateEnds.append(point)
         }
         
-        // 2. Add zero crossings near section boundaries for more precise points
-        for sectionTime in candidateStarts.sorted() {
-            let nearbyZeroCrossings = findZeroCrossingsNear(time: sectionTime,
-                                                           samples: samples,
-                                                           window: 0.05) // 50ms window
-            candidateStarts.append(contentsOf: nearbyZeroCrossings)
-        }
-        
-        for sectionTime in candidateEnds.sorted() {
-            let nearbyZeroCrossings = findZeroCrossingsNear(time: sectionTime,
-                                                           samples: samples,
-                                                           window: 0.05)
-            candidateEnds.append(contentsOf: nearbyZeroCrossings)
-        }
+        // 2. Zero crossings are no longer added here: the search settles every
+        // surviving pair on the sample grid itself (see alignPairBySamples)
         
         // 3. Add structurally significant points based on repetition analysis
         await addRepetitionBasedCandidates(to: &candidateStarts, and: &candidateEnds)
@@ -734,62 +653,39 @@ class MusicStructureAnalyzer: ObservableObject {
         // 4. Consider intro detection - look for markers between intro and main content
         await addIntroAwareLoopPoints(to: &candidateStarts, and: &candidateEnds)
         
+        // Passages that decode as exact repeats loop seamlessly from first occurrence to repeat
+        for match in repeatMatches {
+            candidateStarts.append(Double(match.sourceFrame) / sampleRate)
+            candidateEnds.append(Double(match.repeatFrame) / sampleRate)
+        }
+        
+        // Pairs the similarity matrix found repeating
+        for pair in patternPairs {
+            candidateStarts.append(pair.start)
+            candidateEnds.append(pair.end)
+        }
+        
         // Remove duplicates and sort
         candidateStarts = Array(Set(candidateStarts)).sorted()
         candidateEnds = Array(Set(candidateEnds)).sorted()
         
         print("Found \(candidateStarts.count) candidate start points and \(candidateEnds.count) candidate end points")
         
-        // 5. Evaluate all viable start/end combinations
-        var loopCandidates: [LoopCandidate] = []
-        let totalCombinations = candidateStarts.count * candidateEnds.count
-        var progress = 0
+        // 5. Coarse-to-fine search: rank every pair on the cached features, refine
+        // the best on a finer STFT, then settle each survivor's sample offset.
+        // Only the final few pay for the full transition metrics. Each stage
+        // splits its pairs across worker tasks.
+        let coarsePairs = await rankPairsByFeatures(starts: candidateStarts, ends: candidateEnds, totalFrames: totalFrames)
+        DispatchQueue.main.async { self.progress = 0.6 }
+        guard !Task.isCancelled else { return }
         
-        // Limit the number of combinations to evaluate to prevent freezing on large files
-        let maxCombinations = 2000
-        let stride = max(1, totalCombinations / maxCombinations)
+        let refinedPairs = await refinePairsBySpectrum(coarsePairs, samples: samples, totalFrames: totalFrames)
+        DispatchQueue.main.async { self.progress = 0.7 }
+        guard !Task.isCancelled else { return }
         
-        for (startIndex, startTime) in candidateStarts.enumerated() {
-            for (endIndex, endTime) in candidateEnds.enumerated() {
-                // Skip some combinations for performance if we have too many
-                if totalCombinations > maxCombinations && (startIndex * candidateEnds.count + endIndex) % stride != 0 {
-                    continue
-                }
-                
-                // Report progress
-                progress += 1
-                if progress % 20 == 0 {
-                    DispatchQueue.main.async {
-                        self.progress = 0.5 + (0.3 * Double(progress) / Double(min(totalCombinations, maxCombinations)))
-                    }
-                }
-                
-                // Evaluate only valid loop regions
-                if endTime > startTime &&
-                   endTime - startTime >= minSectionDuration &&
-                   endTime - startTime <= Double(totalFrames) / sampleRate * 0.8 {
-                    
-                    // Evaluate transition quality with our improved metrics
-                    let metrics = evaluateTransitionQuality(loopStart: startTime, loopEnd: endTime)
-                    let quality = calculateOverallQuality(metrics: metrics)
-                    
-                    // Add to candidates if quality is reasonable
-                    if quality > 3.0 { // Only keep candidates with at least mediocre quality
-                        loopCandidates.append(LoopCandidate(
-                            startTime: startTime,
-                            endTime: endTime,
-                            quality: quality,
-                            metrics: metrics
-                        ))
-                    }
-                    
-                    // Take a breath to avoid blocking the main thread
-                    if progress % 50 == 0 {
-                        try? await Task.sleep(nanoseconds: 1_000_000) // 1ms pause
-                    }
-                }
-            }
-        }
+        var loopCandidates = await evaluateRefinedPairs(refinedPairs, samples: samples, totalFrames: totalFrames)
+        guard !Task.isCancelled else { return }
+        print("Fully evaluated \(refinedPairs.count) of \(coarsePairs.count) refined pairs")
         
         // 6. Post-process: boost candidates that have musical significance
         loopCandidates = boostMusicallySignificantCandidates(loopCandidates)
@@ -803,8 +699,12 @@ class MusicStructureAnalyzer: ObservableObject {
             loopCandidates = Array(loopCandidates.prefix(topCount))
         }
         
+        // Supersede the first pass's estimates
+        candidateStore.finish(with: loopCandidates)
+        let storedCandidates = candidateStore.candidates
+        
         DispatchQueue.main.async {
-            self.loopCandidates = loopCandidates
+            self.loopCandidates = storedCandidates
             print("Found \(loopCandidates.count) quality loop candidates")
             if let best = loopCandidates.first {
                 print("Best candidate: \(TimeFormatter.formatPrecise(best.startTime)) to \(TimeFormatter.formatPrecise(best.endTime)) with quality \(best.quality)/10")
@@ -812,6 +712,459 @@ class MusicStructureAnalyzer: ObservableObject {
         }
     }
 
+    // MARK: - Progressive Results
+    
+    /**
+     * Suggests the loop stored in the file's tags, if any, before a single
+     * sample has been decoded. Its metrics are measured in the first pass.
+     */
+    private func publishTaggedLoop(in url: URL, sampleRate: Double, frameCount: Int) async {
+        guard let tagged = await TrackPreloader.taggedLoopPoints(in: url, sampleRate: sampleRate,
+                                                                 frameCount: frameCount) else { return }
+        
+        candidateStore.merge([LoopCandidate(startTime: tagged.start, endTime: tagged.end, quality: 10,
+                                            metrics: createDefaultMetrics(poor: false),
+                                            source: .tagged, isMeasured: false)])
+        publishProvisionalCandidates()
+    }
+    
+    /**
+     * First pass, run as soon as decoding finishes: measures the tagged loop
+     * and the longest exact repeats, and ranks phrase-boundary pairs on the
+     * features alone, so there is a loop to show long before the similarity
+     * matrix is built.
+     */
+    private func publishQuickCandidates() async {
+        guard let buffer = audioBuffer else { return }
+        let totalFrames = Int(buffer.frameLength)
+        var quick: [LoopCandidate] = []
+        
+        for tagged in candidateStore.candidates where tagged.source == .tagged {
+            quick.append(measuredCandidate(start: tagged.startTime, end: tagged.endTime, source: .tagged))
+        }
+        
+        // Sample-identical passages loop seamlessly from the first occurrence to the repeat
+        let minimumLag = Int(minSectionDuration * sampleRate)
+        let repeats = repeatMatches
+            .filter { $0.lag >= minimumLag }
+            .sorted { $0.frameCount > $1.frameCount }
+            .prefix(quickRepeatCount)
+        for match in repeats {
+            quick.append(measuredCandidate(start: Double(match.sourceFrame) / sampleRate,
+                                           end: Double(match.repeatFrame) / sampleRate,
+                                           source: .exactRepeat))
+        }
+        
+        // Coarse estimates, replaced when the full search reports
+        let phrasePoints = findMusicalPhrasePoints()
+        let coarsePairs = await rankPairsByFeatures(starts: phrasePoints, ends: phrasePoints, totalFrames: totalFrames)
+        for pair in coarsePairs.prefix(quickCoarseCount) {
+            quick.append(LoopCandidate(startTime: Double(pair.startFrame) / sampleRate,
+                                       endTime: Double(pair.endFrame) / sampleRate,
+                                       quality: pair.score * 10,
+                                       metrics: createDefaultMetrics(poor: false),
+                                       source: .coarse, isMeasured: false))
+        }
+        
+        if candidateStore.merge(quick) {
+            publishProvisionalCandidates()
+        }
+    }
+    
+    private func measuredCandidate(start: TimeInterval, end: TimeInterval, source: LoopCandidate.Source) -> LoopCandidate {
+        guard let seamMetrics = seamMetrics else {
+            let metrics = createDefaultMetrics(poor: true)
+            return LoopCandidate(startTime: start, endTime: end, quality: SeamMetrics.quality(of: metrics),
+                                 metrics: metrics, source: source)
+        }
+        
+        let score = seamMetrics.score(SeamMetrics.Seam(startFrame: Int(start * sampleRate),
+                                                       endFrame: Int(end * sampleRate)))
+        return LoopCandidate(startTime: start, endTime: end, quality: score.quality,
+                             metrics: score.metrics, source: source)
+    }
+    
+    /**
+     * Publishes the stored candidates and suggests the best of them until
+     * the final selection replaces it.
+     */
+    private func publishProvisionalCandidates() {
+        let candidates = candidateStore.candidates
+        guard let best = candidates.first(where: { $0.source == .tagged }) ?? candidates.first else { return }
+        
+        DispatchQueue.main.async {
+            self.loopCandidates = candidates
+            self.suggestedLoopStart = best.startTime
+            self.suggestedLoopEnd = best.endTime
+            self.transitionQuality = best.quality
+            self.isProvisional = true
+        }
+    }
+    
+    // MARK: - Coarse-to-Fine Search
+    
+    /// A loop pair in sample frames, with its score from the latest search stage
+    private struct SeamPair {
+        var startFrame: Int
+        var endFrame: Int
+        var score: Float
+    }
+    
+    /// Workers each stage of the loop search splits its pairs across
+    private var searchWorkerCount: Int {
+        return max(1, ProcessInfo.processInfo.activeProcessorCount)
+    }
+    
+    /**
+     * Stage 1: scores every viable start/end pair on the cached features at
+     * the analysis hop. A seam is good when the music around the end matches
+     * the music around the start, so the frames on both sides are compared.
+     * Starts are grouped by feature frame and the groups dealt out to
+     * workers, each keeping its best pairs in a bounded heap. Returns the
+     * best pairs, spread out so near-duplicates don't crowd out the rest.
+     */
+    private func rankPairsByFeatures(starts: [TimeInterval], ends: [TimeInterval], totalFrames: Int) async -> [SeamPair] {
+        let features = self.features
+        let featureCount = features.count
+        guard featureCount > 0 else { return [] }
+        
+        let sampleRate = self.sampleRate
+        let minDuration = minSectionDuration
+        let context = coarseContextFrames
+        let trackDuration = Double(totalFrames) / sampleRate
+        let framesPerFeature = sampleRate / Double(hopSize)
+        
+        // Points within one hop share a feature frame and score alike, so a
+        // worker owns whole rows of starts and scores each pair of frames once
+        var rowsByFeature: [Int: [TimeInterval]] = [:]
+        for startTime in starts {
+            let startFeature = min(featureCount - 1, Int((startTime * framesPerFeature).rounded()))
+            rowsByFeature[startFeature, default: []].append(startTime)
+        }
+        let rows = rowsByFeature.sorted { $0.key < $1.key }
+        
+        // Room for the near-duplicates bestDistinctPairs drops
+        let heapCapacity = coarseSurvivorCount * 4
+        let workerCount = min(searchWorkerCount, rows.count)
+        var best = BoundedHeap<SeamPair>(capacity: heapCapacity) { $0.score < $1.score }
+        var scoredCount = 0
+        
+        await withTaskGroup(of: (BoundedHeap<SeamPair>, Int).self) { group in
+            for worker in 0..<workerCount {
+                group.addTask {
+                    var heap = BoundedHeap<SeamPair>(capacity: heapCapacity) { $0.score < $1.score }
+                    var scoredEnds = Set<Int>()
+                    var scored = 0
+                    
+                    for rowIndex in stride(from: worker, to: rows.count, by: workerCount) {
+                        if Task.isCancelled { break }
+                        let (startFeature, rowStarts) = rows[rowIndex]
+                        scoredEnds.removeAll(keepingCapacity: true)
+                        
+                        for startTime in rowStarts {
+                            for endTime in ends where endTime > startTime &&
+                                                      endTime - startTime >= minDuration &&
+                                                      endTime - startTime <= trackDuration * 0.8 {
+                                let endFeature = min(featureCount - 1, Int((endTime * framesPerFeature).rounded()))
+                                guard scoredEnds.insert(endFeature).inserted else { continue }
+                                
+                                var similarity: Float = 0
+                                var compared = 0
+                                for offset in -context..<context {
+                                    let a = startFeature + offset
+                                    let b = endFeature + offset
+                                    guard a >= 0, b < featureCount else { continue }
+                                    similarity += self.featureSimilarity(features[a], features[b])
+                                    compared += 1
+                                }
+                                guard compared > 0 else { continue }
+                                
+                                heap.insert(SeamPair(startFrame: Int(startTime * sampleRate),
+                                                     endFrame: Int(endTime * sampleRate),
+                                                     score: similarity / Float(compared)))
+                                scored += 1
+                            }
+                        }
+                    }
+                    return (heap, scored)
+                }
+            }
+            
+            for await (heap, scored) in group {
+                best.merge(heap)
+                scoredCount += scored
+            }
+        }
+        
+        print("Coarse pass scored \(scoredCount) pairs at hop \(hopSize) on \(workerCount) workers")
+        return bestDistinctPairs(best.sortedDescending(), count: coarseSurvivorCount, separation: hopSize * 2)
+    }
+    
+    /**
+     * Stage 2: slides each pair's end by up to one analysis hop in steps of
+     * the refinement hop, keeping the shift whose STFT frames best match the
+     * frames around the start. Pairs are sorted by start and split into
+     * contiguous runs, so each worker reuses its start spectra; every worker
+     * has its own STFT scratch.
+     */
+    private func refinePairsBySpectrum(_ pairs: [SeamPair], samples: UnsafePointer<Float>, totalFrames: Int) async -> [SeamPair] {
+        guard !pairs.isEmpty else { return pairs }
+        
+        let sorted = pairs.sorted { $0.startFrame < $1.startFrame }
+        let workerCount = min(searchWorkerCount, sorted.count)
+        let runLength = (sorted.count + workerCount - 1) / workerCount
+        let heapCapacity = refinedSurvivorCount * 4
+        var best = BoundedHeap<SeamPair>(capacity: heapCapacity) { $0.score < $1.score }
+        
+        await withTaskGroup(of: BoundedHeap<SeamPair>.self) { group in
+            for run in stride(from: 0, to: sorted.count, by: runLength) {
+                let runPairs = sorted[run..<min(run + runLength, sorted.count)]
+                group.addTask {
+                    var heap = BoundedHeap<SeamPair>(capacity: heapCapacity) { $0.score < $1.score }
+                    guard let refiner = SpectralRefiner(analyzer: self, samples: samples, totalFrames: totalFrames) else {
+                        runPairs.forEach { heap.insert($0) }
+                        return heap
+                    }
+                    for pair in runPairs {
+                        if Task.isCancelled { break }
+                        if let refined = refiner.refine(pair) {
+                            heap.insert(refined)
+                        }
+                    }
+                    return heap
+                }
+            }
+            
+            for await heap in group {
+                best.merge(heap)
+            }
+        }
+        
+        return bestDistinctPairs(best.sortedDescending(), count: refinedSurvivorCount, separation: refinementHopSize * 2)
+    }
+    
+    /**
+     * One worker's stage 2 state: its STFT, the spectra around the starts it
+     * has seen, and the spectra around the end being refined.
+     */
+    private final class SpectralRefiner {
+        private let spectrum: ShortTimeSpectrum
+        private let samples: UnsafePointer<Float>
+        private let totalFrames: Int
+        private let hopSize: Int
+        private let context: Int
+        private let radius: Int
+        private let minimumFrames: Int
+        private var startSpectra: [Int: [Float]] = [:]
+        private var endSpectra: [Float]
+        
+        init?(analyzer: MusicStructureAnalyzer, samples: UnsafePointer<Float>, totalFrames: Int) {
+            guard let spectrum = ShortTimeSpectrum(fftSize: analyzer.refinementFFTSize) else { return nil }
+            let context = analyzer.refinementContextFrames
+            let radius = analyzer.hopSize / analyzer.refinementHopSize
+            self.spectrum = spectrum
+            self.samples = samples
+            self.totalFrames = totalFrames
+            self.hopSize = analyzer.refinementHopSize
+            self.context = context
+            self.radius = radius
+            self.minimumFrames = Int(analyzer.minSectionDuration * analyzer.sampleRate)
+            
+            // Spectra around the end, from radius + context frames before it to radius + context after
+            self.endSpectra = [Float](repeating: 0, count: (2 * (radius + context) + 1) * spectrum.binCount)
+        }
+        
+        /// The pair with its best end shift, or nil when no shift is viable
+        func refine(_ pair: SeamPair) -> SeamPair? {
+            let binCount = spectrum.binCount
+            
+            if startSpectra[pair.startFrame] == nil {
+                var frames = [Float](repeating: 0, count: 2 * context * binCount)
+                frames.withUnsafeMutableBufferPointer { output in
+                    for index in 0..<(2 * context) {
+                        spectrum.magnitudes(of: samples, frameCount: totalFrames,
+                                            centeredAt: pair.startFrame + (index - context) * hopSize,
+                                            into: output.baseAddress! + index * binCount)
+                    }
+                }
+                startSpectra[pair.startFrame] = frames
+            }
+            guard let startFrames = startSpectra[pair.startFrame] else { return nil }
+            
+            endSpectra.withUnsafeMutableBufferPointer { output in
+                for index in 0..<(2 * (radius + context) + 1) {
+                    spectrum.magnitudes(of: samples, frameCount: totalFrames,
+                                        centeredAt: pair.endFrame + (index - radius - context) * hopSize,
+                                        into: output.baseAddress! + index * binCount)
+                }
+            }
+            
+            var best = pair
+            best.score = -1
+            for shift in -radius...radius {
+                let endFrame = pair.endFrame + shift * hopSize
+                guard endFrame - pair.startFrame >= minimumFrames, endFrame < totalFrames else { continue }
+                
+                var similarity: Float = 0
+                for index in 0..<(2 * context) {
+                    let endIndex = shift + radius + index
+                    similarity += 1 - MusicStructureAnalyzer.spectralDistance(startFrames, at: index * binCount,
+                                                                              endSpectra, at: endIndex * binCount,
+                                                                              count: binCount)
+                }
+                similarity /= Float(2 * context)
+                
+                if similarity > best.score {
+                    best = SeamPair(startFrame: pair.startFrame, endFrame: endFrame, score: similarity)
+                }
+            }
+            return best.score >= 0 ? best : nil
+        }
+    }
+    
+    /**
+     * Normalized L1 distance between two magnitude spectra stored in larger
+     * arrays: 0 for identical spectra, 1 for disjoint ones.
+     */
+    private static func spectralDistance(_ a: [Float], at aOffset: Int, _ b: [Float], at bOffset: Int, count: Int) -> Float {
+        var difference: Float = 0
+        var magnitude: Float = 0
+        for bin in 0..<count {
+            let x = a[aOffset + bin]
+            let y = b[bOffset + bin]
+            difference += abs(x - y)
+            magnitude += max(x, y)
+        }
+        return magnitude > 0 ? difference / magnitude : 0
+    }
+    
+    /**
+     * Stage 3 and the full transition metrics. Workers align every
+     * workerCount-th pair, each with its own scratch arena, then the
+     * aligned seams are scored as one batch so shared starts and ends are
+     * measured once. Keeps candidates of at least mediocre quality.
+     */
+    private func evaluateRefinedPairs(_ pairs: [SeamPair], samples: UnsafePointer<Float>, totalFrames: Int) async -> [LoopCandidate] {
+        let workerCount = min(searchWorkerCount, pairs.count)
+        guard workerCount > 0, let seamMetrics = seamMetrics else { return [] }
+        
+        let completed = ManagedAtomic<Int>(0)
+        
+        let seams = await withTaskGroup(of: [SeamMetrics.Seam].self) { group in
+            for worker in 0..<workerCount {
+                group.addTask {
+                    let scratch = ScratchArena()
+                    var seams: [SeamMetrics.Seam] = []
+                    
+                    for index in stride(from: worker, to: pairs.count, by: workerCount) {
+                        if Task.isCancelled { break }
+                        
+                        let aligned = self.alignPairBySamples(pairs[index], samples: samples, totalFrames: totalFrames,
+                                                              scratch: scratch)
+                        seams.append(SeamMetrics.Seam(startFrame: aligned.startFrame, endFrame: aligned.endFrame))
+                        
+                        let fraction = Double(completed.wrappingIncrementThenLoad(ordering: .relaxed)) / Double(pairs.count)
+                        DispatchQueue.main.async { self.progress = max(self.progress, 0.7 + 0.05 * fraction) }
+                    }
+                    return seams
+                }
+            }
+            
+            var seams: [SeamMetrics.Seam] = []
+            for await workerSeams in group {
+                seams.append(contentsOf: workerSeams)
+            }
+            return seams
+        }
+        
+        DispatchQueue.main.async { self.progress = max(self.progress, 0.75) }
+        
+        let sampleRate = self.sampleRate
+        return await seamMetrics.score(seams)
+            // Only keep candidates with at least mediocre quality
+            .filter { $0.quality > 3.0 }
+            .map { score in
+                LoopCandidate(startTime: Double(score.seam.startFrame) / sampleRate,
+                              endTime: Double(score.seam.endFrame) / sampleRate,
+                              quality: score.quality,
+                              metrics: score.metrics)
+            }
+    }
+    
+    /**
+     * Stage 3: settles the end on the sample grid by cross-correlating the
+     * waveform around it with the waveform around the start, then slides
+     * both points together (keeping the loop length) so the seam lands on a
+     * zero crossing of the start.
+     */
+    private func alignPairBySamples(_ pair: SeamPair, samples: UnsafePointer<Float>, totalFrames: Int,
+                                    scratch: ScratchArena) -> SeamPair {
+        let half = correlationWindowSize / 2
+        let lagRadius = refinementHopSize
+        let searchCount = correlationWindowSize + 2 * lagRadius
+        let searchStart = pair.endFrame - half - lagRadius
+        
+        guard pair.startFrame - half >= 0, pair.startFrame + half <= totalFrames,
+              searchStart >= 0, searchStart + searchCount <= totalFrames else { return pair }
+        
+        // Correlation and local energy at every lag
+        let lagCount = 2 * lagRadius + 1
+        let bestLag = scratch.withFloats(2 * lagCount + searchCount) { buffer -> Int in
+            let correlation = buffer.baseAddress!
+            let energy = correlation + lagCount
+            let squares = energy + lagCount
+            vDSP_conv(samples + searchStart, 1, samples + (pair.startFrame - half), 1,
+                      correlation, 1, vDSP_Length(lagCount), vDSP_Length(correlationWindowSize))
+            vDSP_vsq(samples + searchStart, 1, squares, 1, vDSP_Length(searchCount))
+            vDSP_vswsum(squares, 1, energy, 1, vDSP_Length(lagCount), vDSP_Length(correlationWindowSize))
+            
+            var bestLag = lagRadius
+            var bestCorrelation = -Float.infinity
+            for lag in 0..<lagCount {
+                let normalized = correlation[lag] / sqrt(max(energy[lag], 1e-12))
+                if normalized > bestCorrelation {
+                    bestCorrelation = normalized
+                    bestLag = lag
+                }
+            }
+            return bestLag
+        }
+        
+        var aligned = pair
+        aligned.endFrame = pair.endFrame - lagRadius + bestLag
+        
+        // Nearest zero crossing to the start, moving the end by the same amount;
+        // the start may go no further than keeps the end inside the track
+        let startLimit = totalFrames - (aligned.endFrame - aligned.startFrame)
+        if let crossing = SnapIndex.nearestZeroCrossing(in: samples, frameCount: startLimit,
+                                                        around: aligned.startFrame, radius: zeroCrossingSearchFrames) {
+            let nudge = crossing - aligned.startFrame
+            aligned.startFrame += nudge
+            aligned.endFrame += nudge
+        }
+        
+        return aligned
+    }
+    
+    /**
+     * The highest-scoring pairs, skipping any whose start and end both fall
+     * within `separation` frames of a pair already taken.
+     */
+    private func bestDistinctPairs(_ pairs: [SeamPair], count: Int, separation: Int) -> [SeamPair] {
+        var kept: [SeamPair] = []
+        for pair in pairs.sorted(by: { $0.score > $1.score }) {
+            if kept.count == count { break }
+            let crowded = kept.contains { other in
+                abs(other.startFrame - pair.startFrame) < separation &&
+                abs(other.endFrame - pair.endFrame) < separation
+            }
+            if !crowded {
+                kept.append(pair)
+            }
+        }
+        return kept
+    }
+
     /**
      * Finds repetition patterns in the music and adds them as candidate loop points.
      * No genre-specific assumptions are made - just looking for repeating patterns.
@@ -875,7 +1228,7 @@ class MusicStructureAnalyzer: ObservableObject {
                     let avgSimilarity = totalSimilarity / Float(sectionLength)
                     
                     // If we found a highly similar region, it's a repeating section
-                    if avgSimilarity > 0.7 {
+                    if avgSimilarity > configuration.repetitionThreshold {
                         let timeA = features[startA].timeOffset
                         let timeEndA = features[endA].timeOffset
                         let timeB = features[startB].timeOffset
@@ -1059,37 +1412,10 @@ class MusicStructureAnalyzer: ObservableObject {
     }
     
     /**
-     * Find zero crossings near a specific time point
+     * Identify phrase boundaries based on spectral flux and RMS changes
      */
-    private func findZeroCrossingsNear(time: TimeInterval, samples: UnsafePointer<Float>, window: TimeInterval) -> [TimeInterval] {
-        guard let buffer = audioBuffer else { return [] }
-        
-        let framePos = Int(time * sampleRate)
-        let windowFrames = Int(window * sampleRate)
-        let startFrame = max(0, framePos - windowFrames/2)
-        let endFrame = min(Int(buffer.frameLength), framePos + windowFrames/2)
-        var zeroCrossings: [TimeInterval] = []
-        
-        // Check for zero crossings
-        for i in startFrame..<endFrame-1 {
-            if (samples[i] >= 0 && samples[i+1] < 0) ||
-               (samples[i] < 0 && samples[i+1] >= 0) {
-                // Linear interpolation to find precise zero crossing
-                let t = -samples[i] / (samples[i+1] - samples[i])
-                let frameExact = Double(i) + Double(t)
-                let timeExact = frameExact / sampleRate
-                zeroCrossings.append(timeExact)
-            }
-        }
-        
-        return zeroCrossings
-    }
-    
-    /**
-     * Identify phrase boundaries based on spectral flux and RMS changes
-     */
-    private func findPhraseBoundaries() -> [TimeInterval] {
-        guard !features.isEmpty else { return [] }
+    private func findPhraseBoundaries() -> [TimeInterval] {
+        guard !features.isEmpty else { return [] }
         
         var boundaries: [TimeInterval] = []
         let windowSize = 4 // Look 4 frames before and after
@@ -1130,73 +1456,6 @@ class MusicStructureAnalyzer: ObservableObject {
         return boundaries
     }
     
-    /**
-     * Improved loop transition analysis that focuses on musical coherence
-     * rather than just acoustic similarity. This works for any musical style.
-     */
-    private func evaluateTransitionQuality(loopStart: TimeInterval, loopEnd: TimeInterval) -> LoopCandidate.TransitionMetrics {
-        guard let buffer = audioBuffer,
-              let channelData = buffer.floatChannelData else {
-            return createDefaultMetrics(poor: true)
-        }
-        
-        let samples = channelData[0]
-        let loopStartFrame = Int(loopStart * sampleRate)
-        let loopEndFrame = Int(loopEnd * sampleRate)
-        let totalFrames = Int(buffer.frameLength)
-        
-        // Ensure frames are valid
-        guard loopStartFrame >= 0 && loopEndFrame > loopStartFrame &&
-              loopEndFrame < totalFrames else {
-            return createDefaultMetrics(poor: true)
-        }
-        
-        // Extract samples for analysis - using longer windows for better context
-        let analysisWindowSize = Int(sampleRate * 0.5)  // 0.5 second window
-        
-        let preLoopSamples = extractSamples(from: samples,
-                                         startFrame: max(0, loopEndFrame - analysisWindowSize),
-                                         count: min(analysisWindowSize, loopEndFrame))
-        
-        let postLoopSamples = extractSamples(from: samples,
-                                          startFrame: loopStartFrame,
-                                          count: min(analysisWindowSize, totalFrames - loopStartFrame))
-        
-        // Basic acoustic metrics
-        let preLoopRMS = calculateRMS(samples: preLoopSamples)
-        let postLoopRMS = calculateRMS(samples: postLoopSamples)
-        
-        let volumeChange = abs(preLoopRMS - postLoopRMS) / max(0.0001, max(preLoopRMS, postLoopRMS)) * 100
-        
-        // Phase analysis
-        let preLoopEndValue = preLoopSamples.last ?? 0
-        let postLoopStartValue = postLoopSamples.first ?? 0
-        let phaseJump = abs(preLoopEndValue - postLoopStartValue)
-        
-        // Zero crossing check
-        let zeroEnd = abs(preLoopEndValue) < 0.01
-        let zeroStart = abs(postLoopStartValue) < 0.01
-        
-        // Enhanced spectral analysis focusing on perceptually important bands
-        let spectralDifference = calculateEnhancedSpectralDifference(preLoopSamples, postLoopSamples)
-        
-        // Improved harmonic continuity analysis
-        let harmonicContinuity = calculateEnhancedHarmonicContinuity(preLoopSamples, postLoopSamples)
-        
-        // Enhanced envelope continuity with focus on attack transients
-        let envelopeContinuity = calculateEnhancedEnvelopeContinuity(preLoopSamples, postLoopSamples)
-        
-        return LoopCandidate.TransitionMetrics(
-            volumeChange: volumeChange,
-            phaseJump: phaseJump,
-            spectralDifference: spectralDifference,
-            harmonicContinuity: harmonicContinuity,
-            envelopeContinuity: envelopeContinuity,
-            zeroStart: zeroStart,
-            zeroEnd: zeroEnd
-        )
-    }
-
     /**
      * Helper to create default metrics when analysis cannot be performed
      */
@@ -1211,750 +1470,30 @@ class MusicStructureAnalyzer: ObservableObject {
             zeroEnd: false
         )
     }
-
-    /**
-     * Enhanced spectral difference calculation that weights frequency bands
-     * according to their perceptual importance.
-     */
-    private func calculateEnhancedSpectralDifference(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Calculate FFTs
-        let preLoopFFT = calculateFFTMagnitudes(preLoopSamples)
-        let postLoopFFT = calculateFFTMagnitudes(postLoopSamples)
-        
-        // Compare frequency content with perceptual weighting
-        let minSize = min(preLoopFFT.count, postLoopFFT.count)
-        
-        // Define perceptual bands (approximate for 44.1kHz)
-        // Bass: 0-300Hz, Low-Mid: 300-1000Hz, Mid: 1000-3000Hz, Hi: 3000+Hz
-        let bassRange = minSize / 70    // ~300Hz
-        let lowMidRange = minSize / 20  // ~1000Hz
-        let midRange = minSize / 7      // ~3000Hz
-        
-        // Initialize band differences and magnitudes
-        var bassDiff: Float = 0
-        var bassMag: Float = 0
-        var lowMidDiff: Float = 0
-        var lowMidMag: Float = 0
-        var midDiff: Float = 0
-        var midMag: Float = 0
-        var highDiff: Float = 0
-        var highMag: Float = 0
-        
-        // Bass range (fundamental notes, most important for tonality)
-        for i in 1..<bassRange {
-            bassDiff += abs(preLoopFFT[i] - postLoopFFT[i])
-            bassMag += max(preLoopFFT[i], postLoopFFT[i])
-        }
-        
-        // Low-mid range (strong harmonic presence)
-        for i in bassRange..<lowMidRange {
-            lowMidDiff += abs(preLoopFFT[i] - postLoopFFT[i])
-            lowMidMag += max(preLoopFFT[i], postLoopFFT[i])
-        }
-        
-        // Mid range (vocals, leads, important for timbre)
-        for i in lowMidRange..<midRange {
-            midDiff += abs(preLoopFFT[i] - postLoopFFT[i])
-            midMag += max(preLoopFFT[i], postLoopFFT[i])
-        }
-        
-        // High range (cymbals, ambience, less important for loop continuity)
-        for i in midRange..<minSize {
-            highDiff += abs(preLoopFFT[i] - postLoopFFT[i])
-            highMag += max(preLoopFFT[i], postLoopFFT[i])
-        }
-        
-        // Calculate band-specific scores (0-1, lower is better)
-        let bassScore = bassMag > 0 ? bassDiff / bassMag : 1.0
-        let lowMidScore = lowMidMag > 0 ? lowMidDiff / lowMidMag : 1.0
-        let midScore = midMag > 0 ? midDiff / midMag : 1.0
-        let highScore = highMag > 0 ? highDiff / highMag : 1.0
-        
-        // Weighted average with greater emphasis on bass and low-mid
-        // These bands contain most of the musical information
-        let weightedDifference = (bassScore * 0.4) +
-                                 (lowMidScore * 0.3) +
-                                 (midScore * 0.2) +
-                                 (highScore * 0.1)
-        
-        return weightedDifference
-    }
-
-    /**
-     * Enhanced harmonic continuity analysis that focuses on
-     * musical relationships between the loop end and start.
-     */
-    private func calculateEnhancedHarmonicContinuity(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Generate chromagram if possible (frequency domain representation of pitch classes)
-        let preChroma = generateChromagram(preLoopSamples)
-        let postChroma = generateChromagram(postLoopSamples)
-        
-        // If chromagram generation failed, use simpler correlation method
-        if preChroma.isEmpty || postChroma.isEmpty {
-            return calculateHarmonicContinuity(preLoopSamples, postLoopSamples)
-        }
-        
-        // Get average chromagram for the last portion of pre-loop
-        // and first portion of post-loop (these represent the harmonic context)
-        let preContext = averageChromaFrames(preChroma.suffix(3))
-        let postContext = averageChromaFrames(postChroma.prefix(3))
-        
-        // 1. Basic chromagram correlation
-        var correlation: Float = 0
-        var normPre: Float = 0
-        var normPost: Float = 0
-        
-        for bin in 0..<12 {
-            correlation += preContext[bin] * postContext[bin]
-            normPre += preContext[bin] * preContext[bin]
-            normPost += postContext[bin] * postContext[bin]
-        }
-        
-        let basicCorrelation = (normPre > 0 && normPost > 0) ?
-                               correlation / sqrt(normPre * normPost) : 0
-        
-        // 2. Harmonic function analysis
-        var harmonicScore: Float = 0
-        
-        // Find strongest pitch classes
-        let preStrong = findStrongPitchClasses(preContext)
-        let postStrong = findStrongPitchClasses(postContext)
-        
-        // Check for perfect matches and musically compatible pitch classes
-        let perfectMatches = Set(preStrong).intersection(Set(postStrong))
-        
-        // If we have direct pitch class matches, that's ideal
-        if !perfectMatches.isEmpty {
-            harmonicScore = 1.0
-        } else {
-            // Check for harmonically compatible pitch classes
-            for prePitch in preStrong {
-                for postPitch in postStrong {
-                    // Calculate interval between pitch classes
-                    let interval = abs(prePitch - postPitch) % 12
-                    
-                    // Score higher for consonant intervals (perfect 5th = 7, perfect 4th = 5)
-                    if interval == 7 || interval == 5 {
-                        harmonicScore += 0.8  // Strong harmonic relationship
-                    } else if interval == 4 || interval == 3 {
-                        harmonicScore += 0.6  // Major/minor third
-                    } else if interval == 9 || interval == 8 {
-                        harmonicScore += 0.4  // Major/minor sixth
-                    } else {
-                        harmonicScore += 0.2  // Other intervals
-                    }
-                }
-            }
-            
-            // Normalize
-            if !preStrong.isEmpty && !postStrong.isEmpty {
-                harmonicScore /= Float(preStrong.count * postStrong.count)
-            }
-        }
-        
-        // Combined score with emphasis on basic correlation
-        return (basicCorrelation * 0.7) + (harmonicScore * 0.3)
-    }
-
-    /**
-     * Helper to find the strongest pitch classes in a chroma vector
-     */
-    private func findStrongPitchClasses(_ chroma: [Float]) -> [Int] {
-        guard !chroma.isEmpty else { return [] }
-        
-        // Find maximum value in chroma
-        let maxVal = chroma.max() ?? 0
-        
-        // Use scaled threshold based on maximum
-        let threshold = maxVal * 0.6  // Consider pitch classes at least 60% as strong as maximum
-        
-        // Return indices of strong pitch classes
-        return chroma.indices.filter { chroma[$0] >= threshold }
-    }
-
-    /**
-     * Helper to average multiple chroma frames
-     */
-    private func averageChromaFrames(_ frames: ArraySlice<[Float]>) -> [Float] {
-        var result = [Float](repeating: 0, count: 12)
-        
-        if frames.isEmpty {
-            return result
-        }
-        
-        for frame in frames {
-            for i in 0..<min(12, frame.count) {
-                result[i] += frame[i]
-            }
-        }
-        
-        // Normalize
-        for i in 0..<12 {
-            result[i] /= Float(frames.count)
-        }
-        
-        return result
-    }
-
-    /**
-     * Enhanced envelope continuity analysis that focuses on the rhythmic
-     * flow between loop end and start.
-     */
-    private func calculateEnhancedEnvelopeContinuity(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Use smaller window for detailed envelope analysis
-        let windowSize = 256  // ~6ms at 44.1kHz
-        
-        // Calculate number of windows
-        let preWindowCount = preLoopSamples.count / windowSize
-        let postWindowCount = postLoopSamples.count / windowSize
-        
-        guard preWindowCount > 0 && postWindowCount > 0 else { return 0 }
-        
-        // Extract amplitude envelopes
-        var preEnvelope = [Float]()
-        var postEnvelope = [Float]()
-        
-        for i in 0..<preWindowCount {
-            let start = i * windowSize
-            let end = min(start + windowSize, preLoopSamples.count)
-            preEnvelope.append(calculateRMS(samples: Array(preLoopSamples[start..<end])))
-        }
-        
-        for i in 0..<postWindowCount {
-            let start = i * windowSize
-            let end = min(start + windowSize, postLoopSamples.count)
-            postEnvelope.append(calculateRMS(samples: Array(postLoopSamples[start..<end])))
-        }
-        
-        // 1. Calculate envelope shape continuity (how smoothly the amplitude flows)
-        let compareLength = min(5, min(preEnvelope.count, postEnvelope.count))
-        
-        if compareLength <= 1 {
-            return 0.5  // Not enough data for good analysis, return neutral score
-        }
-        
-        let preEndEnvelope = Array(preEnvelope.suffix(compareLength))
-        let postStartEnvelope = Array(postEnvelope.prefix(compareLength))
-        
-        var shapeErrorSum: Float = 0
-        var totalMagnitude: Float = 0
-        
-        for i in 0..<compareLength {
-            shapeErrorSum += abs(preEndEnvelope[i] - postStartEnvelope[i])
-            totalMagnitude += max(preEndEnvelope[i], postStartEnvelope[i])
-        }
-        
-        // Basic envelope continuity score
-        let basicContinuity = totalMagnitude > 0 ? 1.0 - (shapeErrorSum / totalMagnitude) : 0
-        
-        // 2. Calculate envelope derivative continuity (how the rate of change flows)
-        var preDerivative = [Float]()
-        var postDerivative = [Float]()
-        
-        for i in 1..<preEndEnvelope.count {
-            preDerivative.append(preEndEnvelope[i] - preEndEnvelope[i-1])
-        }
-        
-        for i in 1..<postStartEnvelope.count {
-            postDerivative.append(postStartEnvelope[i] - postStartEnvelope[i-1])
-        }
-        
-        if preDerivative.isEmpty || postDerivative.isEmpty {
-            return basicContinuity  // Not enough data for derivative analysis
-        }
-        
-        // Compare derivatives (how amplitude changes across boundary)
-        let preLastDerivative = preDerivative.last!
-        let postFirstDerivative = postDerivative.first!
-        
-        // Normalize to a 0-1 scale (1 = perfect match)
-        let maxDerivativeMagnitude = max(abs(preLastDerivative), abs(postFirstDerivative))
-        let derivativeContinuity = maxDerivativeMagnitude > 0 ?
-                                  1.0 - (abs(preLastDerivative - postFirstDerivative) / maxDerivativeMagnitude) : 1.0
-        
-        // Combined score with more emphasis on basic continuity
-        return (basicContinuity * 0.7) + (derivativeContinuity * 0.3)
-    }
-    
-    /**
-     * Extract samples from buffer for analysis
-     */
-    private func extractSamples(from buffer: UnsafePointer<Float>, startFrame: Int, count: Int) -> [Float] {
-        var samples = [Float](repeating: 0, count: count)
-        samples.withUnsafeMutableBufferPointer { ptr in
-            ptr.baseAddress!.update(from: buffer.advanced(by: startFrame), count: count)
-        }
-        return samples
-    }
-    
-    /**
-     * Calculate spectral difference between two sample arrays
-     */
-    private func calculateTransitionSpectralDifference(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Calculate FFTs
-        let preLoopFFT = calculateTransitionFFT(preLoopSamples)
-        let postLoopFFT = calculateTransitionFFT(postLoopSamples)
-        
-        // Calculate normalized difference between spectra
-        var totalDifference: Float = 0
-        var totalMagnitude: Float = 0
-        
-        let minSize = min(preLoopFFT.count, postLoopFFT.count)
-        for i in 0..<minSize {
-            let diff = abs(preLoopFFT[i] - postLoopFFT[i])
-            totalDifference += diff
-            totalMagnitude += max(preLoopFFT[i], postLoopFFT[i])
-        }
-        
-        return totalMagnitude > 0 ? totalDifference / totalMagnitude : 1.0
-    }
-    
-    /**
-     * Calculate FFT for transition analysis
-     */
-    private func calculateTransitionFFT(_ samples: [Float]) -> [Float] {
-        // Pad to power of 2 if needed
-        let nextPowerOf2 = Int(pow(2, ceil(log2(Float(samples.count)))))
-        var paddedSamples = samples
-        if paddedSamples.count < nextPowerOf2 {
-            paddedSamples.append(contentsOf: [Float](repeating: 0, count: nextPowerOf2 - samples.count))
-        }
-        
-        // Apply window function
-        var windowedSamples = [Float](repeating: 0, count: paddedSamples.count)
-        vDSP_hann_window(&windowedSamples, vDSP_Length(paddedSamples.count), Int32(0))
-        vDSP_vmul(paddedSamples, 1, windowedSamples, 1, &windowedSamples, 1, vDSP_Length(paddedSamples.count))
-        
-        // Setup FFT
-        let log2n = vDSP_Length(log2(Float(paddedSamples.count)))
-        let fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
-        
-        var realp = [Float](repeating: 0, count: paddedSamples.count/2)
-        var imagp = [Float](repeating: 0, count: paddedSamples.count/2)
-        var splitComplex = DSPSplitComplex(realp: &realp, imagp: &imagp)
-        
-        // Convert to split complex format
-        windowedSamples.withUnsafeBufferPointer { ptr in
-            ptr.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: paddedSamples.count/2) { complexPtr in
-                vDSP_ctoz(complexPtr, 2, &splitComplex, 1, vDSP_Length(paddedSamples.count/2))
-            }
-        }
-        
-        // Perform forward FFT
-        vDSP_fft_zrip(fftSetup, &splitComplex, 1, log2n, FFTDirection(FFT_FORWARD))
-        
-        // Calculate magnitude spectrum
-        var magnitudes = [Float](repeating: 0, count: paddedSamples.count/2)
-        vDSP_zvmags(&splitComplex, 1, &magnitudes, 1, vDSP_Length(paddedSamples.count/2))
-        
-        // Cleanup
-        vDSP_destroy_fftsetup(fftSetup)
-        
-        return magnitudes
-    }
-    
-    /**
-     * Improved harmonic analysis that evaluates not just spectral overlap but musical coherence.
-     * Uses chromagram-based analysis to detect harmonic compatibility between loop points.
-     */
-    private func calculateHarmonicContinuity(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // 1. Generate chromagrams (12-bin pitch class profiles) for both segments
-        let preChroma = generateChromagram(preLoopSamples)
-        let postChroma = generateChromagram(postLoopSamples)
-        
-        // If chromagram generation failed, fall back to original method
-        if preChroma.isEmpty || postChroma.isEmpty {
-            return calculateHarmonicContinuity(preLoopSamples, postLoopSamples)
-        }
-        
-        // 2. Calculate harmonic vector correlation
-        var correlation: Float = 0
-        var normPre: Float = 0
-        var normPost: Float = 0
-        
-        // Calculate correlation between the last frame of the first segment and
-        // the first frame of the second segment
-        let preLastFrame = preChroma.last!
-        let postFirstFrame = postChroma.first!
-        
-        for i in 0..<12 {
-            correlation += preLastFrame[i] * postFirstFrame[i]
-            normPre += preLastFrame[i] * preLastFrame[i]
-            normPost += postFirstFrame[i] * postFirstFrame[i]
-        }
-        
-        // Normalized correlation
-        let frameCorrelation = (normPre > 0 && normPost > 0) ?
-                               correlation / sqrt(normPre * normPost) : 0
-        
-        // 3. Calculate harmonic progression correlation (key context)
-        var contextCorrelation: Float = 0
-        
-        // Use up to 3 frames from each side to establish harmonic context
-        let preContextSize = min(3, preChroma.count)
-        let postContextSize = min(3, postChroma.count)
-        
-        if preContextSize > 0 && postContextSize > 0 {
-            // Average the chroma frames to get harmonic context
-            var preContext = [Float](repeating: 0, count: 12)
-            var postContext = [Float](repeating: 0, count: 12)
-            
-            for i in preChroma.count - preContextSize..<preChroma.count {
-                for bin in 0..<12 {
-                    preContext[bin] += preChroma[i][bin]
-                }
-            }
-            
-            for i in 0..<postContextSize {
-                for bin in 0..<12 {
-                    postContext[bin] += postChroma[i][bin]
-                }
-            }
-            
-            // Normalize
-            for bin in 0..<12 {
-                preContext[bin] /= Float(preContextSize)
-                postContext[bin] /= Float(postContextSize)
-            }
-            
-            // Calculate correlation of contexts
-            var ctxCorr: Float = 0
-            var ctxNormPre: Float = 0
-            var ctxNormPost: Float = 0
-            
-            for bin in 0..<12 {
-                ctxCorr += preContext[bin] * postContext[bin]
-                ctxNormPre += preContext[bin] * preContext[bin]
-                ctxNormPost += postContext[bin] * postContext[bin]
-            }
-            
-            contextCorrelation = (ctxNormPre > 0 && ctxNormPost > 0) ?
-                                 ctxCorr / sqrt(ctxNormPre * ctxNormPost) : 0
-        }
-        
-        // 4. Combine frame and context correlations
-        // Direct transition is more important, but context matters for musicality
-        let combinedScore = (frameCorrelation * 0.7) + (contextCorrelation * 0.3)
-        
-        // 5. Apply musically-informed heuristics
-        var finalScore = combinedScore
-        
-        // Check if either context has a very strong tonal center
-        let preMaxTone = preLastFrame.max() ?? 0
-        let postMaxTone = postFirstFrame.max() ?? 0
-        
-        // If one side has very strong tonal presence but the other doesn't,
-        // that's usually an indicator of poor transition
-        if (preMaxTone > 0.5 && postMaxTone < 0.2) ||
-           (postMaxTone > 0.5 && preMaxTone < 0.2) {
-            finalScore *= 0.7
-        }
-        
-        // Boost score if the maximum tonal elements are harmonically related
-        // (e.g., perfect fifth = 7 semitones, major third = 4 semitones)
-        if preMaxTone > 0.3 && postMaxTone > 0.3 {
-            let preMaxIndex = preLastFrame.firstIndex(of: preMaxTone) ?? 0
-            let postMaxIndex = postFirstFrame.firstIndex(of: postMaxTone) ?? 0
-            
-            let interval = abs(preMaxIndex - postMaxIndex)
-            let harmonicIntervals = [0, 4, 5, 7, 9] // Unison, M3, P4, P5, M6
-            
-            if harmonicIntervals.contains(interval % 12) {
-                finalScore = min(1.0, finalScore * 1.2)
-            }
-        }
-        
-        return finalScore
-    }
-
-    /**
-     * Generates a chromagram (12-bin pitch class profile) from audio samples.
-     * Each chromatogram has 12 bins representing the 12 semitones of the chromatic scale.
-     * Returns an array of chroma frames.
-     */
-    private func generateChromagram(_ samples: [Float]) -> [[Float]] {
-        // Ensure we have enough samples
-        guard samples.count >= 1024 else { return [] }
-        
-        // Number of frames to process
-        let frameSize = 2048
-        let hopSize = 1024
-        let nFrames = (samples.count - frameSize) / hopSize + 1
-        
-        // Early return if we don't have enough data
-        if nFrames <= 0 {
-            return []
-        }
-        
-        var chromagram = [[Float]](repeating: [Float](repeating: 0, count: 12), count: nFrames)
-        
-        for frameIndex in 0..<nFrames {
-            let startIdx = frameIndex * hopSize
-            let endIdx = min(startIdx + frameSize, samples.count)
-            var frameSamples = Array(samples[startIdx..<endIdx])
-            
-            // Zero-pad if needed
-            while frameSamples.count < frameSize {
-                frameSamples.append(0)
-            }
-            
-            // Apply Hann window
-            for i in 0..<frameSamples.count {
-                let windowFactor = 0.5 * (1 - cos(2 * Float.pi * Float(i) / Float(frameSamples.count - 1)))
-                frameSamples[i] *= windowFactor
-            }
-            
-            // Compute FFT
-            let magnitudes = calculateFFTMagnitudes(frameSamples)
-            
-            // Map FFT bins to chromatic scale (12 pitch classes)
-            mapFFTToChroma(magnitudes, outputChroma: &chromagram[frameIndex])
-        }
-        
-        return chromagram
-    }
-
-    /**
-     * Helper function to calculate FFT magnitudes
-     */
-    private func calculateFFTMagnitudes(_ samples: [Float]) -> [Float] {
-        // Setup FFT
-        let log2n = vDSP_Length(log2(Float(samples.count)))
-        let fftSetup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
-        
-        // Prepare for split complex FFT
-        var realp = [Float](repeating: 0, count: samples.count/2)
-        var imagp = [Float](repeating: 0, count: samples.count/2)
-        var splitComplex = DSPSplitComplex(realp: &realp, imagp: &imagp)
-        
-        // Convert to split complex format
-        samples.withUnsafeBufferPointer { ptr in
-            ptr.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: samples.count/2) { complexPtr in
-                vDSP_ctoz(complexPtr, 2, &splitComplex, 1, vDSP_Length(samples.count/2))
-            }
-        }
-        
-        // Perform forward FFT
-        vDSP_fft_zrip(fftSetup, &splitComplex, 1, log2n, FFTDirection(FFT_FORWARD))
-        
-        // Calculate magnitudes
-        var magnitudes = [Float](repeating: 0, count: samples.count/2)
-        vDSP_zvmags(&splitComplex, 1, &magnitudes, 1, vDSP_Length(samples.count/2))
-        
-        // Clean up
-        vDSP_destroy_fftsetup(fftSetup)
-        
-        return magnitudes
-    }
-
-    /**
-     * Maps FFT magnitude spectrum to chromagram (12 pitch classes)
-     */
-    private func mapFFTToChroma(_ magnitudes: [Float], outputChroma: inout [Float]) {
-        // Reset chroma values
-        for i in 0..<12 {
-            outputChroma[i] = 0
-        }
-        
-        // Reference frequency for A4 (MIDI note 69)
-        let A4 = 440.0
-        
-        // Calculate frequencies for each FFT bin
-        let binCount = magnitudes.count
-        let nyquistFreq = sampleRate / 2.0
-        
-        // Map each FFT bin to a pitch class (0-11)
-        for bin in 1..<binCount {
-            let frequency = (Double(bin) / Double(binCount)) * nyquistFreq
-            
-            // Skip very low and very high frequencies
-            if frequency < 20.0 || frequency > 8000.0 {
-                continue
-            }
-            
-            // Convert frequency to MIDI note number
-            let noteNumber = 12 * log2(frequency / A4) + 69
-            
-            // Skip invalid notes
-            if noteNumber < 0 {
-                continue
-            }
-            
-            // Map to pitch class (0-11)
-            let pitchClass = Int(round(noteNumber).truncatingRemainder(dividingBy: 12))
-            
-            // Add magnitude to corresponding pitch class
-            // Weight higher frequencies lower to emphasize bass notes
-            let weight = 1.0 / sqrt(frequency)
-            outputChroma[pitchClass] += magnitudes[bin] * Float(weight)
-        }
-        
-        // Normalize
-        let maxVal = outputChroma.max() ?? 1.0
-        if maxVal > 0 {
-            for i in 0..<12 {
-                outputChroma[i] /= maxVal
-            }
-        }
-    }
-    
-    /**
-     * Calculate envelope continuity between two sample arrays
-     */
-    private func calculateEnvelopeContinuity(_ preLoopSamples: [Float], _ postLoopSamples: [Float]) -> Float {
-        // Divide samples into small segments and compare RMS values
-        let segmentSize = 128 // ~3ms at 44.1kHz
-        let preSegmentCount = preLoopSamples.count / segmentSize
-        let postSegmentCount = postLoopSamples.count / segmentSize
-        
-        guard preSegmentCount > 0 && postSegmentCount > 0 else { return 0 }
-        
-        var preEnvelope = [Float]()
-        var postEnvelope = [Float]()
-        
-        // Calculate RMS envelope for pre-loop
-        for i in 0..<preSegmentCount {
-            let startIdx = i * segmentSize
-            let endIdx = min(startIdx + segmentSize, preLoopSamples.count)
-            let segment = Array(preLoopSamples[startIdx..<endIdx])
-            preEnvelope.append(calculateRMS(samples: segment))
-        }
-        
-        // Calculate RMS envelope for post-loop
-        for i in 0..<postSegmentCount {
-            let startIdx = i * segmentSize
-            let endIdx = min(startIdx + segmentSize, postLoopSamples.count)
-            let segment = Array(postLoopSamples[startIdx..<endIdx])
-            postEnvelope.append(calculateRMS(samples: segment))
-        }
-        
-        // Compare the end of pre-envelope with start of post-envelope
-        let comparisonLength = min(3, min(preEnvelope.count, postEnvelope.count))
-        var continuity: Float = 1.0
-        
-        if comparisonLength > 0 {
-            let preEnd = Array(preEnvelope.suffix(comparisonLength))
-            let postStart = Array(postEnvelope.prefix(comparisonLength))
-            
-            var totalDiff: Float = 0
-            var totalValue: Float = 0
-            
-            for i in 0..<comparisonLength {
-                totalDiff += abs(preEnd[i] - postStart[i])
-                totalValue += max(preEnd[i], postStart[i])
-            }
-            
-            continuity = totalValue > 0 ? 1.0 - (totalDiff / totalValue) : 0
-        }
-        
-        return continuity
-    }
-    
-    /**
-     * Improved quality metric calculation with perceptual weighting.
-     * This provides a better score that aligns with human perception of loop quality.
-     */
-    private func calculateOverallQuality(metrics: LoopCandidate.TransitionMetrics) -> Float {
-        // Revised weights focusing on perceptually important factors
-        let volumeWeight: Float = 0.20    // Increased (very noticeable)
-        let phaseWeight: Float = 0.15     // Decreased (less perceptually important)
-        let spectralWeight: Float = 0.15  // Decreased (less perceptually important)
-        let harmonicWeight: Float = 0.30  // Increased (crucial for musical coherence)
-        let envelopeWeight: Float = 0.20  // Increased (important for rhythm continuity)
-        
-        // Volume score - severe penalty for large changes
-        let volumeScore: Float
-        if metrics.volumeChange < 10 {
-            volumeScore = 10.0  // Virtually perfect
-        } else if metrics.volumeChange < 30 {
-            volumeScore = 10.0 - (metrics.volumeChange - 10) / 2.0  // Gradual penalty
-        } else if metrics.volumeChange < 60 {
-            volumeScore = 5.0 - (metrics.volumeChange - 30) / 10.0  // Steeper penalty
-        } else {
-            volumeScore = max(0.0, 2.0 - (metrics.volumeChange - 60) / 20.0)  // Very poor
-        }
-        
-        // Phase jump - exponential penalty for discontinuities
-        let phaseScore = 10.0 * exp(-metrics.phaseJump * 10.0)
-        
-        // Spectral difference - progressive penalty
-        let spectralScore: Float
-        if metrics.spectralDifference < 0.3 {
-            spectralScore = 10.0 - metrics.spectralDifference * 20.0  // Mild penalty
-        } else if metrics.spectralDifference < 0.7 {
-            spectralScore = 4.0 - (metrics.spectralDifference - 0.3) * 7.5  // Steeper penalty
-        } else {
-            spectralScore = max(0.0, 1.0 - (metrics.spectralDifference - 0.7) * 3.3)  // Very poor
-        }
-        
-        // Harmonic continuity - reward high values
-        let harmonicScore: Float
-        if metrics.harmonicContinuity > 0.8 {
-            harmonicScore = 10.0  // Perfect score for excellent continuity
-        } else if metrics.harmonicContinuity > 0.5 {
-            harmonicScore = 7.0 + (metrics.harmonicContinuity - 0.5) * 10.0  // Bonus for good scores
-        } else if metrics.harmonicContinuity > 0.3 {
-            harmonicScore = 4.0 + (metrics.harmonicContinuity - 0.3) * 15.0  // Mid range
-        } else {
-            harmonicScore = metrics.harmonicContinuity * 13.3  // Poor range
-        }
-        
-        // Envelope continuity - similar emphasis to harmonic
-        let envelopeScore: Float
-        if metrics.envelopeContinuity > 0.7 {
-            envelopeScore = 10.0  // Perfect score
-        } else if metrics.envelopeContinuity > 0.4 {
-            envelopeScore = 7.0 + (metrics.envelopeContinuity - 0.4) * 10.0  // Good range
-        } else {
-            envelopeScore = metrics.envelopeContinuity * 17.5  // Poor range
-        }
-        
-        // Bonus for zero crossings
-        let zeroBonus: Float
-        if metrics.zeroStart && metrics.zeroEnd {
-            zeroBonus = 1.0  // Both start and end at zero crossing
-        } else if metrics.zeroStart || metrics.zeroEnd {
-            zeroBonus = 0.5  // Either start or end at zero crossing
-        } else {
-            zeroBonus = 0.0  // No zero crossings
-        }
-        
-        // Detailed per-metric scores for debugging
-        print("Quality component scores:")
-        print("  Volume Score: \(volumeScore)/10 (weight: \(volumeWeight))")
-        print("  Phase Score: \(phaseScore)/10 (weight: \(phaseWeight))")
-        print("  Spectral Score: \(spectralScore)/10 (weight: \(spectralWeight))")
-        print("  Harmonic Score: \(harmonicScore)/10 (weight: \(harmonicWeight))")
-        print("  Envelope Score: \(envelopeScore)/10 (weight: \(envelopeWeight))")
-        print("  Zero Crossing Bonus: \(zeroBonus)")
-        
-        // Weighted score calculation
-        let weightedScore = volumeWeight * volumeScore +
-                          phaseWeight * phaseScore +
-                          spectralWeight * spectralScore +
-                          harmonicWeight * harmonicScore +
-                          envelopeWeight * envelopeScore +
-                          zeroBonus
-        
-        // Ensure score is within 0-10 range
-        let finalScore = max(0.0, min(10.0, weightedScore))
-        
-        print("Final quality score: \(finalScore)/10")
-        
-        return finalScore
-    }
     
     /**
      * Enhanced loop candidate selection with perceptually weighted scoring
      * that prioritizes musical coherence over simple acoustic similarity.
      */
     private func selectBestLoopCandidate() {
+        let loopCandidates = candidateStore.candidates
         guard !loopCandidates.isEmpty else {
             // Fallback to traditional section-based approach if no good candidates
             findGameMusicLoopPoints()
             return
         }
         
+        // Loop points the file was authored with win outright
+        if let tagged = loopCandidates.first(where: { $0.source == .tagged }) {
+            DispatchQueue.main.async {
+                self.suggestedLoopStart = tagged.startTime
+                self.suggestedLoopEnd = tagged.endTime
+                self.transitionQuality = tagged.quality
+                print("Selected tagged loop: \(TimeFormatter.formatPrecise(tagged.startTime)) to \(TimeFormatter.formatPrecise(tagged.endTime))")
+            }
+            return
+        }
+        
         // Apply enhanced game music specific heuristics to the candidates
         var scoredCandidates = loopCandidates.map { candidate -> (LoopCandidate, Float) in
             // Start with the base quality score
@@ -2391,58 +1930,4 @@ class MusicStructureAnalyzer: ObservableObject {
         
         return filteredPoints
     }
-
-    /**
-     * Estimates the beat interval using autocorrelation of the onset strength curve.
-     * Returns the estimated number of frames per beat.
-     */
-    private func estimateBeatInterval(_ onsetStrength: [Float]) -> Int {
-        let maxLag = min(onsetStrength.count / 2, 500) // Limit search range
-        let minBPM = 60.0 // Minimum beats per minute to consider
-        let maxBPM = 200.0 // Maximum beats per minute to consider
-        
-        // Convert BPM range to frame lags based on feature extraction rate
-        let framesPerSecond = sampleRate / Double(hopSize)
-        let minLag = Int(60.0 / maxBPM * framesPerSecond)
-        let searchMaxLag = Int(60.0 / minBPM * framesPerSecond)
-        let actualMaxLag = min(maxLag, searchMaxLag)
-        
-        // Calculate autocorrelation
-        var autocorrelation = [Float](repeating: 0, count: actualMaxLag)
-        
-        for lag in minLag..<actualMaxLag {
-            var sum: Float = 0
-            var normFactor: Float = 0
-            
-            for i in 0..<(onsetStrength.count - lag) {
-                sum += onsetStrength[i] * onsetStrength[i + lag]
-                normFactor += onsetStrength[i] * onsetStrength[i] +
-                              onsetStrength[i + lag] * onsetStrength[i + lag]
-            }
-            
-            // Normalized autocorrelation
-            autocorrelation[lag] = normFactor > 0 ? 2 * sum / normFactor : 0
-        }
-        
-        // Find peaks in autocorrelation function
-        var peakLags: [(lag: Int, value: Float)] = []
-        
-        for lag in (minLag + 1)..<(actualMaxLag - 1) {
-            if autocorrelation[lag] > autocorrelation[lag - 1] &&
-               autocorrelation[lag] > autocorrelation[lag + 1] &&
-               autocorrelation[lag] > 0.5 { // Threshold for significant correlation
-                peakLags.append((lag, autocorrelation[lag]))
-            }
-        }
-        
-        // Sort by correlation value
-        peakLags.sort { $0.value > $1.value }
-        
-        // Return the highest correlation lag as our beat interval estimate
-        if let bestLag = peakLags.first {
-            return bestLag.lag
-        }
-        
-        return 0 // No reliable beat interval found
-    }
 }
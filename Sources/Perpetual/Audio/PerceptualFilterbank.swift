@@ -0,0 +1,97 @@
+import Accelerate
+import Foundation
+
+/**
+ * PerceptualFilterbank
+ *
+ * Sums a power spectrum into Bark-scale critical bands, so band edges sit
+ * at the same frequencies whatever the sample rate or FFT size. The
+ * band-by-bin weights are a dense matrix built once per (FFT size, sample
+ * rate), and one matrix-vector product gives every band's energy.
+ * Filterbanks are immutable and shared between threads.
+ */
+final class PerceptualFilterbank {
+    let fftSize: Int
+    let sampleRate: Double
+    let bandCount: Int
+
+    /// Center of each band in Hz, lowest first
+    let centerFrequencies: [Double]
+
+    var binCount: Int {
+        return fftSize / 2
+    }
+
+    /// bandCount rows of binCount weights
+    private let weights: [Float]
+
+    /// The 24 critical bands cover hearing up to about 15.5 kHz
+    private static let maximumBandCount = 24
+
+    private init(fftSize: Int, sampleRate: Double) {
+        let binCount = fftSize / 2
+        let bandCount = max(1, min(Self.maximumBandCount, Int(Self.bark(sampleRate / 2).rounded(.down))))
+        var weights = [Float](repeating: 0, count: bandCount * binCount)
+
+        // Each bin above DC belongs to the band its Bark value falls in
+        for bin in 1..<binCount {
+            let band = max(0, Int(Self.bark(Double(bin) * sampleRate / Double(fftSize)).rounded(.down)))
+            if band < bandCount {
+                weights[band * binCount + bin] = 1
+            }
+        }
+
+        self.fftSize = fftSize
+        self.sampleRate = sampleRate
+        self.bandCount = bandCount
+        self.weights = weights
+        self.centerFrequencies = (0..<bandCount).map { Self.frequency(bark: Double($0) + 0.5) }
+    }
+
+    /**
+     * - Parameters:
+     *   - spectrum: binCount power values
+     *   - energies: Receives bandCount band energies
+     */
+    func bandEnergies(of spectrum: UnsafePointer<Float>, into energies: UnsafeMutablePointer<Float>) {
+        weights.withUnsafeBufferPointer { matrix in
+            vDSP_mmul(matrix.baseAddress!, 1, spectrum, 1, energies, 1,
+                      vDSP_Length(bandCount), 1, vDSP_Length(binCount))
+        }
+    }
+
+    // MARK: - Bark Scale
+
+    /// Traunmüller's approximation of the Bark scale
+    static func bark(_ frequency: Double) -> Double {
+        return 26.81 * frequency / (1960 + frequency) - 0.53
+    }
+
+    static func frequency(bark: Double) -> Double {
+        return 1960 * (bark + 0.53) / (26.28 - bark)
+    }
+
+    // MARK: - Shared Instances
+
+    private struct Key: Hashable {
+        let fftSize: Int
+        let sampleRate: Double
+    }
+
+    private static var cache: [Key: PerceptualFilterbank] = [:]
+    private static let cacheLock = NSLock()
+
+    /// The filterbank for this FFT size (a power of two) and sample rate
+    static func shared(fftSize: Int, sampleRate: Double) -> PerceptualFilterbank {
+        let key = Key(fftSize: fftSize, sampleRate: sampleRate)
+        cacheLock.lock()
+        defer { cacheLock.unlock() }
+
+        if let filterbank = cache[key] {
+            return filterbank
+        }
+        let filterbank = PerceptualFilterbank(fftSize: fftSize, sampleRate: sampleRate)
+        cache[key] = filterbank
+        return filterbank
+    }
+}
@@ -0,0 +1,107 @@
+import Accelerate
+
+/**
+ * ScratchArena
+ *
+ * Reusable scratch memory for DSP helpers. Buffers are lent stack-fashion
+ * from blocks the arena keeps for its whole life, so once the largest
+ * working set has been seen, borrowing allocates nothing. FFT setups and
+ * Hann windows are cached by size for the same reason. Not thread-safe;
+ * give each task its own arena.
+ */
+final class ScratchArena {
+    private struct Block {
+        let base: UnsafeMutablePointer<Float>
+        let capacity: Int
+    }
+
+    private var blocks: [Block] = []
+    private var blockIndex = 0
+    private var offset = 0
+
+    private var fftSetups: [Int: FFTSetup] = [:]
+    private var hannWindows: [Int: UnsafeMutablePointer<Float>] = [:]
+
+    /// Blocks, FFT setups and windows created so far; flat once warmed up
+    private(set) var allocationCount = 0
+
+    /**
+     * - Parameter initialCapacity: Floats in the first block
+     */
+    init(initialCapacity: Int = 1 << 16) {
+        addBlock(capacity: max(1, initialCapacity))
+    }
+
+    deinit {
+        for block in blocks {
+            block.base.deallocate()
+        }
+        for setup in fftSetups.values {
+            vDSP_destroy_fftsetup(setup)
+        }
+        for window in hannWindows.values {
+            window.deallocate()
+        }
+    }
+
+    /**
+     * Lends `count` floats for the duration of `body`. Contents are
+     * undefined; clear them if the helper accumulates. Nested calls get
+     * disjoint buffers.
+     */
+    func withFloats<Result>(_ count: Int, _ body: (UnsafeMutableBufferPointer<Float>) throws -> Result) rethrows -> Result {
+        let savedIndex = blockIndex
+        let savedOffset = offset
+        defer {
+            blockIndex = savedIndex
+            offset = savedOffset
+        }
+        return try body(take(max(0, count)))
+    }
+
+    /// Forward real FFT setup for 2^`log2n` points
+    func fftSetup(log2n: vDSP_Length) -> FFTSetup {
+        if let setup = fftSetups[Int(log2n)] {
+            return setup
+        }
+        let setup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2))!
+        fftSetups[Int(log2n)] = setup
+        allocationCount += 1
+        return setup
+    }
+
+    /// Hann window of `count` points
+    func hannWindow(count: Int) -> UnsafeBufferPointer<Float> {
+        if let window = hannWindows[count] {
+            return UnsafeBufferPointer(start: window, count: count)
+        }
+        let window = UnsafeMutablePointer<Float>.allocate(capacity: max(1, count))
+        vDSP_hann_window(window, vDSP_Length(count), Int32(0))
+        hannWindows[count] = window
+        allocationCount += 1
+        return UnsafeBufferPointer(start: window, count: count)
+    }
+
+    // MARK: - Blocks
+
+    private func take(_ count: Int) -> UnsafeMutableBufferPointer<Float> {
+        while offset + count > blocks[blockIndex].capacity {
+            if blockIndex + 1 == blocks.count {
+                addBlock(capacity: max(count, blocks[blockIndex].capacity * 2))
+            }
+            blockIndex += 1
+            offset = 0
+        }
+
+        let buffer = UnsafeMutableBufferPointer(start: blocks[blockIndex].base + offset, count: count)
+        offset += count
+        return buffer
+    }
+
+    private func addBlock(capacity: Int) {
+        let base = UnsafeMutablePointer<Float>.allocate(capacity: capacity)
+        base.initialize(repeating: 0, count: capacity)
+        blocks.append(Block(base: base, capacity: capacity))
+        allocationCount += 1
+    }
+}
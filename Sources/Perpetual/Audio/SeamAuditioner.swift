@@ -0,0 +1,110 @@
+import Foundation
+import PerpetualCore
+
+/**
+ * SeamAuditioner
+ *
+ * Builds the clip bank for seam audition: for each loop candidate, a short
+ * clip running from a few seconds before its loop end straight into the
+ * seconds after its loop start, followed by a little silence. Clips are
+ * rendered once, off the main thread, into one resident buffer with a
+ * repeating region per clip, so switching between candidates replays the
+ * seam within one render block.
+ */
+enum SeamAuditioner {
+    /// A loop seam to audition
+    struct Seam {
+        let id: UUID
+        let startFrame: Int
+        let endFrame: Int
+    }
+
+    /// Rendered seam clips and the graph that plays them
+    struct Bank {
+        let pcm: ResidentPCM
+
+        /// One on-demand region per clip, in seam order
+        let graph: SegmentGraph
+
+        /// Region index of each seam's clip
+        let regions: [UUID: Int]
+
+        /// Offset of the seam inside every clip, in frames
+        let seamOffset: Int
+    }
+
+    /// Length of the fades at the outer edges of each clip
+    static let edgeFadeFrames = 256
+
+    /**
+     * Renders the seam clips for `seams`. Blocking; call off the main thread.
+     *
+     * - Parameters:
+     *   - source: Track audio; a streamed source is decoded clip by clip
+     *   - seams: Seams to render, best first
+     *   - leadFrames: Audio kept on each side of the seam
+     *   - gapFrames: Silence after each clip so repeats are easy to tell apart
+     */
+    static func renderBank(from source: PCMSource, seams: [Seam], leadFrames: Int, gapFrames: Int) -> Bank {
+        let channelCount = source.channelCount
+        let clipFrames = leadFrames * 2 + gapFrames
+        var samples = [[Float]](repeating: [Float](repeating: 0, count: clipFrames * seams.count),
+                                count: channelCount)
+        var graph = SegmentGraph()
+        var regions: [UUID: Int] = [:]
+
+        let table = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: max(1, channelCount))
+        for channel in 0..<channelCount {
+            (table + channel).initialize(to: UnsafeMutablePointer<Float>.allocate(capacity: leadFrames * 2))
+        }
+        defer {
+            for channel in 0..<channelCount {
+                table[channel].deallocate()
+            }
+            table.deallocate()
+        }
+
+        for (index, seam) in seams.enumerated() {
+            let before = (seam.endFrame - leadFrames)..<seam.endFrame
+            let after = seam.startFrame..<(seam.startFrame + leadFrames)
+
+            if let streamed = source as? StreamedPCM {
+                streamed.prefetch([before, after])
+                streamed.waitForPrefetch()
+            }
+
+            // Tail of the loop, then its head: exactly what plays at the wrap
+            source.read(from: before.lowerBound, count: leadFrames, into: table, at: 0)
+            source.read(from: after.lowerBound, count: leadFrames, into: table, at: leadFrames)
+
+            let clipStart = index * clipFrames
+            for channel in 0..<channelCount {
+                let clip = UnsafeBufferPointer(start: table[channel], count: leadFrames * 2)
+                applyEdgeFades(to: table[channel], count: clip.count)
+                samples[channel].replaceSubrange(clipStart..<(clipStart + clip.count), with: clip)
+            }
+
+            regions[seam.id] = graph.addRegion(name: "Seam \(index + 1)",
+                                               startFrame: clipStart,
+                                               endFrame: clipStart + clipFrames,
+                                               behavior: .onDemand)
+        }
+
+        return Bank(pcm: ResidentPCM(samples: samples, sampleRate: source.sampleRate),
+                    graph: graph,
+                    regions: regions,
+                    seamOffset: leadFrames)
+    }
+
+    /// Fades the clip in and out so only the seam itself is heard as a join
+    private static func applyEdgeFades(to samples: UnsafeMutablePointer<Float>, count: Int) {
+        let fade = min(edgeFadeFrames, count / 2)
+        guard fade > 0 else { return }
+
+        for index in 0..<fade {
+            let gain = Float(index) / Float(fade)
+            samples[index] *= gain
+            samples[count - 1 - index] *= gain
+        }
+    }
+}
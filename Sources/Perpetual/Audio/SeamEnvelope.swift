@@ -0,0 +1,87 @@
+import Accelerate
+
+/**
+ * SeamEnvelope
+ *
+ * Compares the RMS envelope on either side of a loop seam. Only the
+ * segments that are compared are measured: the last few before the seam
+ * and the first few after it. Their squares are laid out as the rows of
+ * one matrix, and a single matrix-vector product with a vector of ones
+ * gives every segment's sum of squares. The comparison scores the
+ * envelope's shape and its slope across the seam in one pass.
+ */
+enum SeamEnvelope {
+    struct Comparison {
+        /// 1 minus the normalized difference between the two envelopes (0 when both are silent)
+        var shape: Float
+
+        /// 1 minus the normalized difference between the envelope's slope
+        /// just before and just after the seam; nil with fewer than two segments
+        var slope: Float?
+
+        /// Segments compared on each side
+        var segmentCount: Int
+    }
+
+    /**
+     * RMS of each consecutive `segmentSize` run of `samples`.
+     *
+     * - Parameters:
+     *   - samples: A whole number of segments
+     *   - segmentSize: Samples per segment
+     *   - output: Receives `samples.count / segmentSize` values
+     */
+    static func segmentRMS(of samples: UnsafeBufferPointer<Float>, segmentSize: Int,
+                           into output: UnsafeMutablePointer<Float>) {
+        guard segmentSize > 0, let base = samples.baseAddress else { return }
+        let count = samples.count / segmentSize
+        guard count > 0 else { return }
+
+        let span = count * segmentSize
+        withUnsafeTemporaryAllocation(of: Float.self, capacity: span + segmentSize) { scratch in
+            // Row i of the squares is segment i
+            let squares = scratch.baseAddress!
+            let ones = squares + span
+            vDSP_vsq(base, 1, squares, 1, vDSP_Length(span))
+
+            var one: Float = 1
+            vDSP_vfill(&one, ones, 1, vDSP_Length(segmentSize))
+            vDSP_mmul(squares, 1, ones, 1, output, 1, vDSP_Length(count), 1, vDSP_Length(segmentSize))
+
+            var scale = 1 / Float(segmentSize)
+            var rowCount = Int32(count)
+            vDSP_vsmul(output, 1, &scale, output, 1, vDSP_Length(count))
+            vvsqrtf(output, output, &rowCount)
+        }
+    }
+
+    /**
+     * Compares the last segments of the envelope before a seam with the
+     * first segments after it, as many as the shorter side has.
+     *
+     * - Returns: nil when either side is empty
+     */
+    static func compare(before: UnsafeBufferPointer<Float>, after: UnsafeBufferPointer<Float>) -> Comparison? {
+        let count = min(before.count, after.count)
+        guard count > 0 else { return nil }
+        let offset = before.count - count
+
+        var difference: Float = 0
+        var magnitude: Float = 0
+        for i in 0..<count {
+            difference += abs(before[offset + i] - after[i])
+            magnitude += max(before[offset + i], after[i])
+        }
+        let shape = magnitude > 0 ? 1 - difference / magnitude : 0
+
+        var slope: Float?
+        if count > 1 {
+            let slopeBefore = before[before.count - 1] - before[before.count - 2]
+            let slopeAfter = after[1] - after[0]
+            let largest = max(abs(slopeBefore), abs(slopeAfter))
+            slope = largest > 0 ? 1 - abs(slopeBefore - slopeAfter) / largest : 1
+        }
+
+        return Comparison(shape: shape, slope: slope, segmentCount: count)
+    }
+}
@@ -0,0 +1,683 @@
+import Accelerate
+import Foundation
+
+/**
+ * SeamMetrics
+ *
+ * The one place loop seams are measured. Everything about a seam can be
+ * measured from half a second on either side of it: the samples leading
+ * up to the loop end and the samples following the loop start. Each such
+ * boundary is measured once, read in place from the resident samples,
+ * and cached, so candidates that share a start or an end share its
+ * measurement. Cached values live in fixed slots of one preallocated
+ * block, so once the workers' scratch arenas are warm a seam is scored
+ * without touching the heap. A batch is measured in parallel, each
+ * worker borrowing its own scratch arena, and every pair is then scored
+ * from its two cached boundaries. Used by the candidate search, the debug
+ * view's transition report, the `seam` command and live scoring in the
+ * waveform.
+ */
+final class SeamMetrics {
+    typealias Metrics = MusicStructureAnalyzer.LoopCandidate.TransitionMetrics
+
+    /// A loop that jumps from `endFrame` back to `startFrame`
+    struct Seam: Hashable {
+        var startFrame: Int
+        var endFrame: Int
+    }
+
+    struct Score {
+        let seam: Seam
+        let metrics: Metrics
+
+        /// 0-10; see `quality(of:)`
+        let quality: Float
+    }
+
+    let sampleRate: Double
+    let frameCount: Int
+
+    /// Whether harmonic continuity is measured (neutral 0.5 otherwise)
+    let measuresHarmonicContinuity: Bool
+
+    /// Samples on each side of the seam that are compared
+    let windowSize: Int
+
+    /// Metrics of a seam that can't be measured
+    static let unmeasurable = Metrics(volumeChange: 100, phaseJump: 1, spectralDifference: 1,
+                                      harmonicContinuity: 0, envelopeContinuity: 0,
+                                      zeroStart: false, zeroEnd: false)
+
+    fileprivate let samples: UnsafePointer<Float>
+
+    // The FFT bin -> pitch class map, fixed by the sample rate
+    fileprivate static let chromaFrameSize = 2048
+    fileprivate static let chromaHopSize = 1024
+    fileprivate let chromaPitchClasses: [Int]
+    fileprivate let chromaWeights: [Float]
+
+    /// Which region (bass, low-mid, mid, high) each Bark band belongs to
+    private let bandRegions: [Int]
+
+    /// Bark bands at this sample rate; the same for every FFT size
+    fileprivate var bandCount: Int {
+        return bandRegions.count
+    }
+
+    /// Envelope segments measured next to the seam
+    fileprivate static let envelopeSegmentCount = 5
+
+    /// Floats in one boundary's slot: band energies, then chroma, then envelope
+    fileprivate var slotStride: Int {
+        return bandCount + 12 + Self.envelopeSegmentCount
+    }
+
+    private let lock = NSLock()
+    private var boundaries: [BoundaryKey: Boundary] = [:]
+    private var measurers: [BoundaryMeasurer] = []
+    private var idleMeasurers: [BoundaryMeasurer] = []
+
+    /// boundaryCacheLimit slots of boundary values; guarded by `lock`
+    private let slots: UnsafeMutablePointer<Float>
+    private var nextSlot = 0
+
+    /// Boundaries kept before the cache starts over
+    private static let boundaryCacheLimit = 8192
+
+    /**
+     * - Parameters:
+     *   - samples: Mono samples; must outlive the engine
+     *   - frameCount: Samples in `samples`
+     *   - sampleRate: Rate of `samples`
+     *   - windowDuration: Seconds compared on each side of a seam
+     *   - measuresHarmonicContinuity: Whether to compute chroma
+     */
+    init(samples: UnsafePointer<Float>, frameCount: Int, sampleRate: Double,
+         windowDuration: TimeInterval = 0.5, measuresHarmonicContinuity: Bool = true) {
+        self.samples = samples
+        self.frameCount = frameCount
+        self.sampleRate = sampleRate
+        self.windowSize = Int(sampleRate * windowDuration)
+        self.measuresHarmonicContinuity = measuresHarmonicContinuity
+
+        // Each bin's pitch class and weight are fixed, so work them out once
+        let binCount = Self.chromaFrameSize / 2
+        var pitchClasses = [Int](repeating: -1, count: binCount)
+        var weights = [Float](repeating: 0, count: binCount)
+        for bin in 1..<binCount {
+            let frequency = (Double(bin) / Double(binCount)) * (sampleRate / 2.0)
+            // Skip very low and very high frequencies
+            guard frequency >= 20.0 && frequency <= 8000.0 else { continue }
+
+            let noteNumber = 12 * log2(frequency / 440.0) + 69
+            guard noteNumber >= 0 else { continue }
+
+            pitchClasses[bin] = Int(round(noteNumber).truncatingRemainder(dividingBy: 12))
+            // Weight higher frequencies lower to emphasize bass notes
+            weights[bin] = Float(1.0 / sqrt(frequency))
+        }
+        self.chromaPitchClasses = pitchClasses
+        self.chromaWeights = weights
+
+        // Bass to 300Hz, low-mid to 1kHz, mid to 3kHz, then highs; band centers don't depend on FFT size
+        self.bandRegions = PerceptualFilterbank.shared(fftSize: 1024, sampleRate: sampleRate).centerFrequencies.map {
+            $0 < 300 ? 0 : $0 < 1000 ? 1 : $0 < 3000 ? 2 : 3
+        }
+
+        let slotStride = bandRegions.count + 12 + Self.envelopeSegmentCount
+        self.slots = UnsafeMutablePointer<Float>.allocate(capacity: Self.boundaryCacheLimit * slotStride)
+        boundaries.reserveCapacity(Self.boundaryCacheLimit)
+        measurers.reserveCapacity(ProcessInfo.processInfo.activeProcessorCount)
+        idleMeasurers.reserveCapacity(ProcessInfo.processInfo.activeProcessorCount)
+    }
+
+    deinit {
+        slots.deallocate()
+    }
+
+    /// Scratch allocations made by every worker so far; flat once warmed up.
+    /// Boundary values go into preallocated slots, so these are all scoring makes
+    var scratchAllocationCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return measurers.reduce(0) { $0 + $1.arena.allocationCount }
+    }
+
+    // MARK: - Scoring
+
+    /**
+     * Scores one seam on the calling thread.
+     */
+    func score(_ seam: Seam) -> Score {
+        guard isMeasurable(seam) else {
+            return Score(seam: seam, metrics: Self.unmeasurable, quality: Self.quality(of: Self.unmeasurable))
+        }
+
+        let beforeKey = BoundaryKey(side: .before, frame: seam.endFrame)
+        let afterKey = BoundaryKey(side: .after, frame: seam.startFrame)
+
+        // A full cache can start over between measuring one side and the other; measure again then
+        while true {
+            measureIfNeeded(beforeKey)
+            measureIfNeeded(afterKey)
+
+            lock.lock()
+            if let before = boundaries[beforeKey], let after = boundaries[afterKey] {
+                let metrics = combine(before: before, after: after)
+                lock.unlock()
+                return Score(seam: seam, metrics: metrics, quality: Self.quality(of: metrics))
+            }
+            lock.unlock()
+        }
+    }
+
+    /**
+     * Scores a batch of seams, in the order given. Each distinct start and
+     * end is measured once, the uncached ones in parallel.
+     */
+    func score(_ seams: [Seam]) async -> [Score] {
+        var keys = Set<BoundaryKey>()
+        for seam in seams where isMeasurable(seam) {
+            keys.insert(BoundaryKey(side: .before, frame: seam.endFrame))
+            keys.insert(BoundaryKey(side: .after, frame: seam.startFrame))
+        }
+
+        lock.lock()
+        let missing = Array(keys.filter { boundaries[$0] == nil })
+        lock.unlock()
+
+        let workerCount = min(ProcessInfo.processInfo.activeProcessorCount, missing.count)
+        if workerCount > 0 {
+            await withTaskGroup(of: Void.self) { group in
+                for worker in 0..<workerCount {
+                    group.addTask {
+                        let measurer = self.checkOutMeasurer()
+                        defer { self.checkIn(measurer) }
+
+                        for index in stride(from: worker, to: missing.count, by: workerCount) {
+                            if Task.isCancelled { break }
+                            let key = missing[index]
+                            self.store(measurer.measure(key), values: measurer.values, for: key)
+                        }
+                    }
+                }
+            }
+        }
+
+        return seams.map { score($0) }
+    }
+
+    private func isMeasurable(_ seam: Seam) -> Bool {
+        return seam.startFrame >= 0 && seam.endFrame > seam.startFrame && seam.endFrame < frameCount
+    }
+
+    // MARK: - Boundary Cache
+
+    fileprivate enum Side {
+        case before  // The samples leading up to a loop end
+        case after   // The samples following a loop start
+    }
+
+    fileprivate struct BoundaryKey: Hashable {
+        let side: Side
+        let frame: Int
+    }
+
+    /// What is measured on one side of a seam. The band energies, chroma
+    /// and envelope are in the boundary's slot.
+    fileprivate struct Boundary {
+        var rms: Float
+
+        /// The sample next to the seam
+        var edgeSample: Float
+
+        /// Whether the window was long enough for a spectrum
+        var hasBandEnergies: Bool
+
+        /// Whether chroma was measured
+        var hasChroma: Bool
+
+        /// RMS values of 256-sample segments next to the seam, up to five, in time order
+        var envelopeCount: Int
+
+        /// Index of the cache slot holding the values
+        var slot = 0
+    }
+
+    private func measureIfNeeded(_ key: BoundaryKey) {
+        lock.lock()
+        let isCached = boundaries[key] != nil
+        lock.unlock()
+        guard !isCached else { return }
+
+        let measurer = checkOutMeasurer()
+        store(measurer.measure(key), values: measurer.values, for: key)
+        checkIn(measurer)
+    }
+
+    /// Copies a measured boundary's values into the next slot and caches it
+    private func store(_ boundary: Boundary, values: UnsafePointer<Float>, for key: BoundaryKey) {
+        lock.lock()
+        defer { lock.unlock() }
+        guard boundaries[key] == nil else { return }
+
+        if nextSlot == Self.boundaryCacheLimit {
+            boundaries.removeAll(keepingCapacity: true)
+            nextSlot = 0
+        }
+
+        var stored = boundary
+        stored.slot = nextSlot
+        nextSlot += 1
+        (slots + stored.slot * slotStride).update(from: values, count: slotStride)
+        boundaries[key] = stored
+    }
+
+    private func checkOutMeasurer() -> BoundaryMeasurer {
+        lock.lock()
+        defer { lock.unlock() }
+        if let measurer = idleMeasurers.popLast() {
+            return measurer
+        }
+        let measurer = BoundaryMeasurer(engine: self)
+        measurers.append(measurer)
+        return measurer
+    }
+
+    private func checkIn(_ measurer: BoundaryMeasurer) {
+        lock.lock()
+        idleMeasurers.append(measurer)
+        lock.unlock()
+    }
+
+    // MARK: - Combining Boundaries
+
+    /// Called with `lock` held, so the slots can't be reused underneath
+    private func combine(before: Boundary, after: Boundary) -> Metrics {
+        let volumeChange = abs(before.rms - after.rms) / max(0.0001, max(before.rms, after.rms)) * 100
+
+        let beforeValues = UnsafePointer(slots + before.slot * slotStride)
+        let afterValues = UnsafePointer(slots + after.slot * slotStride)
+        let chromaOffset = bandCount
+        let envelopeOffset = bandCount + 12
+
+        let spectral = before.hasBandEnergies && after.hasBandEnergies && bandCount > 0
+            ? spectralDifference(beforeValues, afterValues) : 1.0
+        let harmonic = measuresHarmonicContinuity && before.hasChroma && after.hasChroma
+            ? harmonicContinuity(beforeValues + chromaOffset, afterValues + chromaOffset) : 0.5
+        let envelope = envelopeContinuity(UnsafeBufferPointer(start: beforeValues + envelopeOffset, count: before.envelopeCount),
+                                          UnsafeBufferPointer(start: afterValues + envelopeOffset, count: after.envelopeCount))
+
+        return Metrics(
+            volumeChange: volumeChange,
+            phaseJump: abs(before.edgeSample - after.edgeSample),
+            spectralDifference: spectral,
+            harmonicContinuity: harmonic,
+            envelopeContinuity: envelope,
+            zeroStart: abs(after.edgeSample) < 0.01,
+            zeroEnd: abs(before.edgeSample) < 0.01
+        )
+    }
+
+    /**
+     * Spectral difference weighted by how much each region matters to
+     * whether a seam is heard: bass most, highs least. Compared on Bark
+     * bands, so the regions sit at the same frequencies at any sample rate.
+     */
+    private func spectralDifference(_ before: UnsafePointer<Float>, _ after: UnsafePointer<Float>) -> Float {
+        var difference = SIMD4<Float>(repeating: 0)
+        var magnitude = SIMD4<Float>(repeating: 0)
+        for band in 0..<bandCount {
+            let region = bandRegions[band]
+            difference[region] += abs(before[band] - after[band])
+            magnitude[region] += max(before[band], after[band])
+        }
+
+        // Weighted average with greater emphasis on bass and low-mid
+        let weights = SIMD4<Float>(0.4, 0.3, 0.2, 0.1)
+        var score: Float = 0
+        for region in 0..<4 {
+            score += weights[region] * (magnitude[region] > 0 ? difference[region] / magnitude[region] : 1.0)
+        }
+        return score
+    }
+
+    /**
+     * How well the pitch classes sounding just before the seam carry on
+     * just after it: chroma correlation plus a bonus for shared or
+     * consonant strong pitch classes.
+     */
+    private func harmonicContinuity(_ before: UnsafePointer<Float>, _ after: UnsafePointer<Float>) -> Float {
+        // 1. Basic chromagram correlation
+        var correlation: Float = 0
+        var normBefore: Float = 0
+        var normAfter: Float = 0
+        vDSP_dotpr(before, 1, after, 1, &correlation, 12)
+        vDSP_svesq(before, 1, &normBefore, 12)
+        vDSP_svesq(after, 1, &normAfter, 12)
+        let basicCorrelation = (normBefore > 0 && normAfter > 0) ? correlation / sqrt(normBefore * normAfter) : 0
+
+        // 2. Harmonic function analysis on the strongest pitch classes
+        let strongBefore = strongPitchClasses(before)
+        let strongAfter = strongPitchClasses(after)
+        var harmonicScore: Float = 0
+
+        if strongBefore & strongAfter != 0 {
+            // Direct pitch class matches are ideal
+            harmonicScore = 1.0
+        } else if strongBefore != 0 && strongAfter != 0 {
+            for pitchBefore in 0..<12 where strongBefore & (1 << pitchBefore) != 0 {
+                for pitchAfter in 0..<12 where strongAfter & (1 << pitchAfter) != 0 {
+                    switch abs(pitchBefore - pitchAfter) % 12 {
+                    case 7, 5: harmonicScore += 0.8  // Perfect 5th / 4th
+                    case 4, 3: harmonicScore += 0.6  // Major/minor third
+                    case 9, 8: harmonicScore += 0.4  // Major/minor sixth
+                    default: harmonicScore += 0.2
+                    }
+                }
+            }
+            harmonicScore /= Float(strongBefore.nonzeroBitCount * strongAfter.nonzeroBitCount)
+        }
+
+        // Combined score with emphasis on basic correlation
+        return (basicCorrelation * 0.7) + (harmonicScore * 0.3)
+    }
+
+    /// Bit mask of pitch classes at least 60% as strong as the strongest
+    private func strongPitchClasses(_ chroma: UnsafePointer<Float>) -> UInt16 {
+        var strongest: Float = 0
+        vDSP_maxv(chroma, 1, &strongest, 12)
+        let threshold = strongest * 0.6
+        var mask: UInt16 = 0
+        for pitchClass in 0..<12 where chroma[pitchClass] >= threshold {
+            mask |= 1 << pitchClass
+        }
+        return mask
+    }
+
+    /**
+     * How smoothly the amplitude envelope, and its rate of change, flows
+     * across the seam.
+     */
+    private func envelopeContinuity(_ before: UnsafeBufferPointer<Float>, _ after: UnsafeBufferPointer<Float>) -> Float {
+        guard let comparison = SeamEnvelope.compare(before: before, after: after) else { return 0 }
+        // Not enough data for good analysis, return neutral score
+        guard let slope = comparison.slope else { return 0.5 }
+
+        // Combined score with more emphasis on basic continuity
+        return (comparison.shape * 0.7) + (slope * 0.3)
+    }
+
+    // MARK: - Quality
+
+    /**
+     * Overall 0-10 quality with perceptual weighting, so the score lines up
+     * with how noticeable a seam is to a listener.
+     */
+    static func quality(of metrics: Metrics) -> Float {
+        // Revised weights focusing on perceptually important factors
+        let volumeWeight: Float = 0.20    // Increased (very noticeable)
+        let phaseWeight: Float = 0.15     // Decreased (less perceptually important)
+        let spectralWeight: Float = 0.15  // Decreased (less perceptually important)
+        let harmonicWeight: Float = 0.30  // Increased (crucial for musical coherence)
+        let envelopeWeight: Float = 0.20  // Increased (important for rhythm continuity)
+
+        // Volume score - severe penalty for large changes
+        let volumeScore: Float
+        if metrics.volumeChange < 10 {
+            volumeScore = 10.0  // Virtually perfect
+        } else if metrics.volumeChange < 30 {
+            volumeScore = 10.0 - (metrics.volumeChange - 10) / 2.0  // Gradual penalty
+        } else if metrics.volumeChange < 60 {
+            volumeScore = 5.0 - (metrics.volumeChange - 30) / 10.0  // Steeper penalty
+        } else {
+            volumeScore = max(0.0, 2.0 - (metrics.volumeChange - 60) / 20.0)  // Very poor
+        }
+
+        // Phase jump - exponential penalty for discontinuities
+        let phaseScore = 10.0 * exp(-metrics.phaseJump * 10.0)
+
+        // Spectral difference - progressive penalty
+        let spectralScore: Float
+        if metrics.spectralDifference < 0.3 {
+            spectralScore = 10.0 - metrics.spectralDifference * 20.0  // Mild penalty
+        } else if metrics.spectralDifference < 0.7 {
+            spectralScore = 4.0 - (metrics.spectralDifference - 0.3) * 7.5  // Steeper penalty
+        } else {
+            spectralScore = max(0.0, 1.0 - (metrics.spectralDifference - 0.7) * 3.3)  // Very poor
+        }
+
+        // Harmonic continuity - reward high values
+        let harmonicScore: Float
+        if metrics.harmonicContinuity > 0.8 {
+            harmonicScore = 10.0  // Perfect score for excellent continuity
+        } else if metrics.harmonicContinuity > 0.5 {
+            harmonicScore = 7.0 + (metrics.harmonicContinuity - 0.5) * 10.0  // Bonus for good scores
+        } else if metrics.harmonicContinuity > 0.3 {
+            harmonicScore = 4.0 + (metrics.harmonicContinuity - 0.3) * 15.0  // Mid range
+        } else {
+            harmonicScore = metrics.harmonicContinuity * 13.3  // Poor range
+        }
+
+        // Envelope continuity - similar emphasis to harmonic
+        let envelopeScore: Float
+        if metrics.envelopeContinuity > 0.7 {
+            envelopeScore = 10.0  // Perfect score
+        } else if metrics.envelopeContinuity > 0.4 {
+            envelopeScore = 7.0 + (metrics.envelopeContinuity - 0.4) * 10.0  // Good range
+        } else {
+            envelopeScore = metrics.envelopeContinuity * 17.5  // Poor range
+        }
+
+        // Bonus for zero crossings
+        let zeroBonus: Float
+        if metrics.zeroStart && metrics.zeroEnd {
+            zeroBonus = 1.0  // Both start and end at zero crossing
+        } else if metrics.zeroStart || metrics.zeroEnd {
+            zeroBonus = 0.5  // Either start or end at zero crossing
+        } else {
+            zeroBonus = 0.0  // No zero crossings
+        }
+
+        // Weighted score calculation
+        let weightedScore = volumeWeight * volumeScore +
+                            phaseWeight * phaseScore +
+                            spectralWeight * spectralScore +
+                            harmonicWeight * harmonicScore +
+                            envelopeWeight * envelopeScore +
+                            zeroBonus
+
+        // Ensure score is within 0-10 range
+        return max(0.0, min(10.0, weightedScore))
+    }
+}
+
+// MARK: - Boundary Measurement
+
+/**
+ * One worker's view of the samples: measures a boundary with temporaries
+ * borrowed from its own scratch arena, leaving its values in `values` for
+ * the engine to copy into a cache slot. Not thread-safe; the engine lends
+ * each measurer to one task at a time.
+ */
+private final class BoundaryMeasurer {
+    let arena = ScratchArena()
+    unowned let engine: SeamMetrics
+
+    /// The last boundary's values, laid out as a cache slot
+    let values: UnsafeMutablePointer<Float>
+
+    /// Samples per envelope segment
+    private static let envelopeSegmentSize = 256  // ~6ms at 44.1kHz
+
+    init(engine: SeamMetrics) {
+        self.engine = engine
+        self.values = UnsafeMutablePointer<Float>.allocate(capacity: engine.slotStride)
+        values.initialize(repeating: 0, count: engine.slotStride)
+    }
+
+    deinit {
+        values.deallocate()
+    }
+
+    func measure(_ key: SeamMetrics.BoundaryKey) -> SeamMetrics.Boundary {
+        let before = key.side == .before
+        let count = before ? min(engine.windowSize, key.frame) : min(engine.windowSize, engine.frameCount - key.frame)
+        let window = UnsafeBufferPointer(start: engine.samples + (before ? key.frame - count : key.frame),
+                                         count: max(0, count))
+
+        var rms: Float = 0
+        if let base = window.baseAddress, !window.isEmpty {
+            vDSP_rmsqv(base, 1, &rms, vDSP_Length(window.count))
+        }
+
+        let chroma = values + engine.bandCount
+        return SeamMetrics.Boundary(
+            rms: rms,
+            edgeSample: (before ? window.last : window.first) ?? 0,
+            hasBandEnergies: bandEnergies(of: window, before: before, into: values),
+            hasChroma: engine.measuresHarmonicContinuity && contextChroma(of: window, before: before, into: chroma),
+            envelopeCount: envelope(of: window, before: before, into: chroma + 12)
+        )
+    }
+
+    // MARK: Spectrum
+
+    /**
+     * Bark-band energies of the largest power-of-two run of samples next to
+     * the seam. Scaled by the FFT size so windows clipped at either end of
+     * the track still compare with full ones.
+     *
+     * - Returns: false when the window is too short for a spectrum
+     */
+    private func bandEnergies(of window: UnsafeBufferPointer<Float>, before: Bool,
+                              into energies: UnsafeMutablePointer<Float>) -> Bool {
+        let size = powerOfTwo(atMost: window.count)
+        guard size >= 256 else { return false }
+
+        let filterbank = PerceptualFilterbank.shared(fftSize: size, sampleRate: engine.sampleRate)
+        let run = before ? window.suffix(size) : window.prefix(size)
+
+        arena.withFloats(filterbank.binCount) { spectrum in
+            powerSpectrum(of: UnsafeBufferPointer(rebasing: run), into: spectrum)
+            var scale = 1 / (Float(size) * Float(size))
+            vDSP_vsmul(spectrum.baseAddress!, 1, &scale, spectrum.baseAddress!, 1, vDSP_Length(filterbank.binCount))
+            filterbank.bandEnergies(of: spectrum.baseAddress!, into: energies)
+        }
+        return true
+    }
+
+    // MARK: Chroma
+
+    /**
+     * Harmonic context: the average chroma of the three frames of the
+     * window closest to the seam.
+     *
+     * - Returns: false when the window is too short
+     */
+    private func contextChroma(of window: UnsafeBufferPointer<Float>, before: Bool,
+                               into output: UnsafeMutablePointer<Float>) -> Bool {
+        guard window.count >= 1024 else { return false }
+
+        let frameCount = max(1, (window.count - SeamMetrics.chromaFrameSize) / SeamMetrics.chromaHopSize + 1)
+        let frames = before ? max(0, frameCount - 3)..<frameCount : 0..<min(3, frameCount)
+
+        averageChroma(of: window, frames: frames, into: output)
+        return true
+    }
+
+    /**
+     * Averages the normalized chroma of the given frames of `samples`.
+     * Frames running past the end are zero-padded.
+     */
+    private func averageChroma(of samples: UnsafeBufferPointer<Float>, frames: Range<Int>,
+                               into output: UnsafeMutablePointer<Float>) {
+        vDSP_vclr(output, 1, 12)
+        guard !frames.isEmpty else { return }
+
+        let frameSize = SeamMetrics.chromaFrameSize
+        let binCount = frameSize / 2
+        let window = arena.hannWindow(count: frameSize)
+        let pitchClasses = engine.chromaPitchClasses
+        let weights = engine.chromaWeights
+
+        arena.withFloats(frameSize + binCount + 12) { scratch in
+            let frame = scratch.baseAddress!
+            let spectrum = UnsafeMutableBufferPointer(rebasing: scratch[frameSize..<(frameSize + binCount)])
+            let chroma = scratch.baseAddress! + frameSize + binCount
+
+            for frameIndex in frames {
+                let start = frameIndex * SeamMetrics.chromaHopSize
+                let available = max(0, min(frameSize, samples.count - start))
+                if available > 0 {
+                    frame.update(from: samples.baseAddress! + start, count: available)
+                }
+                if available < frameSize {
+                    vDSP_vclr(frame + available, 1, vDSP_Length(frameSize - available))
+                }
+                vDSP_vmul(frame, 1, window.baseAddress!, 1, frame, 1, vDSP_Length(frameSize))
+
+                powerSpectrum(of: UnsafeBufferPointer(start: frame, count: frameSize), into: spectrum)
+
+                // Map FFT bins to the 12 pitch classes
+                vDSP_vclr(chroma, 1, 12)
+                for bin in 1..<binCount {
+                    let pitchClass = pitchClasses[bin]
+                    if pitchClass >= 0 {
+                        chroma[pitchClass] += spectrum[bin] * weights[bin]
+                    }
+                }
+
+                var maxValue: Float = 0
+                vDSP_maxv(chroma, 1, &maxValue, 12)
+                if maxValue > 0 {
+                    vDSP_vsdiv(chroma, 1, &maxValue, chroma, 1, 12)
+                }
+                vDSP_vadd(output, 1, chroma, 1, output, 1, 12)
+            }
+        }
+
+        var count = Float(frames.count)
+        vDSP_vsdiv(output, 1, &count, output, 1, 12)
+    }
+
+    // MARK: Envelope
+
+    /// - Returns: Segments measured into `output`
+    private func envelope(of window: UnsafeBufferPointer<Float>, before: Bool,
+                          into output: UnsafeMutablePointer<Float>) -> Int {
+        let segmentSize = Self.envelopeSegmentSize
+        let count = min(SeamMetrics.envelopeSegmentCount, window.count / segmentSize)
+        guard count > 0 else { return 0 }
+
+        let span = count * segmentSize
+        let run = before ? window.suffix(span) : window.prefix(span)
+        SeamEnvelope.segmentRMS(of: UnsafeBufferPointer(rebasing: run), segmentSize: segmentSize, into: output)
+        return count
+    }
+
+    // MARK: Kernels
+
+    private func powerOfTwo(atMost count: Int) -> Int {
+        return count < 2 ? 0 : 1 << (Int.bitWidth - 1 - count.leadingZeroBitCount)
+    }
+
+    /**
+     * Squared magnitudes of the FFT of `samples`, whose length must be a
+     * power of two; writes `samples.count / 2` bins.
+     */
+    private func powerSpectrum(of samples: UnsafeBufferPointer<Float>, into output: UnsafeMutableBufferPointer<Float>) {
+        let halfCount = samples.count / 2
+        let log2n = vDSP_Length(samples.count.trailingZeroBitCount)
+        let setup = arena.fftSetup(log2n: log2n)
+
+        arena.withFloats(samples.count) { split in
+            var complex = DSPSplitComplex(realp: split.baseAddress!, imagp: split.baseAddress! + halfCount)
+            samples.baseAddress!.withMemoryRebound(to: DSPComplex.self, capacity: halfCount) { interleaved in
+                vDSP_ctoz(interleaved, 2, &complex, 1, vDSP_Length(halfCount))
+            }
+            vDSP_fft_zrip(setup, &complex, 1, log2n, FFTDirection(FFT_FORWARD))
+            vDSP_zvmags(&complex, 1, output.baseAddress!, 1, vDSP_Length(halfCount))
+        }
+    }
+}
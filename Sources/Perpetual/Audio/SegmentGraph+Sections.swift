@@ -0,0 +1,50 @@
+import Foundation
+import PerpetualCore
+
+extension SegmentGraph {
+    /**
+     * Builds a graph from detected structure sections. Intro, transition and
+     * outro sections play once; loop sections repeat until switched away from.
+     * Sections are chained in time order.
+     */
+    static func fromSections(_ sections: [MusicStructureAnalyzer.AudioSection], sampleRate: Double) -> SegmentGraph {
+        var graph = SegmentGraph()
+        let ordered = sections.sorted { $0.startTime < $1.startTime }
+        var loopNumber = 0
+
+        for section in ordered {
+            let name: String
+            let behavior: Behavior
+
+            switch section.type {
+            case .intro:
+                name = "Intro"
+                behavior = .sequential
+            case .loop:
+                // Label loops A, B, C... to match how composers refer to them
+                let letter = Character(UnicodeScalar(UInt8(65 + loopNumber % 26)))
+                name = "Loop \(letter)"
+                behavior = .onDemand
+                loopNumber += 1
+            case .transition:
+                name = "Transition"
+                behavior = .sequential
+            case .outro:
+                name = "Outro"
+                behavior = .sequential
+            }
+
+            graph.addRegion(name: name,
+                            startFrame: Int(section.startTime * sampleRate),
+                            endFrame: Int(section.endTime * sampleRate),
+                            behavior: behavior)
+        }
+
+        // Chain regions in time order
+        for index in graph.regions.indices.dropLast() {
+            graph.connect(index, to: index + 1)
+        }
+
+        return graph
+    }
+}
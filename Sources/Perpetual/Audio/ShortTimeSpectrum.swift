@@ -0,0 +1,87 @@
+import Accelerate
+
+/**
+ * ShortTimeSpectrum
+ *
+ * Hann-windowed magnitude spectra of short frames read straight out of a
+ * sample buffer. The FFT setup, window and split-complex scratch are made
+ * once, so computing a frame allocates nothing. Not thread-safe; use one
+ * instance per task.
+ */
+final class ShortTimeSpectrum {
+    let fftSize: Int
+
+    /// Magnitudes written per frame (DC through just below Nyquist)
+    var binCount: Int {
+        return fftSize / 2
+    }
+
+    private let log2n: vDSP_Length
+    private let setup: FFTSetup
+    private var window: [Float]
+    private var windowed: [Float]
+    private var real: [Float]
+    private var imaginary: [Float]
+
+    /**
+     * - Parameter fftSize: Frame length; must be a power of two
+     */
+    init?(fftSize: Int) {
+        guard fftSize >= 4, fftSize & (fftSize - 1) == 0 else { return nil }
+        let log2n = vDSP_Length(fftSize.trailingZeroBitCount)
+        guard let setup = vDSP_create_fftsetup(log2n, FFTRadix(kFFTRadix2)) else { return nil }
+
+        self.fftSize = fftSize
+        self.log2n = log2n
+        self.setup = setup
+        self.window = [Float](repeating: 0, count: fftSize)
+        self.windowed = [Float](repeating: 0, count: fftSize)
+        self.real = [Float](repeating: 0, count: fftSize / 2)
+        self.imaginary = [Float](repeating: 0, count: fftSize / 2)
+        vDSP_hann_window(&window, vDSP_Length(fftSize), Int32(vDSP_HANN_NORM))
+    }
+
+    deinit {
+        vDSP_destroy_fftsetup(setup)
+    }
+
+    /**
+     * Magnitude spectrum of the frame centered on `center`. Samples past
+     * either end of the buffer read as silence.
+     *
+     * - Parameters:
+     *   - samples: Mono samples
+     *   - frameCount: Samples in `samples`
+     *   - center: Sample the frame is centered on
+     *   - output: Receives `binCount` magnitudes
+     */
+    func magnitudes(of samples: UnsafePointer<Float>, frameCount: Int, centeredAt center: Int,
+                    into output: UnsafeMutablePointer<Float>) {
+        let first = center - fftSize / 2
+        let lower = max(0, first)
+        let upper = min(frameCount, first + fftSize)
+        let halfCount = fftSize / 2
+
+        windowed.withUnsafeMutableBufferPointer { frame in
+            guard let base = frame.baseAddress else { return }
+            vDSP_vclr(base, 1, vDSP_Length(fftSize))
+            if upper > lower {
+                (base + (lower - first)).update(from: samples + lower, count: upper - lower)
+            }
+            window.withUnsafeBufferPointer { hann in
+                vDSP_vmul(base, 1, hann.baseAddress!, 1, base, 1, vDSP_Length(fftSize))
+            }
+
+            real.withUnsafeMutableBufferPointer { realp in
+                imaginary.withUnsafeMutableBufferPointer { imagp in
+                    var split = DSPSplitComplex(realp: realp.baseAddress!, imagp: imagp.baseAddress!)
+                    base.withMemoryRebound(to: DSPComplex.self, capacity: halfCount) { complex in
+                        vDSP_ctoz(complex, 2, &split, 1, vDSP_Length(halfCount))
+                    }
+                    vDSP_fft_zrip(setup, &split, 1, log2n, FFTDirection(FFT_FORWARD))
+                    vDSP_zvabs(&split, 1, output, 1, vDSP_Length(halfCount))
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,136 @@
+import Accelerate
+import Foundation
+
+/**
+ * SnapIndex
+ *
+ * Points a dragged loop handle can snap to: the beat grid, its downbeats
+ * and the loop candidates' start and end times, each kept as a sorted
+ * array so the nearest point is a binary search away. Built during
+ * analysis. Zero crossings are too many to index; `nearestZeroCrossing`
+ * finds one near the pointer on demand with a vectorized sign-change scan
+ * of the resident samples.
+ */
+struct SnapIndex {
+    enum Kind {
+        case candidate
+        case downbeat
+        case beat
+    }
+
+    struct Target {
+        let time: TimeInterval
+        let kind: Kind
+    }
+
+    private(set) var beats: [TimeInterval] = []
+    private(set) var downbeats: [TimeInterval] = []
+    private(set) var candidates: [TimeInterval] = []
+
+    mutating func setBeats(_ beats: [TimeInterval], downbeats: [TimeInterval]) {
+        self.beats = beats.sorted()
+        self.downbeats = downbeats.sorted()
+    }
+
+    /// Indexes both ends of every candidate
+    mutating func setCandidates(_ loopCandidates: [MusicStructureAnalyzer.LoopCandidate]) {
+        candidates = loopCandidates.flatMap { [$0.startTime, $0.endTime] }.sorted()
+    }
+
+    /**
+     * The point nearest `time` within `tolerance`. Candidates win over
+     * downbeats and downbeats over beats, so a strong point isn't passed
+     * over for a weaker one that happens to be a little closer.
+     */
+    func nearest(to time: TimeInterval, tolerance: TimeInterval) -> Target? {
+        let tiers: [(points: [TimeInterval], kind: Kind)] = [
+            (candidates, .candidate),
+            (downbeats, .downbeat),
+            (beats, .beat)
+        ]
+        for tier in tiers {
+            if let point = Self.nearest(in: tier.points, to: time), abs(point - time) <= tolerance {
+                return Target(time: point, kind: tier.kind)
+            }
+        }
+        return nil
+    }
+
+    /// Nearest element of a sorted array, found by binary search
+    static func nearest(in sorted: [TimeInterval], to time: TimeInterval) -> TimeInterval? {
+        guard !sorted.isEmpty else { return nil }
+
+        // First element not below `time`
+        var low = 0
+        var high = sorted.count
+        while low < high {
+            let middle = (low + high) / 2
+            if sorted[middle] < time {
+                low = middle + 1
+            } else {
+                high = middle
+            }
+        }
+
+        if low == 0 {
+            return sorted[0]
+        } else if low == sorted.count {
+            return sorted[low - 1]
+        }
+        return time - sorted[low - 1] <= sorted[low] - time ? sorted[low - 1] : sorted[low]
+    }
+
+    // MARK: - Zero Crossings
+
+    /**
+     * The zero crossing nearest `frame` within `radius` frames, as the
+     * quieter of the two samples either side of the sign change.
+     *
+     * vDSP_nzcros scans forward from `frame` for the first sign change; the
+     * samples before `frame` are reversed into scratch space and scanned
+     * the same way.
+     */
+    static func nearestZeroCrossing(in samples: UnsafePointer<Float>, frameCount: Int,
+                                    around frame: Int, radius: Int) -> Int? {
+        guard frameCount > 1, radius > 0, frame >= 0, frame < frameCount else { return nil }
+
+        let forwardCount = min(radius + 1, frameCount - frame)
+        let backwardCount = min(radius + 1, frame + 1)
+
+        var forward: Int?
+        var crossingIndex: vDSP_Length = 0
+        var crossingCount: vDSP_Length = 0
+        vDSP_nzcros(samples + frame, 1, 1, &crossingIndex, &crossingCount, vDSP_Length(forwardCount))
+        if crossingCount > 0 {
+            forward = frame + Int(crossingIndex)
+        }
+
+        var backward: Int?
+        withUnsafeTemporaryAllocation(of: Float.self, capacity: backwardCount) { reversed in
+            let base = reversed.baseAddress!
+            base.update(from: samples + frame - (backwardCount - 1), count: backwardCount)
+            vDSP_vrvrs(base, 1, vDSP_Length(backwardCount))
+            vDSP_nzcros(base, 1, 1, &crossingIndex, &crossingCount, vDSP_Length(backwardCount))
+            if crossingCount > 0 {
+                // The sample after the sign change, in forward order
+                backward = frame - Int(crossingIndex) + 1
+            }
+        }
+
+        // Each crossing is reported as the first sample of the new sign
+        let nearest: Int?
+        switch (backward, forward) {
+        case let (before?, after?):
+            nearest = frame - before <= after - frame ? before : after
+        case let (before?, nil):
+            nearest = before
+        case let (nil, after?):
+            nearest = after
+        case (nil, nil):
+            nearest = nil
+        }
+
+        guard let crossing = nearest, crossing > 0 else { return nearest }
+        return abs(samples[crossing - 1]) < abs(samples[crossing]) ? crossing - 1 : crossing
+    }
+}
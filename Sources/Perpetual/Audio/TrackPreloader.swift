@@ -0,0 +1,169 @@
+import AVFoundation
+import PerpetualCore
+
+/// A file waiting in the play queue
+struct QueuedTrack: Identifiable, Equatable {
+    let id: UUID
+    let url: URL
+
+    init(url: URL) {
+        self.id = UUID()
+        self.url = url
+    }
+}
+
+/**
+ * A queued track decoded and resolved ahead of time, so it can start
+ * without touching the disk or the analyzer.
+ */
+struct PreparedTrack {
+    let url: URL
+    let file: AVAudioFile
+    let pcm: PCMSource
+
+    /// Whole-file buffer behind `pcm` (nil when streamed)
+    let buffer: AVAudioPCMBuffer?
+
+    /// Loop points in seconds; the whole track when none were found
+    let loopStart: TimeInterval
+    let loopEnd: TimeInterval
+
+    /// EBU R128 loudness, if it could be measured
+    let loudness: LoudnessAccumulator.Measurement?
+
+    /// Chunk-ring source when the track is streamed
+    var streamedPCM: StreamedPCM? {
+        return pcm as? StreamedPCM
+    }
+}
+
+/**
+ * TrackPreloader
+ *
+ * Prepares upcoming tracks off the main thread: decodes them (or opens a
+ * chunk ring and decodes its opening), and resolves loop points and
+ * loudness from the file's tags, the analysis cache, or a fresh analysis
+ * (which caches its own results for next time).
+ */
+enum TrackPreloader {
+    /// Seconds decoded up front when a queued track is streamed
+    static let streamedLeadDuration: TimeInterval = 3
+
+    /**
+     * Memory a resident copy of the file would take, or nil if it can't be
+     * opened or is long enough that it would be streamed anyway.
+     */
+    static func residentBytes(of url: URL) -> Int? {
+        guard let file = try? AVAudioFile(forReading: url), file.length > 0 else { return nil }
+        let format = file.processingFormat
+        guard Double(file.length) / format.sampleRate <= AudioManager.residentDurationLimit else { return nil }
+        return Int(file.length) * Int(format.channelCount) * MemoryLayout<Float>.size
+    }
+
+    /**
+     * Decodes and resolves a track. Slow (it may run the full structure
+     * analysis), so call it from a background task; cancelling the task
+     * abandons any analysis in progress.
+     *
+     * - Parameters:
+     *   - url: File to prepare
+     *   - resident: Whether to decode it whole rather than stream it
+     * - Returns: nil if the file can't be read or the task was cancelled
+     */
+    static func prepare(url: URL, resident: Bool) async -> PreparedTrack? {
+        guard let file = try? AVAudioFile(forReading: url), file.length > 0 else { return nil }
+        let sampleRate = file.processingFormat.sampleRate
+
+        let pcm: PCMSource
+        var buffer: AVAudioPCMBuffer?
+        if resident {
+            guard let wholeFile = AVAudioPCMBuffer(pcmFormat: file.processingFormat,
+                                                   frameCapacity: AVAudioFrameCount(file.length)),
+                  (try? file.read(into: wholeFile)) != nil,
+                  let residentPCM = ResidentPCM(buffer: wholeFile) else { return nil }
+            buffer = wholeFile
+            pcm = residentPCM
+        } else {
+            guard let streamed = StreamedPCM(url: url) else { return nil }
+            streamed.prefetch([0..<Int(streamedLeadDuration * sampleRate)])
+            pcm = streamed
+        }
+        guard !Task.isCancelled else { return nil }
+
+        let loop = await loopPoints(for: url, pcm: pcm)
+        guard !Task.isCancelled else { return nil }
+
+        // The analyzer caches loudness as a side effect; measure only if it didn't run
+        var loudness = AnalysisCache.shared.entry(for: url)?.loudness
+        if loudness == nil, let measurement = LoudnessAccumulator.measure(url: url, shouldContinue: { !Task.isCancelled }) {
+            AnalysisCache.shared.update(url) { $0.loudness = measurement }
+            loudness = measurement
+        }
+
+        return PreparedTrack(url: url, file: file, pcm: pcm, buffer: buffer,
+                             loopStart: loop?.start ?? 0, loopEnd: loop?.end ?? pcm.duration,
+                             loudness: loudness)
+    }
+
+    /**
+     * Loop points from the file's tags, then the analysis cache, then the
+     * structure analyzer.
+     */
+    private static func loopPoints(for url: URL, pcm: PCMSource) async -> (start: TimeInterval, end: TimeInterval)? {
+        if let tagged = await taggedLoopPoints(in: url, sampleRate: pcm.sampleRate, frameCount: pcm.frameCount) {
+            return tagged
+        }
+
+        let analyzer = MusicStructureAnalyzer()
+        if let entry = AnalysisCache.shared.entry(for: url, configuration: analyzer.configuration),
+           let start = entry.loopStart, let end = entry.loopEnd, end > start {
+            return (start, end)
+        }
+
+        do {
+            try await analyzer.analyzeAudioFile(url, priority: .preload)
+        } catch {
+            print("Pre-analysis of \(url.lastPathComponent) failed: \(error.localizedDescription)")
+            return nil
+        }
+
+        // Results are published on the main queue; read them after they land
+        let suggestion = await MainActor.run { (analyzer.suggestedLoopStart, analyzer.suggestedLoopEnd) }
+        guard suggestion.1 > suggestion.0 else { return nil }
+        return suggestion
+    }
+
+    /**
+     * Loop points written into the file's metadata by game-music tools:
+     * LOOPSTART plus LOOPLENGTH or LOOPEND, in sample frames.
+     */
+    static func taggedLoopPoints(in url: URL, sampleRate: Double,
+                                 frameCount: Int) async -> (start: TimeInterval, end: TimeInterval)? {
+        guard let items = try? await AVURLAsset(url: url).load(.metadata) else { return nil }
+
+        var frames: [String: Int] = [:]
+        for item in items {
+            // Custom tags carry their name in the key, the identifier, or (ID3 TXXX) the description
+            var names = [item.identifier?.rawValue, item.key as? String].compactMap { $0?.uppercased() }
+            if let attributes = try? await item.load(.extraAttributes),
+               let description = attributes[.info] as? String {
+                names.append(description.uppercased())
+            }
+
+            for tag in ["LOOPSTART", "LOOPLENGTH", "LOOPEND"] where names.contains(where: { $0.hasSuffix(tag) }) {
+                if let text = try? await item.load(.stringValue),
+                   let value = Int(text.trimmingCharacters(in: .whitespaces)) {
+                    frames[tag] = value
+                } else if let number = try? await item.load(.numberValue) {
+                    frames[tag] = number.intValue
+                }
+            }
+        }
+
+        guard let start = frames["LOOPSTART"] else { return nil }
+        let end = frames["LOOPEND"] ?? frames["LOOPLENGTH"].map { start + $0 } ?? frameCount
+        guard start >= 0, end > start, end <= frameCount else { return nil }
+
+        return (Double(start) / sampleRate, Double(end) / sampleRate)
+    }
+}
@@ -0,0 +1,159 @@
+import Accelerate
+import Foundation
+
+/**
+ * WaveformPyramid
+ *
+ * Multi-resolution waveform summary built while the file streams through
+ * the analysis pipeline. The finest level keeps peak and mean-square level
+ * per `baseBinFrames` frames of the first channel; each coarser level halves
+ * the bin count, so any display width is served from a few thousand bins
+ * without touching the audio again.
+ */
+final class WaveformPyramid: AnalysisConsumer {
+    /// One level of the pyramid
+    struct Level {
+        /// Frames summarized by each bin
+        let binFrames: Int
+
+        /// Largest absolute sample per bin
+        var peaks: [Float]
+
+        /// Mean square per bin
+        var meanSquares: [Float]
+    }
+
+    /// Frames per bin at the finest level
+    let baseBinFrames: Int
+
+    /// Levels from finest to coarsest (filled in by `finish`)
+    private(set) var levels: [Level] = []
+
+    /// Frames summarized
+    private(set) var frameCount = 0
+
+    // Finest level while streaming, and the bin being filled
+    private var basePeaks: [Float] = []
+    private var baseMeanSquares: [Float] = []
+    private var binPeak: Float = 0
+    private var binSumOfSquares: Float = 0
+    private var binFill = 0
+
+    init(baseBinFrames: Int = 256) {
+        self.baseBinFrames = max(1, baseBinFrames)
+    }
+
+    // MARK: - AnalysisConsumer
+
+    func begin(sampleRate: Double, channelCount: Int, frameCount: Int) {
+        levels = []
+        self.frameCount = 0
+        let binCount = (frameCount + baseBinFrames - 1) / baseBinFrames
+        basePeaks = []
+        basePeaks.reserveCapacity(binCount)
+        baseMeanSquares = []
+        baseMeanSquares.reserveCapacity(binCount)
+        binPeak = 0
+        binSumOfSquares = 0
+        binFill = 0
+    }
+
+    func consume(_ chunk: AnalysisPipeline.Chunk) {
+        let samples = chunk.samples(0)
+        var position = 0
+
+        while position < chunk.frameCount {
+            let count = min(chunk.frameCount - position, baseBinFrames - binFill)
+            var peak: Float = 0
+            var sumOfSquares: Float = 0
+            vDSP_maxmgv(samples + position, 1, &peak, vDSP_Length(count))
+            vDSP_svesq(samples + position, 1, &sumOfSquares, vDSP_Length(count))
+
+            binPeak = max(binPeak, peak)
+            binSumOfSquares += sumOfSquares
+            binFill += count
+            position += count
+
+            if binFill == baseBinFrames {
+                closeBin()
+            }
+        }
+        frameCount += chunk.frameCount
+    }
+
+    func finish() {
+        if binFill > 0 {
+            closeBin()
+        }
+
+        var level = Level(binFrames: baseBinFrames, peaks: basePeaks, meanSquares: baseMeanSquares)
+        levels = [level]
+        basePeaks = []
+        baseMeanSquares = []
+
+        // Halve until a single bin remains
+        while level.peaks.count > 1 {
+            var coarser = Level(binFrames: level.binFrames * 2, peaks: [], meanSquares: [])
+            let pairs = (level.peaks.count + 1) / 2
+            coarser.peaks.reserveCapacity(pairs)
+            coarser.meanSquares.reserveCapacity(pairs)
+
+            for pair in 0..<pairs {
+                let first = pair * 2
+                let second = min(first + 1, level.peaks.count - 1)
+                coarser.peaks.append(max(level.peaks[first], level.peaks[second]))
+                coarser.meanSquares.append(second == first
+                                           ? level.meanSquares[first]
+                                           : (level.meanSquares[first] + level.meanSquares[second]) / 2)
+            }
+
+            levels.append(coarser)
+            level = coarser
+        }
+    }
+
+    private func closeBin() {
+        basePeaks.append(binPeak)
+        baseMeanSquares.append(binSumOfSquares / Float(binFill))
+        binPeak = 0
+        binSumOfSquares = 0
+        binFill = 0
+    }
+
+    // MARK: - Queries
+
+    /**
+     * RMS level of the first channel in `binCount` equal bins across the file,
+     * aggregated from the coarsest level that still has that many bins.
+     */
+    func rms(binCount: Int) -> [Float] {
+        return summary(binCount: binCount).map { sqrt($0.meanSquare) }
+    }
+
+    /**
+     * Peak level of the first channel in `binCount` equal bins across the file.
+     */
+    func peaks(binCount: Int) -> [Float] {
+        return summary(binCount: binCount).map { $0.peak }
+    }
+
+    private func summary(binCount: Int) -> [(peak: Float, meanSquare: Float)] {
+        guard binCount > 0, let finest = levels.first, !finest.peaks.isEmpty else { return [] }
+
+        // Coarsest level that still resolves every output bin
+        let level = levels.last { $0.peaks.count >= binCount } ?? finest
+        let sourceCount = level.peaks.count
+
+        return (0..<min(binCount, sourceCount)).map { bin in
+            let first = bin * sourceCount / binCount
+            let last = max(first + 1, (bin + 1) * sourceCount / binCount)
+            var peak: Float = 0
+            var meanSquare: Float = 0
+            for index in first..<last {
+                peak = max(peak, level.peaks[index])
+                meanSquare += level.meanSquares[index]
+            }
+            return (peak, meanSquare / Float(last - first))
+        }
+    }
+}
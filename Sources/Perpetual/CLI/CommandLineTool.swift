@@ -0,0 +1,376 @@
+import AVFoundation
+import Foundation
+import PerpetualCore
+
+/**
+ * CommandLineTool
+ *
+ * Headless entry point. When Perpetual is launched with a known command as
+ * its first argument it runs that command and exits instead of opening the app:
+ *
+ *     Perpetual export song.ogg -o song-extended.m4a --loops 4 --fade 12
+ *     Perpetual export song.ogg -o song-extended.m4a --preset thorough
+ *     Perpetual export --batch stage1.wav stage2.wav --output-dir extended --duration 10h
+ *     Perpetual library scan ~/Music/VGM
+ *     Perpetual library list --shorter 20s
+ *     Perpetual watch ~/Music/VGM /Volumes/Shared/Rips --jobs 4
+ *     Perpetual seam song.ogg 12.5:98.25 1m4s:2m10s
+ */
+enum CommandLineTool {
+    /// Commands recognized as the first argument
+    static let commands: Set<String> = ["export", "library", "watch", "seam", "help"]
+
+    /// Whether the arguments ask for a command rather than the app
+    static func handles(_ arguments: [String]) -> Bool {
+        return arguments.count > 1 && commands.contains(arguments[1])
+    }
+
+    /**
+     * Runs the command on a task and exits with its status. The main queue
+     * keeps being serviced, since the analyzer reports results through it.
+     */
+    static func run(_ arguments: [String]) -> Never {
+        Task {
+            let status = await execute(Array(arguments.dropFirst()))
+            exit(status)
+        }
+        dispatchMain()
+    }
+
+    private static func execute(_ arguments: [String]) async -> Int32 {
+        guard let command = arguments.first else { return usage() }
+        let options = Options(Array(arguments.dropFirst()), flags: ["batch", "unanalyzed"])
+
+        switch command {
+        case "export":
+            return await export(options)
+        case "library":
+            return library(options)
+        case "watch":
+            return await watch(options)
+        case "seam":
+            return await seam(options)
+        default:
+            return usage()
+        }
+    }
+
+    private static func usage() -> Int32 {
+        print("""
+        Usage:
+          Perpetual export <input> -o <output> [options]
+          Perpetual export --batch <input>... --output-dir <dir> [--format m4a|wav|caf|aif] [options]
+          Perpetual library scan <dir>...
+          Perpetual library list [--unanalyzed | --below <quality> | --shorter <time>] [--limit <n>]
+          Perpetual watch <dir>... [--jobs <n>] [--debounce <time>] [--preset <name>]
+          Perpetual seam <input> <start>:<end>...
+
+        Options:
+          --start <time>      Loop start (default: analyzed)
+          --end <time>        Loop end (default: analyzed)
+          --loops <n>         Loop iterations before the fade (default: 2)
+          --duration <time>   Total length instead of --loops, e.g. 3600, 90m, 10h
+          --fade <time>       Fade-out length (default: 10)
+          --below <quality>   Tracks whose loop transition scores under this (0-10)
+          --shorter <time>    Tracks whose loop is shorter than this
+          --jobs <n>          Analyses run at once while watching (default: one per core)
+          --debounce <time>   Quiet period after file events before rescanning (default: 2)
+          --preset <name>     Analysis preset: fast, balanced or thorough (default: balanced)
+        """)
+        return 64
+    }
+
+    // MARK: - Export
+
+    private static func export(_ options: Options) async -> Int32 {
+        guard analysisConfiguration(options) != nil else { return usage() }
+        var jobs: [(input: URL, output: URL)] = []
+
+        if options.flags.contains("batch") {
+            guard let directory = options.values["output-dir"], !options.positional.isEmpty else { return usage() }
+            let outputDirectory = URL(fileURLWithPath: directory, isDirectory: true)
+            let format = options.values["format"] ?? "m4a"
+
+            do {
+                try FileManager.default.createDirectory(at: outputDirectory, withIntermediateDirectories: true)
+            } catch {
+                return fail("Can't create \(directory): \(error.localizedDescription)")
+            }
+
+            for path in options.positional {
+                let input = URL(fileURLWithPath: path)
+                let name = input.deletingPathExtension().lastPathComponent + " (Extended)"
+                jobs.append((input, outputDirectory.appendingPathComponent(name).appendingPathExtension(format)))
+            }
+        } else {
+            guard options.positional.count == 1,
+                  let output = options.values["o"] ?? options.values["output"] else { return usage() }
+            jobs.append((URL(fileURLWithPath: options.positional[0]), URL(fileURLWithPath: output)))
+        }
+
+        var failures = 0
+        for (index, job) in jobs.enumerated() {
+            print("[\(index + 1)/\(jobs.count)] \(job.input.lastPathComponent) → \(job.output.lastPathComponent)")
+            do {
+                try await exportOne(input: job.input, output: job.output, options: options)
+            } catch {
+                failures += 1
+                _ = fail("\(job.input.lastPathComponent): \(error.localizedDescription)")
+            }
+        }
+
+        return failures == 0 ? 0 : 1
+    }
+
+    private static func exportOne(input: URL, output: URL, options: Options) async throws {
+        let source = try AudioManager.makeSource(for: input)
+        let (loopStart, loopEnd) = try await loopPoints(for: input, source: source, options: options)
+
+        var settings = LoopExporter.Settings(loopStartFrame: Int((loopStart * source.sampleRate).rounded()),
+                                             loopEndFrame: Int((loopEnd * source.sampleRate).rounded()))
+        settings.iterations = options.values["loops"].flatMap { Int($0) } ?? settings.iterations
+        settings.targetDuration = options.values["duration"].flatMap(parseTime)
+        settings.fadeDuration = options.values["fade"].flatMap(parseTime) ?? settings.fadeDuration
+
+        let exporter = LoopExporter(source: source, settings: settings)
+        let start = Date()
+        var lastPercent = -1
+
+        let frames = try exporter.export(to: output) { progress in
+            let percent = Int(progress * 100)
+            if percent / 10 != lastPercent / 10 {
+                lastPercent = percent
+                print("  \(percent)%")
+            }
+            return true
+        }
+
+        let seconds = Double(frames) / source.sampleRate
+        let elapsed = Date().timeIntervalSince(start)
+        print(String(format: "  wrote %@ in %.1f s (%.0fx real time)",
+                     TimeFormatter.formatLong(seconds), elapsed, seconds / max(elapsed, 0.001)))
+    }
+
+    // MARK: - Library
+
+    private static func library(_ options: Options) -> Int32 {
+        guard let subcommand = options.positional.first else { return usage() }
+        guard let index = LibraryIndex.shared else { return fail("The library index can't be opened") }
+
+        do {
+            switch subcommand {
+            case "scan":
+                let directories = options.positional.dropFirst()
+                guard !directories.isEmpty else { return usage() }
+
+                for path in directories {
+                    let start = Date()
+                    let summary = try index.scan(URL(fileURLWithPath: path, isDirectory: true)) { examined in
+                        print("  \(examined) files examined")
+                    }
+                    print(String(format: "%@: %d added, %d updated, %d unchanged, %d removed, %d unreadable (%.2f s)",
+                                 path, summary.added, summary.updated, summary.unchanged, summary.removed,
+                                 summary.failed, Date().timeIntervalSince(start)))
+                }
+
+            case "list":
+                let query: LibraryIndex.Query
+                if options.flags.contains("unanalyzed") {
+                    query = .unanalyzed
+                } else if let threshold = options.values["below"].flatMap({ Float($0) }) {
+                    query = .lowTransitionQuality(below: threshold)
+                } else if let seconds = options.values["shorter"].flatMap(parseTime) {
+                    query = .loopsShorter(than: seconds)
+                } else {
+                    query = .all
+                }
+
+                let limit = options.values["limit"].flatMap { Int($0) }
+                for track in try index.tracks(matching: query, limit: limit) {
+                    let loop = track.loopDuration.map { TimeFormatter.formatPrecise($0) } ?? "-"
+                    let quality = track.transitionQuality.map { String(format: "%.1f", $0) } ?? "-"
+                    print("\(TimeFormatter.formatStandard(track.duration))  loop \(loop)  quality \(quality)  \(track.path)")
+                }
+                let total = try index.count(matching: query)
+                print("\(total) tracks")
+
+            default:
+                return usage()
+            }
+        } catch {
+            return fail(error.localizedDescription)
+        }
+        return 0
+    }
+
+    // MARK: - Watch
+
+    /**
+     * Watches folders until interrupted, keeping the library index analyzed.
+     */
+    private static func watch(_ options: Options) async -> Int32 {
+        guard !options.positional.isEmpty else { return usage() }
+        guard let index = LibraryIndex.shared else { return fail("The library index can't be opened") }
+
+        guard let configuration = analysisConfiguration(options) else { return usage() }
+
+        let daemon = WatchFolderDaemon(
+            directories: options.positional.map { URL(fileURLWithPath: $0, isDirectory: true) },
+            index: index,
+            configuration: configuration,
+            jobs: options.values["jobs"].flatMap { Int($0) } ?? ProcessInfo.processInfo.activeProcessorCount,
+            debounce: options.values["debounce"].flatMap(parseTime) ?? 2)
+
+        print("Scanning \(options.positional.joined(separator: ", "))…")
+        guard daemon.start() else { return fail("Can't watch \(options.positional.joined(separator: ", "))") }
+        print("Watching for changes (Ctrl-C to stop)")
+
+        // Stop on Ctrl-C or SIGTERM; until then the process only wakes for file events
+        for signalNumber in [SIGINT, SIGTERM] {
+            signal(signalNumber, SIG_IGN)
+            let source = DispatchSource.makeSignalSource(signal: signalNumber, queue: .main)
+            source.setEventHandler {
+                daemon.stop()
+                print("Stopped: \(daemon.analyzedCount) analyzed, \(daemon.failedCount) failed")
+                exit(0)
+            }
+            source.resume()
+            signalSources.append(source)
+        }
+
+        while true {
+            try? await Task.sleep(nanoseconds: 3600 * 1_000_000_000)
+        }
+    }
+
+    /// Signal handlers installed by `watch`, kept alive for the life of the process
+    private static var signalSources: [DispatchSourceSignal] = []
+
+    // MARK: - Seam
+
+    /**
+     * Scores loop seams given as start:end pairs, measured on the first
+     * channel as the analyzer does. The pairs are scored as one batch.
+     */
+    private static func seam(_ options: Options) async -> Int32 {
+        guard options.positional.count > 1 else { return usage() }
+        let url = URL(fileURLWithPath: options.positional[0])
+
+        var loops: [(start: TimeInterval, end: TimeInterval)] = []
+        for argument in options.positional.dropFirst() {
+            let parts = argument.split(separator: ":", maxSplits: 1).map(String.init)
+            guard parts.count == 2, let start = parseTime(parts[0]), let end = parseTime(parts[1]) else {
+                return usage()
+            }
+            loops.append((start, end))
+        }
+
+        let buffer: AVAudioPCMBuffer
+        do {
+            let file = try AVAudioFile(forReading: url)
+            guard let pcm = AVAudioPCMBuffer(pcmFormat: file.processingFormat,
+                                             frameCapacity: AVAudioFrameCount(file.length)) else {
+                return fail("Can't allocate a buffer for \(url.lastPathComponent)")
+            }
+            try file.read(into: pcm)
+            buffer = pcm
+        } catch {
+            return fail("\(url.lastPathComponent): \(error.localizedDescription)")
+        }
+        guard let channelData = buffer.floatChannelData else { return fail("\(url.lastPathComponent) has no samples") }
+
+        let sampleRate = buffer.format.sampleRate
+        let engine = SeamMetrics(samples: channelData[0], frameCount: Int(buffer.frameLength), sampleRate: sampleRate)
+        let seams = loops.map {
+            SeamMetrics.Seam(startFrame: Int(($0.start * sampleRate).rounded()), endFrame: Int(($0.end * sampleRate).rounded()))
+        }
+
+        for (loop, score) in zip(loops, await engine.score(seams)) {
+            let metrics = score.metrics
+            print("\(TimeFormatter.formatPrecise(loop.start)) → \(TimeFormatter.formatPrecise(loop.end))  quality \(String(format: "%.1f", score.quality))")
+            print(String(format: "  volume %.2f%%  phase %.4f  spectral %.2f  harmonic %.2f  envelope %.2f  zero %@/%@",
+                         metrics.volumeChange, metrics.phaseJump, metrics.spectralDifference,
+                         metrics.harmonicContinuity, metrics.envelopeContinuity,
+                         metrics.zeroStart ? "yes" : "no", metrics.zeroEnd ? "yes" : "no"))
+        }
+        // Keep the samples alive until every seam has been measured
+        withExtendedLifetime(buffer) {}
+        return 0
+    }
+
+    /**
+     * Loop points from --start/--end, or the analyzer's suggestion. Falls back
+     * to looping the whole track when analysis finds nothing.
+     */
+    private static func loopPoints(for url: URL, source: PCMSource, options: Options) async throws -> (TimeInterval, TimeInterval) {
+        if let start = options.values["start"].flatMap(parseTime),
+           let end = options.values["end"].flatMap(parseTime) {
+            return (start, end)
+        }
+
+        let configuration = analysisConfiguration(options) ?? .balanced
+        print("  analyzing loop points (\(configuration.name))…")
+        let analyzer = MusicStructureAnalyzer(configuration: configuration)
+        try await analyzer.analyzeAudioFile(url, priority: .foreground)
+
+        // Results are published on the main queue; read them after they land
+        let suggestion = await MainActor.run { (analyzer.suggestedLoopStart, analyzer.suggestedLoopEnd) }
+        guard suggestion.1 > suggestion.0 else {
+            print("  no loop found; looping the whole track")
+            return (0, source.duration)
+        }
+
+        print("  loop \(TimeFormatter.formatPrecise(suggestion.0)) → \(TimeFormatter.formatPrecise(suggestion.1))")
+        return suggestion
+    }
+
+    // MARK: - Helpers
+
+    /// Parses seconds, or a number with an h/m/s suffix
+    static func parseTime(_ text: String) -> TimeInterval? {
+        let multipliers: [Character: Double] = ["h": 3600, "m": 60, "s": 1]
+        if let unit = text.last, let multiplier = multipliers[unit], let value = Double(text.dropLast()) {
+            return value * multiplier
+        }
+        return Double(text)
+    }
+
+    /// The preset named by --preset (balanced when absent), or nil for an unknown name
+    private static func analysisConfiguration(_ options: Options) -> AnalysisConfiguration? {
+        guard let name = options.values["preset"] else { return .balanced }
+        return AnalysisConfiguration.preset(named: name)
+    }
+
+    /// Prints an error to stderr and returns a failure status
+    @discardableResult
+    private static func fail(_ message: String) -> Int32 {
+        FileHandle.standardError.write(Data("error: \(message)\n".utf8))
+        return 1
+    }
+
+    /// Minimal `--key value` / `-k value` / `--flag` parser
+    private struct Options {
+        var positional: [String] = []
+        var values: [String: String] = [:]
+        var flags: Set<String> = []
+
+        init(_ arguments: [String], flags knownFlags: Set<String>) {
+            var index = 0
+            while index < arguments.count {
+                let argument = arguments[index]
+                if argument.hasPrefix("-") {
+                    let key = String(argument.drop { $0 == "-" })
+                    if knownFlags.contains(key) || index + 1 >= arguments.count {
+                        flags.insert(key)
+                    } else {
+                        values[key] = arguments[index + 1]
+                        index += 1
+                    }
+                } else {
+                    positional.append(argument)
+                }
+                index += 1
+            }
+        }
+    }
+}
@@ -0,0 +1,201 @@
+import Foundation
+
+/**
+ * WatchFolderDaemon
+ *
+ * Keeps the library index current for a set of folders without anyone
+ * opening the app. On start it scans each folder and analyzes whatever the
+ * index has no analysis for; after that it sleeps on FSEvents. A burst of
+ * events is collected until the folders have been quiet for `debounce`
+ * seconds, then only the folders that changed are rescanned, and only new or
+ * changed files are queued. Up to `jobs` analyses run at a time while there is
+ * a backlog; with none, nothing runs and nothing polls.
+ */
+final class WatchFolderDaemon {
+    let directories: [URL]
+    let configuration: AnalysisConfiguration
+    let jobs: Int
+    let debounce: TimeInterval
+
+    /// Analyses finished and failed since start
+    private(set) var analyzedCount = 0
+    private(set) var failedCount = 0
+
+    private let index: LibraryIndex
+    private let queue = DispatchQueue(label: "com.perpetual.watch")
+    private var watcher: FolderWatcher?
+
+    /// Folders with events since the last rescan, and the pending rescan
+    private var dirtyDirectories = Set<String>()
+    private var rescanWork: DispatchWorkItem?
+
+    /// Files waiting for analysis, in order
+    private var backlog: [URL] = []
+
+    /// Paths waiting or being analyzed, so a rescan doesn't queue them twice
+    private var scheduled = Set<String>()
+
+    /// Paths whose analysis failed; retried only if the file changes again
+    private var failed: [String: String] = [:]
+
+    private var running = 0
+
+    /**
+     * - Parameters:
+     *   - directories: Folders to watch
+     *   - index: Index results are written to
+     *   - configuration: Analysis preset to analyze with
+     *   - jobs: Most analyses run at once
+     *   - debounce: Quiet period after the last event before rescanning
+     */
+    init(directories: [URL], index: LibraryIndex, configuration: AnalysisConfiguration = .balanced,
+         jobs: Int = ProcessInfo.processInfo.activeProcessorCount, debounce: TimeInterval = 2) {
+        self.directories = directories.map { $0.standardizedFileURL }
+        self.index = index
+        self.configuration = configuration
+        self.jobs = max(1, jobs)
+        self.debounce = debounce
+    }
+
+    /**
+     * Scans every folder, queues what needs analysis and starts watching.
+     *
+     * - Returns: false if the folders can't be watched
+     */
+    func start() -> Bool {
+        queue.sync {
+            rescan(directories.map { $0.path })
+        }
+
+        let watcher = FolderWatcher(paths: directories.map { $0.path }, queue: queue) { [weak self] paths in
+            self?.noteChanges(paths)
+        }
+        guard watcher.start() else { return false }
+        self.watcher = watcher
+        return true
+    }
+
+    /// Stops watching; analyses already running finish on their own
+    func stop() {
+        queue.sync {
+            watcher?.stop()
+            watcher = nil
+            rescanWork?.cancel()
+            rescanWork = nil
+        }
+    }
+
+    // MARK: - Events
+
+    /**
+     * Records the folders a batch of events touched and restarts the quiet
+     * period, so a large copy is picked up once, after it finishes.
+     */
+    private func noteChanges(_ paths: Set<String>) {
+        for path in paths {
+            var isDirectory: ObjCBool = false
+            if FileManager.default.fileExists(atPath: path, isDirectory: &isDirectory), isDirectory.boolValue {
+                dirtyDirectories.insert(path)
+            } else {
+                // Removed files and folders are handled by rescanning their parent
+                dirtyDirectories.insert((path as NSString).deletingLastPathComponent)
+            }
+        }
+
+        rescanWork?.cancel()
+        let work = DispatchWorkItem { [weak self] in
+            guard let self = self else { return }
+            let directories = self.dirtyDirectories
+            self.dirtyDirectories = []
+            self.rescan(Array(directories))
+        }
+        rescanWork = work
+        queue.asyncAfter(deadline: .now() + debounce, execute: work)
+    }
+
+    /**
+     * Rescans folders (dropping any nested inside another one in the list),
+     * then queues their unanalyzed tracks. Runs on `queue`.
+     */
+    private func rescan(_ paths: [String]) {
+        let roots = directories.map { $0.path }
+        let candidates = paths.filter { path in roots.contains { path == $0 || path.hasPrefix($0 + "/") } }
+        let outermost = candidates.filter { path in
+            !candidates.contains { $0 != path && path.hasPrefix($0 + "/") }
+        }
+
+        for path in Set(outermost) {
+            let directory = URL(fileURLWithPath: path, isDirectory: true)
+            do {
+                let summary = try index.scan(directory)
+                if summary.added + summary.updated + summary.removed > 0 {
+                    print("\(path): \(summary.added) added, \(summary.updated) updated, \(summary.removed) removed")
+                }
+                queueUnanalyzed(under: directory)
+            } catch {
+                print("Failed to scan \(path): \(error.localizedDescription)")
+            }
+        }
+    }
+
+    // MARK: - Analysis
+
+    /// Adds the folder's unanalyzed tracks to the backlog and starts workers
+    private func queueUnanalyzed(under directory: URL) {
+        let tracks: [LibraryIndex.Track]
+        do {
+            tracks = try index.tracks(matching: .unanalyzed, under: directory)
+        } catch {
+            print("Failed to query \(directory.path): \(error.localizedDescription)")
+            return
+        }
+
+        for track in tracks where !scheduled.contains(track.path) && failed[track.path] != track.contentHash {
+            scheduled.insert(track.path)
+            backlog.append(track.url)
+        }
+        if !backlog.isEmpty {
+            print("\(backlog.count + running) tracks waiting for analysis")
+        }
+        startJobs()
+    }
+
+    /// Starts analyses until `jobs` are running or the backlog is empty
+    private func startJobs() {
+        while running < jobs, !backlog.isEmpty {
+            let url = backlog.removeFirst()
+            let configuration = self.configuration
+            running += 1
+
+            Task.detached(priority: .utility) { [weak self] in
+                let succeeded: Bool
+                do {
+                    // The analyzer writes its results to the index and the analysis cache;
+                    // backfill yields to anything a listener is waiting on
+                    try await MusicStructureAnalyzer(configuration: configuration).analyzeAudioFile(url, priority: .backfill)
+                    succeeded = true
+                } catch {
+                    print("Failed to analyze \(url.lastPathComponent): \(error.localizedDescription)")
+                    succeeded = false
+                }
+                self?.queue.async {
+                    self?.finishJob(url, succeeded: succeeded)
+                }
+            }
+        }
+    }
+
+    private func finishJob(_ url: URL, succeeded: Bool) {
+        running -= 1
+        scheduled.remove(url.path)
+
+        if succeeded {
+            analyzedCount += 1
+            print("Analyzed \(url.lastPathComponent) (\(backlog.count + running) left)")
+        } else {
+            failedCount += 1
+            failed[url.path] = (try? index.track(at: url))?.contentHash ?? ""
+        }
+        startJobs()
+    }
+}
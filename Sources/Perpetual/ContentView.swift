@@ -9,6 +9,8 @@ struct ContentView: View {
     @StateObject private var structureAnalyzer = MusicStructureAnalyzer()
     @State private var selectedFile: AVAudioFile?
     @State private var showingFilePicker = false
+    @State private var isAddingToQueue = false
+    @State private var showingExport = false
     @State private var selectedTab = 0 // Add this to track tab selection
     @State private var cancellables = Set<AnyCancellable>()
     
@@ -22,7 +24,8 @@ struct ContentView: View {
                 // Main Player Tab
                 VStack(spacing: 20) {
                     if selectedFile != nil {
-                        PlayerView(audioManager: audioManager, audioFile: $selectedFile)
+                        PlayerView(audioManager: audioManager, audioFile: $selectedFile,
+                                   snapIndex: structureAnalyzer.snapIndex)
                     } else {
                         EmptyStateView {
                             showingFilePicker = true
@@ -59,20 +62,35 @@ struct ContentView: View {
         .onAppear {
             setupEventSubscriptions()
         }
+        .sheet(isPresented: $showingExport) {
+            ExportView(audioManager: audioManager)
+        }
         .fileImporter(
             isPresented: $showingFilePicker,
             allowedContentTypes: [UTType.audio, UTType.mp3, UTType.wav, UTType.aiff],
-            allowsMultipleSelection: false
+            allowsMultipleSelection: true
         ) { result in
+            let addingToQueue = isAddingToQueue
+            isAddingToQueue = false
+            
             switch result {
             case .success(let files):
-                if let file = files.first {
+                var queued = files
+                if !addingToQueue || selectedFile == nil, let file = queued.first {
+                    queued.removeFirst()
+                    
                     // Ensure we have access to the file
                     _ = file.startAccessingSecurityScopedResource()
                     defer { file.stopAccessingSecurityScopedResource() }
                     
                     loadAudioFile(url: file)
                 }
+                
+                // Queued files are read later, so their access stays open
+                for file in queued {
+                    _ = file.startAccessingSecurityScopedResource()
+                }
+                audioManager.enqueue(queued)
             case .failure(let error):
                 print("Error loading file: \(error)")
             }
@@ -87,6 +105,30 @@ struct ContentView: View {
             }
             .store(in: &cancellables)
         
+        // Subscribe to add to queue events
+        EventBus.shared.addToQueuePublisher
+            .sink { _ in
+                isAddingToQueue = true
+                showingFilePicker = true
+            }
+            .store(in: &cancellables)
+        
+        // Follow the player when it moves on to a queued track
+        EventBus.shared.trackChangedPublisher
+            .sink { url in
+                selectedFile = try? AVAudioFile(forReading: url)
+            }
+            .store(in: &cancellables)
+        
+        // Subscribe to export events
+        EventBus.shared.exportLoopPublisher
+            .sink { _ in
+                if selectedFile != nil {
+                    showingExport = true
+                }
+            }
+            .store(in: &cancellables)
+        
         // Subscribe to seek time events
         EventBus.shared.seekToTimePublisher
             .sink { time in
@@ -94,13 +136,6 @@ struct ContentView: View {
             }
             .store(in: &cancellables)
         
-        // Subscribe to loop points changed events
-        EventBus.shared.loopPointsChangedPublisher
-            .sink { _ in
-                audioManager.setLoopPoints(start: audioManager.loopStartTime, end: audioManager.loopEndTime)
-            }
-            .store(in: &cancellables)
-            
         // Subscribe to audio error events (optional)
         EventBus.shared.audioErrorPublisher
             .sink { error in
@@ -153,6 +188,7 @@ struct HeaderView: View {
 struct PlayerView: View {
     @ObservedObject var audioManager: AudioManager
     @Binding var audioFile: AVAudioFile?
+    var snapIndex = SnapIndex()
     
     var body: some View {
         VStack(spacing: 24) {
@@ -165,7 +201,10 @@ struct PlayerView: View {
                 currentTime: $audioManager.currentTime,
                 loopStartTime: $audioManager.loopStartTime,
                 loopEndTime: $audioManager.loopEndTime,
-                duration: $audioManager.duration
+                duration: $audioManager.duration,
+                seamScorer: audioManager.seamScorer,
+                snapIndex: snapIndex,
+                findZeroCrossing: audioManager.nearestZeroCrossing(to:within:)
             )
             .frame(height: 120)
             .background(Color.black)
@@ -174,12 +213,47 @@ struct PlayerView: View {
             // Transport controls
             TransportControlsView(audioManager: audioManager)
             
+            // Live output meters
+            LevelMeterView(meter: audioManager.levelMeter)
+            
+            // Loudness normalization
+            NormalizationControlsView(audioManager: audioManager)
+            
             // Loop controls
             LoopControlsView(audioManager: audioManager)
+            
+            // Tracks to play next
+            PlayQueueView(audioManager: audioManager)
         }
     }
 }
 
+struct NormalizationControlsView: View {
+    @ObservedObject var audioManager: AudioManager
+    
+    var body: some View {
+        HStack(spacing: 16) {
+            Toggle("Normalize to \(Int(audioManager.normalizationTarget)) LUFS", isOn: $audioManager.isLoudnessNormalized)
+                .toggleStyle(.checkbox)
+            
+            Spacer()
+            
+            Text(measurementLabel)
+                .font(.system(.caption, design: .monospaced))
+                .foregroundColor(.secondary)
+        }
+        .padding(.horizontal)
+    }
+    
+    private var measurementLabel: String {
+        guard let loudness = audioManager.loudness else { return "Measuring loudness…" }
+        
+        let integrated = loudness.integratedLoudness.map { String(format: "%.1f LUFS", $0) } ?? "-∞ LUFS"
+        let gain = 20 * log10(audioManager.normalizationGain)
+        return String(format: "%@  TP %.1f dBTP  gain %+.1f dB", integrated, loudness.truePeak, gain)
+    }
+}
+
 struct EmptyStateView: View {
     let onOpenFile: () -> Void
     
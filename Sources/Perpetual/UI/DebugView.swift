@@ -90,7 +90,8 @@ struct LoopTestView: View {
 
 struct LoopTransitionDebugView: View {
     @ObservedObject var audioManager: AudioManager
-    @State private var analysisResult: String = "Press 'Analyze Loop' to evaluate the current loop points"
+    @State private var report: LoopTransitionAnalyzer.Report? = nil
+    @State private var errorMessage: String? = nil
     @State private var showingFullReport = false
     
     var body: some View {
@@ -101,7 +102,13 @@ struct LoopTransitionDebugView: View {
             HStack {
                 Button("Analyze Loop") {
                     let analyzer = LoopTransitionAnalyzer(audioManager: audioManager)
-                    analysisResult = analyzer.analyzeLoopTransition()
+                    do {
+                        report = try analyzer.analyzeLoopTransition()
+                        errorMessage = nil
+                    } catch {
+                        report = nil
+                        errorMessage = "Error: \(error.localizedDescription)"
+                    }
                 }
                 .buttonStyle(.bordered)
                 
@@ -112,13 +119,13 @@ struct LoopTransitionDebugView: View {
                 
                 Button("Copy Analysis") {
                     NSPasteboard.general.clearContents()
-                    NSPasteboard.general.setString(analysisResult, forType: .string)
+                    NSPasteboard.general.setString(displayedText(full: true), forType: .string)
                 }
                 .buttonStyle(.bordered)
             }
             
             ScrollView {
-                TextEditor(text: .constant(showingFullReport ? analysisResult : summarizeAnalysis(analysisResult)))
+                TextEditor(text: .constant(displayedText(full: showingFullReport)))
                     .font(.system(.caption, design: .monospaced))
                     .frame(maxWidth: .infinity)
                     .scrollContentBackground(.hidden)
@@ -134,14 +141,11 @@ struct LoopTransitionDebugView: View {
         .cornerRadius(8)
     }
     
-    private func summarizeAnalysis(_ analysis: String) -> String {
-        // Extract just the quality assessment section
-        if let start = analysis.range(of: "QUALITY ASSESSMENT")?.lowerBound,
-           let end = analysis.range(of: "SUGGESTIONS")?.lowerBound {
-            let section = analysis[start..<end]
-            return String(section)
+    private func displayedText(full: Bool) -> String {
+        if let report = report {
+            return full ? report.text : report.summary
         }
-        return "Analysis not available"
+        return errorMessage ?? "Press 'Analyze Loop' to evaluate the current loop points"
     }
 }
 
@@ -166,6 +170,9 @@ struct DebugView: View {
             
             // Performance Monitor
             PerformanceMonitorView()
+            
+            // Benchmarks
+            BenchmarkView()
         }
         .padding()
     }
@@ -205,12 +212,29 @@ struct AudioEngineStatusView: View {
                     Text("Loop Iteration:")
                     Text("\(audioManager.currentLoopIteration)")
                 }
+                
+                GridRow {
+                    Text("Engine:")
+                    Text(audioManager.isEngineRunning ? "✓ Running" : "• Suspended")
+                        .foregroundColor(audioManager.isEngineRunning ? .green : .gray)
+                }
+                
+                GridRow {
+                    Text("Start Latency:")
+                    Text(startLatencyLabel)
+                }
             }
         }
         .padding()
         .background(Color.secondary.opacity(0.1))
         .cornerRadius(8)
     }
+    
+    private var startLatencyLabel: String {
+        guard let latency = audioManager.lastStartLatency else { return "—" }
+        let milliseconds = String(format: "%.1f ms", latency * 1000)
+        return audioManager.lastStartWokeEngine ? milliseconds + " (wake)" : milliseconds
+    }
 }
 
 struct PerformanceMonitorView: View {
@@ -253,6 +277,7 @@ struct PerformanceMonitorView: View {
             cpuUsage = Double.random(in: 0...25)
             memoryUsage = Double.random(in: 50...200)
         }
+        performanceTimer?.tolerance = 0.5
     }
     
     private func stopPerformanceMonitoring() {
@@ -261,3 +286,60 @@ struct PerformanceMonitorView: View {
         performanceTimer = nil
     }
 }
+
+struct BenchmarkView: View {
+    @State private var results: [PerformanceBenchmarks.Result] = []
+    @State private var isRunning = false
+    
+    var body: some View {
+        VStack(alignment: .leading, spacing: 8) {
+            HStack {
+                Text("Benchmarks")
+                    .font(.headline)
+                
+                Spacer()
+                
+                if isRunning {
+                    ProgressView()
+                        .controlSize(.small)
+                }
+                
+                Button("Run Benchmarks") {
+                    runBenchmarks()
+                }
+                .buttonStyle(.bordered)
+                .disabled(isRunning)
+            }
+            
+            ForEach(results) { result in
+                HStack {
+                    Text(result.name)
+                    Spacer()
+                    Text(result.formattedValue)
+                        .font(.system(.caption, design: .monospaced))
+                }
+                .font(.caption)
+            }
+        }
+        .padding()
+        .background(Color.secondary.opacity(0.1))
+        .cornerRadius(8)
+    }
+    
+    private func runBenchmarks() {
+        isRunning = true
+        
+        // Benchmarks block for seconds; keep them off the main thread
+        DispatchQueue.global(qos: .userInitiated).async {
+            let newResults = PerformanceBenchmarks.runAll()
+            for result in newResults {
+                print("Benchmark: \(result.name) = \(result.formattedValue)")
+            }
+            
+            DispatchQueue.main.async {
+                results = newResults
+                isRunning = false
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+import SwiftUI
+import AppKit
+import UniformTypeIdentifiers
+
+/**
+ * ExportView
+ *
+ * Sheet for exporting an extended version of the current loop: a number of
+ * iterations or a fixed length, followed by a fade-out.
+ */
+struct ExportView: View {
+    @ObservedObject var audioManager: AudioManager
+    @Environment(\.dismiss) private var dismiss
+
+    /// Whether the length is given as a duration rather than an iteration count
+    @State private var usesDuration = false
+    @State private var iterations = 2
+    @State private var hours = 1.0
+    @State private var fadeDuration = 10.0
+    @State private var statusMessage: String?
+
+    var body: some View {
+        VStack(alignment: .leading, spacing: 16) {
+            Text("Export Extended Loop")
+                .font(.headline)
+
+            Text("Loop: \(TimeFormatter.formatPrecise(audioManager.loopStartTime)) → \(TimeFormatter.formatPrecise(audioManager.loopEndTime))")
+                .font(.caption)
+                .foregroundColor(.secondary)
+
+            Picker("Length", selection: $usesDuration) {
+                Text("Iterations").tag(false)
+                Text("Duration").tag(true)
+            }
+            .pickerStyle(SegmentedPickerStyle())
+
+            if usesDuration {
+                Stepper("\(String(format: "%.1f", hours)) hours", value: $hours, in: 0.5...24, step: 0.5)
+            } else {
+                Stepper("\(iterations) iterations", value: $iterations, in: 1...100)
+            }
+
+            Stepper("Fade: \(Int(fadeDuration)) s", value: $fadeDuration, in: 0...60, step: 1)
+
+            if let progress = audioManager.exportProgress {
+                ProgressView(value: progress)
+                Text("Exporting… \(Int(progress * 100))%")
+                    .font(.caption)
+            } else if let message = statusMessage {
+                Text(message)
+                    .font(.caption)
+                    .foregroundColor(.secondary)
+            }
+
+            HStack {
+                Spacer()
+
+                if audioManager.exportProgress != nil {
+                    Button("Cancel Export") {
+                        audioManager.cancelExport()
+                    }
+                } else {
+                    Button("Close") {
+                        dismiss()
+                    }
+
+                    Button("Export...") {
+                        chooseDestinationAndExport()
+                    }
+                    .keyboardShortcut(.defaultAction)
+                    .disabled(audioManager.loopEndTime <= audioManager.loopStartTime)
+                }
+            }
+        }
+        .padding()
+        .frame(width: 360)
+    }
+
+    private func chooseDestinationAndExport() {
+        let panel = NSSavePanel()
+        panel.allowedContentTypes = [.mpeg4Audio, .wav, .aiff]
+        panel.nameFieldStringValue = (audioManager.audioFileURL?.deletingPathExtension().lastPathComponent ?? "Loop")
+            + " (Extended).m4a"
+
+        guard panel.runModal() == .OK, let url = panel.url else { return }
+
+        statusMessage = nil
+        audioManager.exportExtendedLoop(to: url,
+                                        iterations: iterations,
+                                        targetDuration: usesDuration ? hours * 3600 : nil,
+                                        fadeDuration: fadeDuration) { result in
+            switch result {
+            case .success(let frames):
+                let seconds = Double(frames) / (audioManager.audioFile?.processingFormat.sampleRate ?? 44100)
+                statusMessage = "Exported \(TimeFormatter.formatLong(seconds)) to \(url.lastPathComponent)"
+            case .failure(let error):
+                statusMessage = error.localizedDescription
+            }
+        }
+    }
+}
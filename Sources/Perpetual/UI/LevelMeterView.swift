@@ -0,0 +1,93 @@
+import SwiftUI
+
+/**
+ * LevelMeterView
+ *
+ * Live peak/RMS bars per channel, momentary loudness and a small spectrum
+ * of what is actually playing, fed by `LevelMeter`.
+ */
+struct LevelMeterView: View {
+    @ObservedObject var meter: LevelMeter
+
+    var body: some View {
+        HStack(alignment: .bottom, spacing: 16) {
+            VStack(alignment: .leading, spacing: 4) {
+                ForEach(meter.levels.peak.indices, id: \.self) { channel in
+                    ChannelMeterBar(peak: meter.levels.peak[channel], rms: meter.levels.rms[channel])
+                        .frame(height: 6)
+                }
+
+                Text(loudnessLabel)
+                    .font(.system(.caption, design: .monospaced))
+                    .foregroundColor(.secondary)
+            }
+
+            SpectrumView(bands: meter.levels.spectrum)
+                .frame(width: 160, height: 40)
+        }
+        .padding(8)
+        .background(Color.secondary.opacity(0.1))
+        .cornerRadius(8)
+    }
+
+    private var loudnessLabel: String {
+        let loudness = meter.levels.momentaryLoudness
+        return loudness <= LevelMeter.floor ? "-∞ LUFS" : String(format: "%.1f LUFS", loudness)
+    }
+}
+
+/// One channel: RMS as a filled bar, peak as a thin marker
+struct ChannelMeterBar: View {
+    let peak: Float
+    let rms: Float
+
+    var body: some View {
+        GeometryReader { geometry in
+            ZStack(alignment: .leading) {
+                Rectangle()
+                    .fill(Color.black.opacity(0.3))
+
+                Rectangle()
+                    .fill(barColor)
+                    .frame(width: geometry.size.width * fraction(rms))
+
+                Rectangle()
+                    .fill(peak > -1 ? Color.red : Color.white)
+                    .frame(width: 2)
+                    .offset(x: max(0, geometry.size.width * fraction(peak) - 2))
+            }
+        }
+        .cornerRadius(2)
+    }
+
+    private var barColor: Color {
+        rms > -9 ? .orange : .green
+    }
+
+    /// Maps dB onto 0...1 across the meter range
+    private func fraction(_ decibels: Float) -> CGFloat {
+        CGFloat(max(0, min(1, (decibels - LevelMeter.floor) / -LevelMeter.floor)))
+    }
+}
+
+/// Bars for each spectrum band
+struct SpectrumView: View {
+    let bands: [Float]
+
+    var body: some View {
+        GeometryReader { geometry in
+            HStack(alignment: .bottom, spacing: 1) {
+                ForEach(bands.indices, id: \.self) { band in
+                    Rectangle()
+                        .fill(Color.accentColor.opacity(0.8))
+                        .frame(height: geometry.size.height * height(bands[band]))
+                }
+            }
+            .frame(maxHeight: .infinity, alignment: .bottom)
+        }
+    }
+
+    private func height(_ decibels: Float) -> CGFloat {
+        CGFloat(max(0.02, min(1, (decibels - LevelMeter.floor) / -LevelMeter.floor)))
+    }
+}
@@ -4,10 +4,22 @@ struct LoopCandidatesView: View {
     @ObservedObject var analyzer: MusicStructureAnalyzer
     @ObservedObject var audioManager: AudioManager
     
+    /// When on, tapping a candidate plays its seam instead of applying it
+    @State private var isAuditioning = false
+    
     var body: some View {
         VStack(spacing: 8) {
-            Text("Loop Candidates")
-                .font(.headline)
+            HStack {
+                Text("Loop Candidates")
+                    .font(.headline)
+                
+                Spacer()
+                
+                Toggle("Audition Seams", isOn: $isAuditioning)
+                    .toggleStyle(.switch)
+                    .font(.caption)
+                    .disabled(analyzer.loopCandidates.isEmpty)
+            }
             
             if analyzer.loopCandidates.isEmpty {
                 Text("No high-quality loop candidates found")
@@ -21,14 +33,25 @@ struct LoopCandidatesView: View {
                         CandidateRow(
                             candidate: candidate,
                             isSelected: candidate.startTime == analyzer.suggestedLoopStart &&
-                                      candidate.endTime == analyzer.suggestedLoopEnd
+                                      candidate.endTime == analyzer.suggestedLoopEnd,
+                            auditionState: auditionState(for: candidate)
                         )
                         .contentShape(Rectangle())
-                        .onTapGesture {
-                            // Apply this candidate when tapped
+                        .onTapGesture(count: 2) {
+                            // Double-tap always applies, so a seam heard in audition can be kept
+                            audioManager.stopAudition()
                             audioManager.setLoopPoints(start: candidate.startTime, end: candidate.endTime)
                             EventBus.shared.publishLoopPointsChanged()
                         }
+                        .onTapGesture {
+                            if isAuditioning {
+                                audioManager.auditionSeam(of: candidate)
+                            } else {
+                                // Apply this candidate when tapped
+                                audioManager.setLoopPoints(start: candidate.startTime, end: candidate.endTime)
+                                EventBus.shared.publishLoopPointsChanged()
+                            }
+                        }
                     }
                 }
                 .frame(height: 200)
@@ -38,12 +61,46 @@ struct LoopCandidatesView: View {
         .padding()
         .background(Color.secondary.opacity(0.1))
         .cornerRadius(8)
+        .onChange(of: isAuditioning) { enabled in
+            if enabled {
+                audioManager.prepareSeamAudition(for: analyzer.loopCandidates)
+            } else {
+                audioManager.stopAudition()
+            }
+        }
+        .onChange(of: analyzer.loopCandidates.map { $0.id }) { _ in
+            // New analysis results need new clips
+            if isAuditioning {
+                audioManager.prepareSeamAudition(for: analyzer.loopCandidates)
+            }
+        }
+    }
+    
+    private func auditionState(for candidate: MusicStructureAnalyzer.LoopCandidate) -> CandidateRow.AuditionState {
+        guard isAuditioning else { return .off }
+        if audioManager.auditioningCandidateID == candidate.id {
+            return .playing
+        }
+        if audioManager.auditionReadyIDs.isEmpty {
+            return .preparing
+        }
+        // Only the top candidates get clips
+        return audioManager.auditionReadyIDs.contains(candidate.id) ? .ready : .off
     }
 }
 
 struct CandidateRow: View {
+    /// Seam audition status shown at the end of the row
+    enum AuditionState {
+        case off
+        case preparing
+        case ready
+        case playing
+    }
+    
     let candidate: MusicStructureAnalyzer.LoopCandidate
     let isSelected: Bool
+    var auditionState: AuditionState = .off
     
     var body: some View {
         HStack {
@@ -60,23 +117,43 @@ struct CandidateRow: View {
                         .font(.caption)
                 }
                 
-                HStack(spacing: 12) {
-                    MetricView(name: "Vol", value: candidate.metrics.volumeChange, format: "%.1f%%",
-                               isGood: candidate.metrics.volumeChange < 10)
-                    
-                    MetricView(name: "Phase", value: candidate.metrics.phaseJump, format: "%.3f",
-                               isGood: candidate.metrics.phaseJump < 0.1)
-                    
-                    MetricView(name: "Spec", value: candidate.metrics.spectralDifference * 100, format: "%.1f%%",
-                               isGood: candidate.metrics.spectralDifference < 0.2)
-                    
-                    MetricView(name: "Harm", value: candidate.metrics.harmonicContinuity * 100, format: "%.1f%%",
-                               isGood: candidate.metrics.harmonicContinuity > 0.7)
+                if !candidate.isMeasured {
+                    Text("Estimated from features; refining…")
+                        .font(.caption2)
+                        .foregroundColor(.secondary)
+                } else {
+                    HStack(spacing: 12) {
+                        MetricView(name: "Vol", value: candidate.metrics.volumeChange, format: "%.1f%%",
+                                   isGood: candidate.metrics.volumeChange < 10)
+                        
+                        MetricView(name: "Phase", value: candidate.metrics.phaseJump, format: "%.3f",
+                                   isGood: candidate.metrics.phaseJump < 0.1)
+                        
+                        MetricView(name: "Spec", value: candidate.metrics.spectralDifference * 100, format: "%.1f%%",
+                                   isGood: candidate.metrics.spectralDifference < 0.2)
+                        
+                        MetricView(name: "Harm", value: candidate.metrics.harmonicContinuity * 100, format: "%.1f%%",
+                                   isGood: candidate.metrics.harmonicContinuity > 0.7)
+                    }
                 }
             }
             
             Spacer()
             
+            switch auditionState {
+            case .off:
+                EmptyView()
+            case .preparing:
+                ProgressView()
+                    .controlSize(.small)
+            case .ready:
+                Image(systemName: "speaker.wave.1")
+                    .foregroundColor(.secondary)
+            case .playing:
+                Image(systemName: "speaker.wave.3.fill")
+                    .foregroundColor(.accentColor)
+            }
+            
             if isSelected {
                 Image(systemName: "checkmark.circle.fill")
                     .foregroundColor(.accentColor)
@@ -0,0 +1,72 @@
+import SwiftUI
+
+/**
+ * PlayQueueView
+ *
+ * The tracks queued after the current one, whether each is preloaded yet,
+ * and controls to skip ahead or remove entries.
+ */
+struct PlayQueueView: View {
+    @ObservedObject var audioManager: AudioManager
+
+    var body: some View {
+        VStack(alignment: .leading, spacing: 8) {
+            HStack {
+                Text("Up Next")
+                    .font(.headline)
+
+                Spacer()
+
+                Text(preloadLabel)
+                    .font(.system(.caption, design: .monospaced))
+                    .foregroundColor(.secondary)
+
+                Button("Add…") {
+                    EventBus.shared.publishAddToQueue()
+                }
+
+                Button(action: audioManager.playNextTrack) {
+                    Image(systemName: "forward.end.fill")
+                }
+                .disabled(audioManager.queue.isEmpty)
+                .help("Play the next track now")
+            }
+
+            if audioManager.queue.isEmpty {
+                Text("Queue files to play them back to back without gaps")
+                    .font(.caption)
+                    .foregroundColor(.secondary)
+            }
+
+            ForEach(audioManager.queue) { track in
+                HStack {
+                    Image(systemName: audioManager.readyTrackIDs.contains(track.id) ? "checkmark.circle.fill" : "hourglass")
+                        .foregroundColor(audioManager.readyTrackIDs.contains(track.id) ? .green : .secondary)
+                        .help(audioManager.readyTrackIDs.contains(track.id) ? "Preloaded" : "Waiting to preload")
+
+                    Text(track.url.lastPathComponent)
+                        .lineLimit(1)
+
+                    Spacer()
+
+                    Button {
+                        audioManager.removeFromQueue(track.id)
+                    } label: {
+                        Image(systemName: "xmark.circle")
+                    }
+                    .buttonStyle(.borderless)
+                }
+                .font(.caption)
+            }
+        }
+        .padding(8)
+        .background(Color.secondary.opacity(0.1))
+        .cornerRadius(8)
+    }
+
+    private var preloadLabel: String {
+        let megabytes = Double(audioManager.preloadedBytes) / 1_048_576
+        let budget = Double(audioManager.preloadMemoryBudget) / 1_048_576
+        return String(format: "%.0f / %.0f MB preloaded", megabytes, budget)
+    }
+}
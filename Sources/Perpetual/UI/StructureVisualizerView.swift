@@ -8,6 +8,7 @@
 import SwiftUI
 import AVFoundation
 import Combine
+import PerpetualCore
 
 /**
  * StructureVisualizerView
@@ -23,13 +24,15 @@ struct StructureVisualizerView: View {
     var body: some View {
         VStack(spacing: 16) {
             if analyzer.isAnalyzing {
-                // Show progress during analysis
+                // Show progress during analysis; early results appear below as they land
                 ProgressView(value: analyzer.progress) {
                     Text("Analyzing Structure: \(Int(analyzer.progress * 100))%")
                 }
                 .progressViewStyle(.linear)
                 .padding()
-            } else if !analyzer.sections.isEmpty {
+            }
+            
+            if !analyzer.sections.isEmpty || !analyzer.loopCandidates.isEmpty {
                 // Structure visualization
                 StructureView(sections: analyzer.sections,
                              currentTime: audioManager.currentTime,
@@ -52,6 +55,12 @@ struct StructureVisualizerView: View {
                     Text("Suggested Loop Points:")
                         .font(.caption)
                     
+                    if analyzer.isProvisional {
+                        Text("(provisional)")
+                            .font(.caption)
+                            .foregroundColor(.secondary)
+                    }
+                    
                     Text("Start: \(TimeFormatter.formatPrecise(analyzer.suggestedLoopStart))")
                         .font(.caption)
                         .foregroundColor(.green)
@@ -97,12 +106,33 @@ struct StructureVisualizerView: View {
                     }
                     .buttonStyle(.bordered)
                     
+                    Button("Play Sections") {
+                        let graph = SegmentGraph.fromSections(analyzer.sections,
+                                                              sampleRate: audioManager.audioFile?.processingFormat.sampleRate ?? 44100)
+                        audioManager.playSegmentGraph(graph)
+                    }
+                    .buttonStyle(.bordered)
+                    
+                    // Queue a jump to another region at the next region boundary
+                    if let graph = audioManager.segmentGraph {
+                        Menu("Go To: \(audioManager.currentRegionName ?? "—")") {
+                            ForEach(graph.regions) { region in
+                                Button(region.name) {
+                                    audioManager.queueTransition(to: region.name)
+                                }
+                            }
+                        }
+                        .fixedSize()
+                    }
+                    
                     Spacer()
                     
                     Text("Loop Duration: \(TimeFormatter.formatStandard(analyzer.suggestedLoopEnd - analyzer.suggestedLoopStart))")
                         .font(.caption)
                         .foregroundColor(.secondary)
                 }
+            } else if analyzer.isAnalyzing {
+                EmptyView()
             } else if analyzer.error != nil {
                 // Error state
                 VStack {
@@ -114,7 +144,7 @@ struct StructureVisualizerView: View {
                     Button("Retry") {
                         if let audioFile = audioManager.audioFile {
                             Task {
-                                try? await analyzer.analyzeAudioFile(audioFile.url)
+                                try? await analyzer.analyzeAudioFile(audioFile.url, priority: .foreground)
                             }
                         }
                     }
@@ -133,7 +163,7 @@ struct StructureVisualizerView: View {
                         Button("Analyze Structure") {
                             if let audioFile = audioManager.audioFile {
                                 Task {
-                                    try? await analyzer.analyzeAudioFile(audioFile.url)
+                                    try? await analyzer.analyzeAudioFile(audioFile.url, priority: .foreground)
                                 }
                             }
                         }
@@ -11,11 +11,27 @@ struct WaveformView: View {
     @Binding var loopStartTime: TimeInterval
     @Binding var loopEndTime: TimeInterval
     @Binding var duration: TimeInterval
+    @ObservedObject var seamScorer: LiveSeamScorer
+    
+    /// Beats, downbeats and candidate ends the handles snap to
+    var snapIndex = SnapIndex()
+    
+    /// Nearest zero crossing to a time within a radius, both in seconds
+    var findZeroCrossing: (TimeInterval, TimeInterval) -> TimeInterval? = { _, _ in nil }
+    
+    /// How close, in points, a handle has to come to a point to snap to it
+    private static let snapDistance: CGFloat = 8
+    
+    /// Farthest a handle is moved to land on a zero crossing
+    private static let zeroCrossingRadius: TimeInterval = 0.005
     
     @State private var isDraggingStart = false
     @State private var isDraggingEnd = false
     @State private var isSeekingPosition = false
     
+    // The seam score is shown next to the handle moved last
+    @State private var scoresEndHandle = false
+    
     var body: some View {
         GeometryReader { geometry in
             ZStack {
@@ -78,7 +94,10 @@ struct WaveformView: View {
                         geometry: geometry,
                         color: .green,
                         isDragging: $isDraggingStart,
-                        label: "START"
+                        label: "START",
+                        seamQuality: scoresEndHandle ? nil : seamScorer.quality,
+                        isEstimate: seamScorer.isEstimate,
+                        snap: { snappedTime($0, width: geometry.size.width) }
                     )
                     
                     // End marker
@@ -88,7 +107,10 @@ struct WaveformView: View {
                         geometry: geometry,
                         color: .orange,
                         isDragging: $isDraggingEnd,
-                        label: "END"
+                        label: "END",
+                        seamQuality: scoresEndHandle ? seamScorer.quality : nil,
+                        isEstimate: seamScorer.isEstimate,
+                        snap: { snappedTime($0, width: geometry.size.width) }
                     )
                 }
             }
@@ -98,6 +120,26 @@ struct WaveformView: View {
             .onChange(of: audioFile) { _ in
                 loadWaveform()
             }
+            .onChange(of: loopStartTime) { _ in
+                if isDraggingStart { scoreSeam(final: false) }
+            }
+            .onChange(of: loopEndTime) { _ in
+                if isDraggingEnd { scoreSeam(final: false) }
+            }
+            .onChange(of: isDraggingStart) { dragging in
+                if dragging {
+                    scoresEndHandle = false
+                } else {
+                    scoreSeam(final: true)
+                }
+            }
+            .onChange(of: isDraggingEnd) { dragging in
+                if dragging {
+                    scoresEndHandle = true
+                } else {
+                    scoreSeam(final: true)
+                }
+            }
             .onTapGesture { location in
                 // Seek to tapped position
                 if !isDraggingStart && !isDraggingEnd {
@@ -114,6 +156,33 @@ struct WaveformView: View {
         guard let file = audioFile else { return }
         waveformData.generateWaveform(from: file)
     }
+    
+    /**
+     * Where a handle dragged to `time` lands: on a nearby candidate end,
+     * downbeat or beat, in that order, else on the zero crossing nearest
+     * the pointer. Grid points are only as precise as the analysis hop, so
+     * they are moved onto a zero crossing too. Holding Option turns
+     * snapping off.
+     */
+    private func snappedTime(_ time: TimeInterval, width: CGFloat) -> TimeInterval {
+        guard !NSEvent.modifierFlags.contains(.option), width > 0, duration > 0 else { return time }
+        let tolerance = Double(Self.snapDistance / width) * duration
+        
+        if let target = snapIndex.nearest(to: time, tolerance: tolerance) {
+            // Candidate ends are already aligned on the samples
+            guard target.kind != .candidate else { return target.time }
+            return findZeroCrossing(target.time, Self.zeroCrossingRadius) ?? target.time
+        }
+        return findZeroCrossing(time, min(tolerance, Self.zeroCrossingRadius)) ?? time
+    }
+    
+    private func scoreSeam(final: Bool) {
+        if final {
+            seamScorer.finish(loopStart: loopStartTime, loopEnd: loopEndTime)
+        } else {
+            seamScorer.update(loopStart: loopStartTime, loopEnd: loopEndTime)
+        }
+    }
 }
 
 struct LoopMarker: View {
@@ -123,6 +192,9 @@ struct LoopMarker: View {
     let color: Color
     @Binding var isDragging: Bool
     let label: String
+    var seamQuality: Float? = nil
+    var isEstimate = false
+    var snap: (TimeInterval) -> TimeInterval = { $0 }
     
     var body: some View {
         let x = (time / duration) * geometry.size.width
@@ -162,6 +234,18 @@ struct LoopMarker: View {
                     .scaleEffect(isDragging ? 1.4 : 1.0)
                     .animation(.easeInOut(duration: 0.2), value: isDragging)
                 
+                // Seam quality at this position (0-10)
+                if let quality = seamQuality {
+                    Text((isEstimate ? "~" : "") + String(format: "%.1f", quality))
+                        .font(.system(.caption2, design: .monospaced))
+                        .fontWeight(.bold)
+                        .foregroundColor(qualityColor(quality))
+                        .padding(.horizontal, 4)
+                        .padding(.vertical, 2)
+                        .background(Color.black.opacity(0.7))
+                        .cornerRadius(3)
+                }
+                
                 Spacer()
             }
         }
@@ -172,7 +256,7 @@ struct LoopMarker: View {
                     isDragging = true
                     let newX = max(0, min(value.location.x, geometry.size.width))
                     let newTime = (newX / geometry.size.width) * duration
-                    time = newTime
+                    time = max(0, min(snap(newTime), duration))
                 }
                 .onEnded { _ in
                     isDragging = false
@@ -181,6 +265,21 @@ struct LoopMarker: View {
                 }
         )
     }
+    
+    private func qualityColor(_ quality: Float) -> Color {
+        switch quality {
+        case 0..<3:
+            return .red
+        case 3..<5:
+            return .orange
+        case 5..<7:
+            return .yellow
+        case 7..<9:
+            return .green
+        default:
+            return .blue
+        }
+    }
 }
 
 class WaveformData: ObservableObject {
@@ -197,43 +296,22 @@ class WaveformData: ObservableObject {
     }
     
     private func generateWaveformPath(from audioFile: AVAudioFile) -> Path? {
-        let frameCount = Int(audioFile.length)
-        let samplesPerPixel = max(1, frameCount / resolution)
-        
-        // Reset file position
-        audioFile.framePosition = 0
-        
-        // Read audio data
-        guard let buffer = AVAudioPCMBuffer(pcmFormat: audioFile.processingFormat, frameCapacity: AVAudioFrameCount(frameCount)) else { return nil }
+        // Stream the file through the analysis pipeline instead of reading it whole
+        guard let pipeline = AnalysisPipeline(url: audioFile.url) else { return nil }
+        let pyramid = WaveformPyramid()
+        pipeline.add(pyramid)
         
         do {
-            try audioFile.read(into: buffer)
+            try pipeline.run()
         } catch {
             print("Error reading audio file: \(error)")
             EventBus.shared.publishAudioError(error)
             return nil
         }
         
-        guard let channelData = buffer.floatChannelData,
-              buffer.frameLength > 0 else { return nil }
-        
-        let samples = channelData[0]
-        var waveformSamples: [Float] = []
-        
-        // Downsample with RMS for better representation
-        for i in stride(from: 0, to: frameCount, by: samplesPerPixel) {
-            let endIndex = min(i + samplesPerPixel, frameCount)
-            var sum: Float = 0
-            var count = 0
-            
-            for j in i..<endIndex {
-                sum += samples[j] * samples[j]
-                count += 1
-            }
-            
-            let rms = count > 0 ? sqrt(sum / Float(count)) : 0
-            waveformSamples.append(rms)
-        }
+        // RMS per pixel column for better representation
+        let waveformSamples = pyramid.rms(binCount: resolution)
+        guard !waveformSamples.isEmpty else { return nil }
         
         // Create path with normalized width of 400 (will be scaled by the view)
         var path = Path()
@@ -0,0 +1,114 @@
+import Foundation
+
+/**
+ * AnalysisCache
+ *
+ * Per-file analysis results kept on disk, so a track is measured once and
+ * every later load can use the results straight away. Entries are keyed by
+ * path, size and modification date, so an edited file is measured again.
+ * Results that depend on how the analysis was configured (loop points) are
+ * kept in a separate entry per configuration. Each entry is a small JSON
+ * file in the user's caches directory.
+ */
+final class AnalysisCache {
+    /// What is remembered about one file
+    struct Entry: Codable {
+        /// EBU R128 loudness of the whole file
+        var loudness: LoudnessAccumulator.Measurement?
+
+        /// Loop points found by the structure analyzer, in seconds
+        var loopStart: TimeInterval?
+        var loopEnd: TimeInterval?
+    }
+
+    static let shared = AnalysisCache()
+
+    private let directory: URL?
+    private let queue = DispatchQueue(label: "com.perpetual.analysiscache")
+
+    /// Entries already read or written this session
+    private var memory: [String: Entry] = [:]
+
+    /**
+     * - Parameter directory: Where entries are stored (defaults to the user's caches)
+     */
+    init(directory: URL? = nil) {
+        if let directory = directory {
+            self.directory = directory
+        } else {
+            self.directory = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first?
+                .appendingPathComponent("Perpetual/Analysis", isDirectory: true)
+        }
+    }
+
+    /**
+     * The cached entry for a file, if it was analyzed in its current state.
+     *
+     * - Parameters:
+     *   - url: The file
+     *   - configuration: Analysis settings the entry's loop points came from;
+     *     nil for configuration-independent results such as loudness
+     */
+    func entry(for url: URL, configuration: AnalysisConfiguration? = nil) -> Entry? {
+        guard let key = AnalysisCache.key(for: url, configuration: configuration) else { return nil }
+
+        return queue.sync {
+            if let entry = memory[key] {
+                return entry
+            }
+            guard let file = fileURL(for: key),
+                  let data = try? Data(contentsOf: file),
+                  let entry = try? JSONDecoder().decode(Entry.self, from: data) else { return nil }
+            memory[key] = entry
+            return entry
+        }
+    }
+
+    /**
+     * Changes the entry for a file (creating it if needed) and writes it out.
+     */
+    func update(_ url: URL, configuration: AnalysisConfiguration? = nil, _ change: (inout Entry) -> Void) {
+        guard let key = AnalysisCache.key(for: url, configuration: configuration) else { return }
+
+        queue.sync {
+            var entry = memory[key]
+                ?? fileURL(for: key).flatMap { try? Data(contentsOf: $0) }.flatMap { try? JSONDecoder().decode(Entry.self, from: $0) }
+                ?? Entry()
+            change(&entry)
+            memory[key] = entry
+
+            guard let directory = directory, let file = fileURL(for: key) else { return }
+            do {
+                try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+                try JSONEncoder().encode(entry).write(to: file, options: .atomic)
+            } catch {
+                print("Failed to write analysis cache entry: \(error)")
+            }
+        }
+    }
+
+    private func fileURL(for key: String) -> URL? {
+        return directory?.appendingPathComponent(key).appendingPathExtension("json")
+    }
+
+    /**
+     * Cache key for a file in its current state: a 64-bit FNV-1a hash of its
+     * path, size and modification date, plus the configuration's fingerprint
+     * when given.
+     */
+    static func key(for url: URL, configuration: AnalysisConfiguration? = nil) -> String? {
+        guard let values = try? url.resourceValues(forKeys: [.fileSizeKey, .contentModificationDateKey]),
+              let size = values.fileSize,
+              let modified = values.contentModificationDate else { return nil }
+
+        var identity = "\(url.standardizedFileURL.path)|\(size)|\(modified.timeIntervalSince1970)"
+        if let configuration = configuration {
+            identity += "|\(configuration.fingerprint)"
+        }
+        var hash: UInt64 = 0xcbf29ce484222325
+        for byte in identity.utf8 {
+            hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+        }
+        return String(hash, radix: 16)
+    }
+}
@@ -0,0 +1,84 @@
+import Foundation
+
+/**
+ * BoundedHeap
+ *
+ * Keeps the `capacity` greatest elements seen so far. The smallest kept
+ * element sits at the root of a min-heap, so a newcomer is compared against
+ * it once and inserted in O(log capacity). Heaps filled independently, e.g.
+ * by parallel workers, are combined with `merge`.
+ */
+struct BoundedHeap<Element> {
+    let capacity: Int
+
+    private let areInIncreasingOrder: (Element, Element) -> Bool
+    private var storage: [Element] = []
+
+    var count: Int {
+        return storage.count
+    }
+
+    /**
+     * - Parameters:
+     *   - capacity: Most elements kept
+     *   - areInIncreasingOrder: Ordering; the greatest elements are kept
+     */
+    init(capacity: Int, by areInIncreasingOrder: @escaping (Element, Element) -> Bool) {
+        self.capacity = max(0, capacity)
+        self.areInIncreasingOrder = areInIncreasingOrder
+        storage.reserveCapacity(self.capacity)
+    }
+
+    mutating func insert(_ element: Element) {
+        guard capacity > 0 else { return }
+
+        if storage.count < capacity {
+            storage.append(element)
+            siftUp(storage.count - 1)
+        } else if areInIncreasingOrder(storage[0], element) {
+            storage[0] = element
+            siftDown(0)
+        }
+    }
+
+    mutating func merge(_ other: BoundedHeap<Element>) {
+        for element in other.storage {
+            insert(element)
+        }
+    }
+
+    /// Kept elements, greatest first
+    func sortedDescending() -> [Element] {
+        return storage.sorted { areInIncreasingOrder($1, $0) }
+    }
+
+    // MARK: - Heap
+
+    private mutating func siftUp(_ index: Int) {
+        var child = index
+        while child > 0 {
+            let parent = (child - 1) / 2
+            guard areInIncreasingOrder(storage[child], storage[parent]) else { return }
+            storage.swapAt(child, parent)
+            child = parent
+        }
+    }
+
+    private mutating func siftDown(_ index: Int) {
+        var parent = index
+        while true {
+            let left = 2 * parent + 1
+            let right = left + 1
+            var smallest = parent
+            if left < storage.count && areInIncreasingOrder(storage[left], storage[smallest]) {
+                smallest = left
+            }
+            if right < storage.count && areInIncreasingOrder(storage[right], storage[smallest]) {
+                smallest = right
+            }
+            guard smallest != parent else { return }
+            storage.swapAt(parent, smallest)
+            parent = smallest
+        }
+    }
+}
@@ -24,6 +24,15 @@ class EventBus {
         /// Notification that loop points have changed (no associated data)
         case loopPointsChanged
         
+        /// Request to export an extended version of the current loop
+        case exportLoop
+        
+        /// Request to choose files for the play queue (no associated data)
+        case addToQueue
+        
+        /// Playback moved on to the next queued track
+        case trackChanged(URL)
+        
         /// Error occurred during audio processing
         case audioError(Error)
     }
@@ -76,6 +85,44 @@ class EventBus {
             .eraseToAnyPublisher()
     }
     
+    /// Publisher filtered for export loop events
+    var exportLoopPublisher: AnyPublisher<Void, Never> {
+        eventSubject
+            .filter { event in
+                if case .exportLoop = event {
+                    return true
+                }
+                return false
+            }
+            .map { _ in () }
+            .eraseToAnyPublisher()
+    }
+    
+    /// Publisher filtered for add to queue events
+    var addToQueuePublisher: AnyPublisher<Void, Never> {
+        eventSubject
+            .filter { event in
+                if case .addToQueue = event {
+                    return true
+                }
+                return false
+            }
+            .map { _ in () }
+            .eraseToAnyPublisher()
+    }
+    
+    /// Publisher filtered for track changed events with the new track's URL
+    var trackChangedPublisher: AnyPublisher<URL, Never> {
+        eventSubject
+            .compactMap { event in
+                if case .trackChanged(let url) = event {
+                    return url
+                }
+                return nil
+            }
+            .eraseToAnyPublisher()
+    }
+    
     /// Publisher filtered for audio error events
     var audioErrorPublisher: AnyPublisher<Error, Never> {
         eventSubject
@@ -112,6 +159,21 @@ class EventBus {
         publish(.loopPointsChanged)
     }
     
+    /// Publishes an export loop event
+    func publishExportLoop() {
+        publish(.exportLoop)
+    }
+    
+    /// Publishes an add to queue event
+    func publishAddToQueue() {
+        publish(.addToQueue)
+    }
+    
+    /// Publishes a track changed event
+    func publishTrackChanged(_ url: URL) {
+        publish(.trackChanged(url))
+    }
+    
     /// Publishes an audio error event
     func publishAudioError(_ error: Error) {
         publish(.audioError(error))
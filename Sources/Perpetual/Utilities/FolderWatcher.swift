@@ -0,0 +1,93 @@
+import CoreServices
+import Foundation
+
+/**
+ * FolderWatcher
+ *
+ * Reports file-system changes under a set of folders through FSEvents. The
+ * kernel does the watching, so an idle watcher costs no CPU; events within
+ * `latency` of each other are delivered as one batch of paths.
+ */
+final class FolderWatcher {
+    /// Called on `queue` with the paths that changed in one batch
+    typealias Handler = (Set<String>) -> Void
+
+    let paths: [String]
+    let latency: TimeInterval
+
+    private let queue: DispatchQueue
+    private let handler: Handler
+    private var stream: FSEventStreamRef?
+
+    /**
+     * - Parameters:
+     *   - paths: Folders to watch (recursively)
+     *   - latency: Seconds FSEvents waits to coalesce events into one batch
+     *   - queue: Queue the handler runs on
+     *   - handler: Receives each batch of changed paths
+     */
+    init(paths: [String], latency: TimeInterval = 0.5, queue: DispatchQueue, handler: @escaping Handler) {
+        self.paths = paths
+        self.latency = latency
+        self.queue = queue
+        self.handler = handler
+    }
+
+    deinit {
+        stop()
+    }
+
+    /**
+     * Starts delivering events that happen from now on.
+     *
+     * - Returns: false if the event stream couldn't be created
+     */
+    @discardableResult
+    func start() -> Bool {
+        guard stream == nil else { return true }
+
+        var context = FSEventStreamContext(version: 0,
+                                           info: Unmanaged.passUnretained(self).toOpaque(),
+                                           retain: nil, release: nil, copyDescription: nil)
+
+        let callback: FSEventStreamCallback = { _, info, count, eventPaths, _, _ in
+            guard let info = info else { return }
+            let watcher = Unmanaged<FolderWatcher>.fromOpaque(info).takeUnretainedValue()
+
+            // With kFSEventStreamCreateFlagUseCFTypes the paths arrive as a CFArray of CFStrings
+            let array = Unmanaged<CFArray>.fromOpaque(eventPaths).takeUnretainedValue() as NSArray
+            var changed = Set<String>()
+            for index in 0..<min(count, array.count) {
+                if let path = array[index] as? String {
+                    changed.insert(path)
+                }
+            }
+            if !changed.isEmpty {
+                watcher.handler(changed)
+            }
+        }
+
+        let flags = FSEventStreamCreateFlags(kFSEventStreamCreateFlagUseCFTypes | kFSEventStreamCreateFlagFileEvents)
+        guard let created = FSEventStreamCreate(kCFAllocatorDefault, callback, &context, paths as CFArray,
+                                                FSEventStreamEventId(kFSEventStreamEventIdSinceNow),
+                                                latency, flags) else { return false }
+
+        FSEventStreamSetDispatchQueue(created, queue)
+        guard FSEventStreamStart(created) else {
+            FSEventStreamInvalidate(created)
+            FSEventStreamRelease(created)
+            return false
+        }
+        stream = created
+        return true
+    }
+
+    /// Stops delivering events
+    func stop() {
+        guard let stream = stream else { return }
+        FSEventStreamStop(stream)
+        FSEventStreamInvalidate(stream)
+        FSEventStreamRelease(stream)
+        self.stream = nil
+    }
+}
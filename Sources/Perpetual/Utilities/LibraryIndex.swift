@@ -0,0 +1,584 @@
+import AVFoundation
+import Foundation
+import SQLite3
+
+/**
+ * LibraryIndex
+ *
+ * On-disk index of every track in the scanned library folders: identity
+ * (path, size, modification date and a content hash), format, and a summary
+ * of its analysis (loop points, loudness, transition quality). Backed by
+ * SQLite in WAL mode. Nothing is read up front, so opening the index costs
+ * the same for fifty tracks or fifty thousand, and the common queries are
+ * answered from indexes.
+ *
+ * Scans are incremental: a file whose size and modification date match its
+ * row is skipped without being opened, and a changed file keeps its
+ * analysis if its content hash still matches.
+ */
+final class LibraryIndex {
+    /// One indexed file
+    struct Track {
+        let path: String
+        let size: Int
+        let modified: TimeInterval
+        let contentHash: String
+        let duration: TimeInterval
+        let sampleRate: Double
+        let channelCount: Int
+
+        /// File extension, lowercased (e.g. "flac")
+        let format: String
+
+        /// Loop points in seconds, once analyzed
+        let loopStart: TimeInterval?
+        let loopEnd: TimeInterval?
+
+        /// Integrated loudness in LUFS and true peak in dBTP
+        let integratedLoudness: Float?
+        let truePeak: Float?
+
+        /// Quality of the chosen loop transition (0-10)
+        let transitionQuality: Float?
+
+        /// Loop candidates the analyzer considered
+        let candidateCount: Int?
+
+        /// When the track was last analyzed (nil = never)
+        let analyzedAt: Date?
+
+        var url: URL {
+            return URL(fileURLWithPath: path)
+        }
+
+        /// Length of the loop region, once analyzed
+        var loopDuration: TimeInterval? {
+            guard let start = loopStart, let end = loopEnd else { return nil }
+            return end - start
+        }
+    }
+
+    /// Saved searches over the library
+    enum Query {
+        case all
+        case unanalyzed
+        case lowTransitionQuality(below: Float)
+        case loopsShorter(than: TimeInterval)
+    }
+
+    /// What a scan changed
+    struct ScanSummary {
+        var added = 0
+        var updated = 0
+        var unchanged = 0
+        var removed = 0
+        var failed = 0
+    }
+
+    /// Errors specific to the index
+    enum IndexError: Error, LocalizedError {
+        case openFailed(String)
+        case statementFailed(String)
+
+        var errorDescription: String? {
+            switch self {
+            case .openFailed(let message):
+                return "Failed to open the library index: \(message)"
+            case .statementFailed(let message):
+                return "Library index query failed: \(message)"
+            }
+        }
+    }
+
+    /// File extensions picked up by a scan
+    static let audioExtensions: Set<String> = ["wav", "aif", "aiff", "aifc", "caf", "mp3", "m4a", "aac", "flac"]
+
+    /// Bytes hashed from each end of a file for its content hash
+    static let hashedBytes = 64 * 1024
+
+    /// The index in the user's application support folder (nil if it can't be opened)
+    static let shared: LibraryIndex? = {
+        do {
+            return try LibraryIndex()
+        } catch {
+            print("Library index unavailable: \(error.localizedDescription)")
+            return nil
+        }
+    }()
+
+    private let database: OpaquePointer
+    private let queue = DispatchQueue(label: "com.perpetual.library")
+
+    private static let columns = """
+        path, size, modified, content_hash, duration, sample_rate, channel_count, format,
+        loop_start, loop_end, integrated_loudness, true_peak, transition_quality, candidate_count, analyzed_at
+        """
+
+    // MARK: - Lifecycle
+
+    /**
+     * Opens (creating if needed) the index database.
+     *
+     * - Parameter url: Database file (defaults to Application Support/Perpetual/Library.sqlite)
+     * - Throws: IndexError if the database can't be opened or migrated
+     */
+    init(url: URL? = nil) throws {
+        let fileURL: URL
+        if let url = url {
+            fileURL = url
+        } else {
+            guard let support = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first else {
+                throw IndexError.openFailed("No application support directory")
+            }
+            fileURL = support.appendingPathComponent("Perpetual/Library.sqlite")
+        }
+        try? FileManager.default.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+
+        var handle: OpaquePointer?
+        guard sqlite3_open_v2(fileURL.path, &handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nil) == SQLITE_OK,
+              let opened = handle else {
+            let message = handle.map { String(cString: sqlite3_errmsg($0)) } ?? "unknown error"
+            sqlite3_close(handle)
+            throw IndexError.openFailed(message)
+        }
+        database = opened
+
+        do {
+            try migrate()
+        } catch {
+            sqlite3_close(opened)
+            throw error
+        }
+    }
+
+    deinit {
+        sqlite3_close(database)
+    }
+
+    /**
+     * Creates the schema. Indexes back each `Query`, so none of them scans
+     * the whole table.
+     */
+    private func migrate() throws {
+        try execute("""
+            PRAGMA journal_mode = WAL;
+            PRAGMA synchronous = NORMAL;
+            CREATE TABLE IF NOT EXISTS tracks (
+                path TEXT PRIMARY KEY NOT NULL,
+                size INTEGER NOT NULL,
+                modified REAL NOT NULL,
+                content_hash TEXT NOT NULL,
+                duration REAL NOT NULL,
+                sample_rate REAL NOT NULL,
+                channel_count INTEGER NOT NULL,
+                format TEXT NOT NULL,
+                loop_start REAL,
+                loop_end REAL,
+                integrated_loudness REAL,
+                true_peak REAL,
+                transition_quality REAL,
+                candidate_count INTEGER,
+                analyzed_at REAL
+            ) WITHOUT ROWID;
+            CREATE INDEX IF NOT EXISTS tracks_analyzed ON tracks(analyzed_at);
+            CREATE INDEX IF NOT EXISTS tracks_quality ON tracks(transition_quality);
+            CREATE INDEX IF NOT EXISTS tracks_loop_length ON tracks(loop_end - loop_start);
+            CREATE INDEX IF NOT EXISTS tracks_hash ON tracks(content_hash);
+            """)
+    }
+
+    // MARK: - Scanning
+
+    /**
+     * Brings the index up to date with everything under `directory`. Only
+     * new or changed files are opened; rows for files that disappeared are
+     * removed. All writes land in one transaction.
+     *
+     * - Parameters:
+     *   - directory: Folder to scan recursively
+     *   - progress: Called with the number of files examined so far
+     */
+    @discardableResult
+    func scan(_ directory: URL, progress: ((Int) -> Void)? = nil) throws -> ScanSummary {
+        let root = directory.standardizedFileURL.path
+        let known = try queue.sync { try fileStates(under: root) }
+
+        var summary = ScanSummary()
+        var changed: [Track] = []
+        var seen = Set<String>()
+        let keys: [URLResourceKey] = [.isRegularFileKey, .fileSizeKey, .contentModificationDateKey]
+
+        let enumerator = FileManager.default.enumerator(at: directory, includingPropertiesForKeys: keys,
+                                                        options: [.skipsHiddenFiles, .skipsPackageDescendants])
+        while let url = enumerator?.nextObject() as? URL {
+            guard LibraryIndex.audioExtensions.contains(url.pathExtension.lowercased()),
+                  let values = try? url.resourceValues(forKeys: Set(keys)),
+                  values.isRegularFile == true,
+                  let size = values.fileSize,
+                  let modified = values.contentModificationDate?.timeIntervalSince1970 else { continue }
+
+            let path = url.standardizedFileURL.path
+            seen.insert(path)
+            if seen.count % 1000 == 0 {
+                progress?(seen.count)
+            }
+
+            if let state = known[path], state.size == size, state.modified == modified {
+                summary.unchanged += 1
+                continue
+            }
+
+            guard let track = LibraryIndex.probe(url, path: path, size: size, modified: modified) else {
+                summary.failed += 1
+                continue
+            }
+            if known[path] == nil {
+                summary.added += 1
+            } else {
+                summary.updated += 1
+            }
+            changed.append(track)
+        }
+
+        let removed = known.keys.filter { !seen.contains($0) }
+        summary.removed = removed.count
+
+        try queue.sync {
+            try transaction {
+                try write(changed)
+                let delete = try Statement(database, "DELETE FROM tracks WHERE path = ?")
+                for path in removed {
+                    try delete.run([.text(path)])
+                }
+            }
+        }
+        progress?(seen.count)
+
+        return summary
+    }
+
+    /// Size and modification date of every indexed file under `root`
+    private func fileStates(under root: String) throws -> [String: (size: Int, modified: TimeInterval)] {
+        let statement = try Statement(database, "SELECT path, size, modified FROM tracks WHERE path >= ? AND path < ?")
+        try statement.bind(LibraryIndex.pathRange(under: root))
+
+        var states: [String: (size: Int, modified: TimeInterval)] = [:]
+        while try statement.step() {
+            states[statement.text(0) ?? ""] = (statement.integer(1) ?? 0, statement.real(2) ?? 0)
+        }
+        return states
+    }
+
+    /**
+     * Inserts or refreshes rows. Analysis columns are cleared only when the
+     * content hash changed, so touching a file doesn't lose its analysis.
+     */
+    private func write(_ tracks: [Track]) throws {
+        let clear = try Statement(database, """
+            UPDATE tracks SET loop_start = NULL, loop_end = NULL, integrated_loudness = NULL, true_peak = NULL,
+                transition_quality = NULL, candidate_count = NULL, analyzed_at = NULL
+            WHERE path = ? AND content_hash <> ?
+            """)
+        let upsert = try Statement(database, """
+            INSERT INTO tracks (path, size, modified, content_hash, duration, sample_rate, channel_count, format)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+            ON CONFLICT(path) DO UPDATE SET size = excluded.size, modified = excluded.modified,
+                content_hash = excluded.content_hash, duration = excluded.duration,
+                sample_rate = excluded.sample_rate, channel_count = excluded.channel_count, format = excluded.format
+            """)
+
+        for track in tracks {
+            try clear.run([.text(track.path), .text(track.contentHash)])
+            try upsert.run([.text(track.path), .integer(track.size), .real(track.modified),
+                            .text(track.contentHash), .real(track.duration), .real(track.sampleRate),
+                            .integer(track.channelCount), .text(track.format)])
+        }
+    }
+
+    /**
+     * Reads what the index needs from a file: its header (through
+     * AVAudioFile, which doesn't decode anything) and its content hash.
+     */
+    private static func probe(_ url: URL, path: String, size: Int, modified: TimeInterval) -> Track? {
+        guard let file = try? AVAudioFile(forReading: url),
+              let hash = contentHash(of: url, size: size) else { return nil }
+        let format = file.fileFormat
+
+        return Track(path: path, size: size, modified: modified, contentHash: hash,
+                     duration: format.sampleRate > 0 ? Double(file.length) / format.sampleRate : 0,
+                     sampleRate: format.sampleRate,
+                     channelCount: Int(format.channelCount),
+                     format: url.pathExtension.lowercased(),
+                     loopStart: nil, loopEnd: nil, integratedLoudness: nil, truePeak: nil,
+                     transitionQuality: nil, candidateCount: nil, analyzedAt: nil)
+    }
+
+    /**
+     * 64-bit FNV-1a over the file size and its first and last `hashedBytes`.
+     * Cheap enough for tens of thousands of files, and enough to tell a
+     * re-encoded or edited file from one that was only touched or moved.
+     */
+    static func contentHash(of url: URL, size: Int) -> String? {
+        guard let handle = try? FileHandle(forReadingFrom: url) else { return nil }
+        defer { try? handle.close() }
+
+        var hash: UInt64 = 0xcbf29ce484222325
+        func mix<Bytes: Sequence>(_ bytes: Bytes) where Bytes.Element == UInt8 {
+            for byte in bytes {
+                hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+            }
+        }
+
+        mix(String(size).utf8)
+        guard let head = try? handle.read(upToCount: hashedBytes) else { return nil }
+        mix(head)
+        if size > hashedBytes * 2 {
+            guard (try? handle.seek(toOffset: UInt64(size - hashedBytes))) != nil,
+                  let tail = try? handle.read(upToCount: hashedBytes) else { return nil }
+            mix(tail)
+        }
+        return String(hash, radix: 16)
+    }
+
+    // MARK: - Analysis
+
+    /**
+     * Stores analysis results for an indexed file. Files outside the library
+     * are ignored.
+     */
+    func recordAnalysis(of url: URL, loopStart: TimeInterval?, loopEnd: TimeInterval?,
+                        transitionQuality: Float?, candidateCount: Int,
+                        loudness: LoudnessAccumulator.Measurement?) {
+        let path = url.standardizedFileURL.path
+
+        queue.sync {
+            do {
+                let statement = try Statement(database, """
+                    UPDATE tracks SET loop_start = ?, loop_end = ?, transition_quality = ?, candidate_count = ?,
+                        integrated_loudness = ?, true_peak = ?, analyzed_at = ?
+                    WHERE path = ?
+                    """)
+                try statement.run([.real(loopStart), .real(loopEnd), .real(transitionQuality.map { Double($0) }),
+                                   .integer(candidateCount),
+                                   .real(loudness?.integratedLoudness.map { Double($0) }),
+                                   .real(loudness.map { Double($0.truePeak) }),
+                                   .real(Date().timeIntervalSince1970), .text(path)])
+            } catch {
+                print("Failed to record analysis of \(url.lastPathComponent): \(error.localizedDescription)")
+            }
+        }
+    }
+
+    // MARK: - Queries
+
+    /**
+     * Tracks matching `query`, in the order that suits it (worst transitions
+     * first, shortest loops first, otherwise by path).
+     *
+     * - Parameters:
+     *   - directory: If set, only tracks inside this folder
+     *   - limit: Most rows returned
+     */
+    func tracks(matching query: Query, under directory: URL? = nil, limit: Int? = nil) throws -> [Track] {
+        let (condition, order, values) = LibraryIndex.clause(for: query, under: directory)
+        var sql = "SELECT \(LibraryIndex.columns) FROM tracks\(condition) ORDER BY \(order)"
+        if let limit = limit {
+            sql += " LIMIT \(max(0, limit))"
+        }
+
+        return try queue.sync {
+            let statement = try Statement(database, sql)
+            try statement.bind(values)
+
+            var tracks: [Track] = []
+            while try statement.step() {
+                tracks.append(LibraryIndex.track(from: statement))
+            }
+            return tracks
+        }
+    }
+
+    /// Number of tracks matching `query`
+    func count(matching query: Query, under directory: URL? = nil) throws -> Int {
+        let (condition, _, values) = LibraryIndex.clause(for: query, under: directory)
+
+        return try queue.sync {
+            let statement = try Statement(database, "SELECT COUNT(*) FROM tracks\(condition)")
+            try statement.bind(values)
+            return try statement.step() ? (statement.integer(0) ?? 0) : 0
+        }
+    }
+
+    /// The indexed row for a file, if any
+    func track(at url: URL) throws -> Track? {
+        return try queue.sync {
+            let statement = try Statement(database, "SELECT \(LibraryIndex.columns) FROM tracks WHERE path = ?")
+            try statement.bind([.text(url.standardizedFileURL.path)])
+            return try statement.step() ? LibraryIndex.track(from: statement) : nil
+        }
+    }
+
+    /// WHERE clause, ORDER BY terms and parameters of a query
+    private static func clause(for query: Query, under directory: URL?) -> (String, String, [Statement.Value]) {
+        var conditions: [String] = []
+        var values: [Statement.Value] = []
+        let order: String
+
+        switch query {
+        case .all:
+            order = "path"
+        case .unanalyzed:
+            conditions.append("analyzed_at IS NULL")
+            order = "path"
+        case .lowTransitionQuality(let threshold):
+            conditions.append("transition_quality < ?")
+            values.append(.real(Double(threshold)))
+            order = "transition_quality"
+        case .loopsShorter(let seconds):
+            conditions.append("loop_end - loop_start < ?")
+            values.append(.real(seconds))
+            order = "loop_end - loop_start"
+        }
+
+        if let directory = directory {
+            conditions.append("path >= ? AND path < ?")
+            values += pathRange(under: directory.standardizedFileURL.path)
+        }
+
+        return (conditions.isEmpty ? "" : " WHERE " + conditions.joined(separator: " AND "), order, values)
+    }
+
+    /// Bounds of every path inside `directory`, for a range scan on the primary key
+    private static func pathRange(under directory: String) -> [Statement.Value] {
+        let prefix = directory.hasSuffix("/") ? directory : directory + "/"
+        // "0" sorts right after "/", so this excludes sibling folders with the same prefix
+        return [.text(prefix), .text(String(prefix.dropLast()) + "0")]
+    }
+
+    private static func track(from statement: Statement) -> Track {
+        return Track(path: statement.text(0) ?? "",
+                     size: statement.integer(1) ?? 0,
+                     modified: statement.real(2) ?? 0,
+                     contentHash: statement.text(3) ?? "",
+                     duration: statement.real(4) ?? 0,
+                     sampleRate: statement.real(5) ?? 0,
+                     channelCount: statement.integer(6) ?? 0,
+                     format: statement.text(7) ?? "",
+                     loopStart: statement.real(8),
+                     loopEnd: statement.real(9),
+                     integratedLoudness: statement.real(10).map { Float($0) },
+                     truePeak: statement.real(11).map { Float($0) },
+                     transitionQuality: statement.real(12).map { Float($0) },
+                     candidateCount: statement.integer(13),
+                     analyzedAt: statement.real(14).map { Date(timeIntervalSince1970: $0) })
+    }
+
+    // MARK: - SQLite
+
+    /// Runs one or more statements that return no rows
+    private func execute(_ sql: String) throws {
+        var message: UnsafeMutablePointer<CChar>?
+        guard sqlite3_exec(database, sql, nil, nil, &message) == SQLITE_OK else {
+            let text = message.map { String(cString: $0) } ?? "unknown error"
+            sqlite3_free(message)
+            throw IndexError.statementFailed(text)
+        }
+    }
+
+    /// Runs `body` in a transaction, rolling back if it throws
+    private func transaction(_ body: () throws -> Void) throws {
+        try execute("BEGIN IMMEDIATE")
+        do {
+            try body()
+            try execute("COMMIT")
+        } catch {
+            try? execute("ROLLBACK")
+            throw error
+        }
+    }
+
+    /// A prepared statement, finalized when released
+    private final class Statement {
+        enum Value {
+            case integer(Int)
+            case real(Double?)
+            case text(String)
+        }
+
+        private let database: OpaquePointer
+        private let handle: OpaquePointer
+
+        /// Tells SQLite to copy bound strings
+        private static let transient = unsafeBitCast(-1, to: sqlite3_destructor_type.self)
+
+        init(_ database: OpaquePointer, _ sql: String) throws {
+            var handle: OpaquePointer?
+            guard sqlite3_prepare_v2(database, sql, -1, &handle, nil) == SQLITE_OK, let prepared = handle else {
+                throw IndexError.statementFailed(String(cString: sqlite3_errmsg(database)))
+            }
+            self.database = database
+            self.handle = prepared
+        }
+
+        deinit {
+            sqlite3_finalize(handle)
+        }
+
+        /// Resets the statement and binds parameters in order
+        func bind(_ values: [Value]) throws {
+            sqlite3_reset(handle)
+            sqlite3_clear_bindings(handle)
+
+            for (index, value) in values.enumerated() {
+                let position = Int32(index + 1)
+                let result: Int32
+                switch value {
+                case .integer(let number):
+                    result = sqlite3_bind_int64(handle, position, Int64(number))
+                case .real(let number?):
+                    result = sqlite3_bind_double(handle, position, number)
+                case .real(nil):
+                    result = sqlite3_bind_null(handle, position)
+                case .text(let text):
+                    result = sqlite3_bind_text(handle, position, text, -1, Statement.transient)
+                }
+                guard result == SQLITE_OK else {
+                    throw IndexError.statementFailed(String(cString: sqlite3_errmsg(database)))
+                }
+            }
+        }
+
+        /// Binds `values` and steps until the statement is done
+        func run(_ values: [Value]) throws {
+            try bind(values)
+            while try step() {}
+        }
+
+        /// Advances to the next row; false when there are no more
+        func step() throws -> Bool {
+            switch sqlite3_step(handle) {
+            case SQLITE_ROW:
+                return true
+            case SQLITE_DONE:
+                return false
+            default:
+                throw IndexError.statementFailed(String(cString: sqlite3_errmsg(database)))
+            }
+        }
+
+        func integer(_ column: Int32) -> Int? {
+            guard sqlite3_column_type(handle, column) != SQLITE_NULL else { return nil }
+            return Int(sqlite3_column_int64(handle, column))
+        }
+
+        func real(_ column: Int32) -> Double? {
+            guard sqlite3_column_type(handle, column) != SQLITE_NULL else { return nil }
+            return sqlite3_column_double(handle, column)
+        }
+
+        func text(_ column: Int32) -> String? {
+            guard let text = sqlite3_column_text(handle, column) else { return nil }
+            return String(cString: text)
+        }
+    }
+}
@@ -0,0 +1,510 @@
+import AVFoundation
+import Foundation
+import PerpetualCore
+
+/**
+ * PerformanceBenchmarks
+ *
+ * A small in-app benchmark suite for the playback and analysis paths.
+ * Each benchmark runs against synthetic audio so results are comparable
+ * between machines and builds. Results are shown in the Debug tab.
+ */
+enum PerformanceBenchmarks {
+    /// A single benchmark measurement
+    struct Result: Identifiable {
+        let id = UUID()
+        let name: String
+        let value: Double
+        let unit: String
+        
+        /// Human-readable value with unit
+        var formattedValue: String {
+            if value >= 1_000_000 {
+                return String(format: "%.2fM %@", value / 1_000_000, unit)
+            } else if value >= 1_000 {
+                return String(format: "%.1fk %@", value / 1_000, unit)
+            }
+            return String(format: "%.3f %@", value, unit)
+        }
+    }
+    
+    /**
+     * Runs every benchmark in order. Blocking; call off the main thread.
+     */
+    static func runAll() -> [Result] {
+        var results: [Result] = []
+        results.append(contentsOf: renderThroughput())
+        results.append(contentsOf: seekLatency())
+        results.append(contentsOf: streamedRender())
+        results.append(contentsOf: exportThroughput())
+        results.append(contentsOf: analysisPipeline())
+        results.append(contentsOf: seamEvaluation())
+        results.append(contentsOf: analysisPresets())
+        results.append(contentsOf: beatGrid(tempo: 120))
+        results.append(contentsOf: beatGrid(tempo: 97))
+        return results
+    }
+    
+    // MARK: - Playback
+    
+    /**
+     * Measures how fast the LoopRenderer fills host-sized blocks while looping
+     * a short region, reported in frames per second and as a multiple of
+     * real time.
+     */
+    static func renderThroughput(renderSeconds: Double = 120, blockSize: Int = 512) -> [Result] {
+        let sampleRate = 44100.0
+        let pcm = makeTestPCM(duration: 10, sampleRate: sampleRate)
+        let renderer = LoopRenderer(pcm: pcm)
+        
+        // Loop one second in the middle so the seam is crossed constantly
+        renderer.setGraph(SegmentGraph.singleLoop(frameCount: pcm.frameCount,
+                                                  loopStartFrame: Int(4 * sampleRate),
+                                                  loopEndFrame: Int(5 * sampleRate),
+                                                  loopCount: 0))
+        renderer.setRunning(true)
+        
+        let totalFrames = Int(renderSeconds * sampleRate)
+        let output = makeOutput(channelCount: pcm.channelCount, frameCount: blockSize)
+        defer { releaseOutput(output, channelCount: pcm.channelCount) }
+        
+        let elapsed = measure {
+            var rendered = 0
+            while rendered < totalFrames {
+                renderer.render(frameCount: blockSize, into: output)
+                rendered += blockSize
+            }
+        }
+        
+        let framesPerSecond = Double(totalFrames) / max(elapsed, 1e-9)
+        return [
+            Result(name: "Render throughput (\(blockSize)-frame blocks)", value: framesPerSecond, unit: "frames/s"),
+            Result(name: "Render speed vs. real time", value: framesPerSecond / sampleRate, unit: "x")
+        ]
+    }
+    
+    /**
+     * Measures seeks inside a short and a long loop: the cost of a seek plus
+     * the block that picks it up, and the worst-case number of frames between
+     * sending a seek and hearing it. Both should be independent of loop length.
+     */
+    static func seekLatency(seeks: Int = 2000, blockSize: Int = 512) -> [Result] {
+        let sampleRate = 44100.0
+        let pcm = makeTestPCM(duration: 120, sampleRate: sampleRate)
+        let output = makeOutput(channelCount: pcm.channelCount, frameCount: blockSize)
+        defer { releaseOutput(output, channelCount: pcm.channelCount) }
+        
+        var results: [Result] = []
+        var worstBlocks = 0
+        
+        for loopSeconds in [2.0, 110.0] {
+            let loopStart = Int(5 * sampleRate)
+            let loopFrames = Int(loopSeconds * sampleRate)
+            let renderer = LoopRenderer(pcm: pcm)
+            renderer.setGraph(SegmentGraph.singleLoop(frameCount: pcm.frameCount,
+                                                      loopStartFrame: loopStart,
+                                                      loopEndFrame: loopStart + loopFrames,
+                                                      loopCount: 0))
+            renderer.setRunning(true)
+            renderer.render(frameCount: blockSize, into: output)
+            
+            let elapsed = measure {
+                for index in 0..<seeks {
+                    // Spread targets across the loop deterministically
+                    renderer.seek(toFrame: loopStart + (index * 7919 * blockSize) % loopFrames)
+                    
+                    var blocks = 0
+                    repeat {
+                        renderer.render(frameCount: blockSize, into: output)
+                        blocks += 1
+                    } while renderer.hasPendingSeek && blocks < 16
+                    worstBlocks = max(worstBlocks, blocks)
+                }
+            }
+            
+            results.append(Result(name: "Seek + first block (\(Int(loopSeconds)) s loop)",
+                                  value: elapsed / Double(seeks) * 1_000_000,
+                                  unit: "µs"))
+        }
+        
+        results.append(Result(name: "Worst-case seek latency (\(blockSize)-frame blocks)",
+                              value: Double(worstBlocks * blockSize) / sampleRate * 1000,
+                              unit: "ms"))
+        return results
+    }
+    
+    /**
+     * Renders a loop longer than the chunk ring through a StreamedPCM, the way
+     * very long files play, and reports throughput and the ring's fixed size.
+     * The decoder copies from memory so only the ring overhead is measured.
+     */
+    static func streamedRender(renderSeconds: Double = 60, blockSize: Int = 512) -> [Result] {
+        let sampleRate = 44100.0
+        let source = makeTestPCM(duration: 30, sampleRate: sampleRate)
+        let streamed = StreamedPCM(channelCount: source.channelCount,
+                                   frameCount: source.frameCount,
+                                   sampleRate: sampleRate,
+                                   decoder: { startFrame, frameCount, destination in
+                                       return source.read(from: startFrame, count: frameCount, into: destination, at: 0)
+                                   })
+        let renderer = LoopRenderer(pcm: streamed)
+        renderer.setGraph(SegmentGraph.singleLoop(frameCount: source.frameCount,
+                                                  loopStartFrame: Int(4 * sampleRate),
+                                                  loopEndFrame: Int(24 * sampleRate),
+                                                  loopCount: 0))
+        renderer.setRunning(true)
+        
+        let totalFrames = Int(renderSeconds * sampleRate)
+        let prefetchFrames = Int(3 * sampleRate)
+        let output = makeOutput(channelCount: source.channelCount, frameCount: blockSize)
+        defer { releaseOutput(output, channelCount: source.channelCount) }
+        
+        let elapsed = measure {
+            var rendered = 0
+            var nextPrefetch = 0
+            while rendered < totalFrames {
+                // Offline rendering outruns the decoder, so top up the ring every second of audio
+                if rendered >= nextPrefetch {
+                    streamed.prefetch(renderer.upcomingReads(frames: prefetchFrames))
+                    streamed.waitForPrefetch()
+                    nextPrefetch = rendered + Int(sampleRate)
+                }
+                renderer.render(frameCount: blockSize, into: output)
+                rendered += blockSize
+            }
+        }
+        
+        return [
+            Result(name: "Streamed render throughput", value: Double(totalFrames) / max(elapsed, 1e-9), unit: "frames/s"),
+            Result(name: "Streamed playback memory", value: Double(streamed.residentBytes) / 1_048_576, unit: "MB"),
+            Result(name: "Streamed underruns", value: Double(streamed.underruns), unit: "reads")
+        ]
+    }
+    
+    /**
+     * Runs a ten-minute loop export with a writer that discards its blocks,
+     * measuring render and fade cost without disk or encoder time.
+     */
+    static func exportThroughput(exportSeconds: Double = 600) -> [Result] {
+        let sampleRate = 44100.0
+        let pcm = makeTestPCM(duration: 10, sampleRate: sampleRate)
+        var settings = LoopExporter.Settings(loopStartFrame: Int(2 * sampleRate), loopEndFrame: Int(8 * sampleRate))
+        settings.targetDuration = exportSeconds
+        let exporter = LoopExporter(source: pcm, settings: settings)
+        
+        let output = makeOutput(channelCount: pcm.channelCount, frameCount: settings.blockSize)
+        defer { releaseOutput(output, channelCount: pcm.channelCount) }
+        
+        var frames = 0
+        let elapsed = measure {
+            frames = (try? exporter.run(into: output, write: { _ in })) ?? 0
+        }
+        
+        return [
+            Result(name: "Export speed vs. real time", value: Double(frames) / sampleRate / max(elapsed, 1e-9), unit: "x")
+        ]
+    }
+    
+    // MARK: - Analysis
+    
+    /**
+     * Streams five minutes of audio through the analysis pipeline twice:
+     * once with no consumers (decode only) and once feeding the waveform
+     * pyramid, feature table, loudness and repeat hasher. The decoder copies
+     * from memory, so the ratio shows what analysis adds on top of decoding.
+     */
+    static func analysisPipeline(duration: Double = 300) -> [Result] {
+        let sampleRate = 44100.0
+        let source = makeTestPCM(duration: duration, sampleRate: sampleRate)
+        
+        func makePipeline() -> AnalysisPipeline {
+            return AnalysisPipeline(channelCount: source.channelCount,
+                                    frameCount: source.frameCount,
+                                    sampleRate: sampleRate,
+                                    decoder: { startFrame, frameCount, destination in
+                                        return source.read(from: startFrame, count: frameCount, into: destination, at: 0)
+                                    })
+        }
+        
+        let decodeOnly = makePipeline()
+        let decodeElapsed = measure {
+            try? decodeOnly.run()
+        }
+        
+        let full = makePipeline()
+        full.add(WaveformPyramid())
+        full.add(FeatureTableBuilder())
+        full.add(LoudnessAccumulator())
+        full.add(ExactRepeatHasher())
+        let fullElapsed = measure {
+            try? full.run()
+        }
+        
+        return [
+            Result(name: "Analysis pipeline speed vs. real time", value: duration / max(fullElapsed, 1e-9), unit: "x"),
+            Result(name: "Analysis time vs. decode only", value: fullElapsed / max(decodeElapsed, 1e-9), unit: "x")
+        ]
+    }
+    
+    /**
+     * Scores loop seams at scattered points of a minute of chords, the
+     * way the candidate search does: one at a time, then as a batch on a
+     * fresh engine. Every seam has its own start and end, so nothing is
+     * served from the boundary cache. After a warm-up pass has sized the
+     * scratch arenas they should allocate nothing more, so the last figure
+     * is expected to read zero.
+     */
+    static func seamEvaluation(evaluations: Int = 400, duration: Double = 60) -> [Result] {
+        let sampleRate = 44100.0
+        let frameCount = Int(duration * sampleRate)
+        let samples = (0..<frameCount).map { frame -> Float in
+            let time = Double(frame) / sampleRate
+            let root = [220.0, 261.63, 196.0, 174.61][Int(time / 2) % 4]
+            return Float(sin(2 * .pi * root * time) * 0.3 + sin(2 * .pi * root * 1.5 * time) * 0.2)
+        }
+        
+        return samples.withUnsafeBufferPointer { buffer -> [Result] in
+            let second = Int(sampleRate)
+            
+            // Seams at least a second long, spread over the whole buffer
+            func seam(_ index: Int) -> SeamMetrics.Seam {
+                let start = (index * 7_919 * 97) % (frameCount / 2)
+                let end = start + second + (index * 104_729) % (frameCount - start - second - 1)
+                return SeamMetrics.Seam(startFrame: start, endFrame: end)
+            }
+            
+            let engine = SeamMetrics(samples: buffer.baseAddress!, frameCount: frameCount, sampleRate: sampleRate)
+            for index in evaluations..<(evaluations + 16) {
+                _ = engine.score(seam(index))
+            }
+            let warmAllocations = engine.scratchAllocationCount
+            
+            let elapsed = measure {
+                for index in 0..<evaluations {
+                    _ = engine.score(seam(index))
+                }
+            }
+            let steadyAllocations = engine.scratchAllocationCount - warmAllocations
+            
+            // The batch measures its boundaries in parallel; wait for it here
+            let batchEngine = SeamMetrics(samples: buffer.baseAddress!, frameCount: frameCount, sampleRate: sampleRate)
+            let seams = (0..<evaluations).map(seam)
+            let batchElapsed = measure {
+                let done = DispatchSemaphore(value: 0)
+                Task {
+                    _ = await batchEngine.score(seams)
+                    done.signal()
+                }
+                done.wait()
+            }
+            
+            return [
+                Result(name: "Seam evaluations per second", value: Double(evaluations) / max(elapsed, 1e-9), unit: "seams/s"),
+                Result(name: "Seam evaluations per second (batched)",
+                       value: Double(evaluations) / max(batchElapsed, 1e-9), unit: "seams/s"),
+                Result(name: "Scratch allocations per seam (warm)",
+                       value: Double(steadyAllocations) / Double(evaluations), unit: "allocs")
+            ]
+        }
+    }
+    
+    /**
+     * Runs the full structure analysis with each preset on a synthetic track
+     * with a known loop (an intro, then one phrase repeated with a little
+     * noise so the repeats aren't sample-identical). Reports each preset's
+     * speed and how far its loop length lands from a whole number of
+     * phrases.
+     */
+    static func analysisPresets(loopDuration: Double = 12) -> [Result] {
+        guard let url = makeLoopingTrackFile(loopDuration: loopDuration) else { return [] }
+        defer { try? FileManager.default.removeItem(at: url) }
+        let duration = (try? AVAudioFile(forReading: url)).map { Double($0.length) / $0.processingFormat.sampleRate } ?? 0
+        
+        /// Filled in by the analysis task
+        final class Outcome {
+            var loop: (start: TimeInterval, end: TimeInterval)?
+        }
+        
+        var results: [Result] = []
+        for configuration in AnalysisConfiguration.presets {
+            let analyzer = MusicStructureAnalyzer(configuration: configuration)
+            let outcome = Outcome()
+            
+            // The analyzer is async and publishes on the main queue; wait for it here
+            let elapsed = measure {
+                let done = DispatchSemaphore(value: 0)
+                Task {
+                    if (try? await analyzer.analyzeAudioFile(url)) != nil {
+                        outcome.loop = await MainActor.run { (analyzer.suggestedLoopStart, analyzer.suggestedLoopEnd) }
+                    }
+                    done.signal()
+                }
+                done.wait()
+            }
+            
+            results.append(Result(name: "Analysis speed vs. real time (\(configuration.name))",
+                                  value: duration / max(elapsed, 1e-9), unit: "x"))
+            if let loop = outcome.loop, loop.end > loop.start {
+                let phrases = max(1, ((loop.end - loop.start) / loopDuration).rounded())
+                let error = abs(loop.end - loop.start - phrases * loopDuration)
+                results.append(Result(name: "Loop length error (\(configuration.name))", value: error * 1000, unit: "ms"))
+            }
+        }
+        return results
+    }
+    
+    /**
+     * Tracks the beats of a click track at `tempo`, accented every fourth
+     * click, and snaps each click to the nearest beat or downbeat the way a
+     * dragged loop handle does. Reports the worst distance from a click to
+     * its target over the whole file, so a grid that drifts shows up as an
+     * error that grows with the track, and the clicks that found no target.
+     */
+    static func beatGrid(tempo: Double, duration: Double = 120, sampleRate: Double = 44100) -> [Result] {
+        let frameCount = Int(duration * sampleRate)
+        let period = 60 / tempo
+        let clickFrames = (0..<Int((duration - 0.5) / period)).map { click in
+            Int(((0.25 + Double(click) * period) * sampleRate).rounded())
+        }
+        
+        // Short decaying bursts over quiet noise; downbeats are louder and brighter
+        var samples = [Float](repeating: 0, count: frameCount)
+        var noise: UInt32 = 0x2545F491
+        for frame in 0..<frameCount {
+            noise = noise &* 1664525 &+ 1013904223
+            samples[frame] = Float((Double(noise) / Double(UInt32.max) - 0.5) * 0.01)
+        }
+        for (index, start) in clickFrames.enumerated() {
+            let accented = index % 4 == 0
+            let frequency = accented ? 2500.0 : 1500.0
+            for offset in 0..<min(Int(0.02 * sampleRate), frameCount - start) {
+                let time = Double(offset) / sampleRate
+                let envelope = (accented ? 0.8 : 0.2) * exp(-time / 0.003)
+                samples[start + offset] += Float(envelope * sin(2 * Double.pi * frequency * time))
+            }
+        }
+        
+        let label = "\(Int(tempo)) BPM"
+        let grid = samples.withUnsafeBufferPointer {
+            BeatTracker.track(samples: $0.baseAddress!, frameCount: frameCount, sampleRate: sampleRate)
+        }
+        guard let grid = grid else {
+            return [Result(name: "Clicks without a beat (\(label))", value: Double(clickFrames.count), unit: "clicks")]
+        }
+        
+        var index = SnapIndex()
+        index.setBeats(grid.beats, downbeats: grid.downbeats)
+        
+        var worstError: TimeInterval = 0
+        var unsnapped = 0
+        var missedDownbeats = 0
+        for (click, frame) in clickFrames.enumerated() {
+            let time = Double(frame) / sampleRate
+            guard let target = index.nearest(to: time, tolerance: period / 4) else {
+                unsnapped += 1
+                continue
+            }
+            worstError = max(worstError, abs(target.time - time))
+            if click % 4 == 0 && target.kind != .downbeat {
+                missedDownbeats += 1
+            }
+        }
+        
+        return [
+            Result(name: "Tempo error (\(label))", value: abs(60 / grid.period - tempo), unit: "BPM"),
+            Result(name: "Beat snap error, worst (\(label))", value: worstError * 1000, unit: "ms"),
+            Result(name: "Clicks without a beat (\(label))", value: Double(unsnapped), unit: "clicks"),
+            Result(name: "Downbeats missed (\(label))", value: Double(missedDownbeats), unit: "clicks")
+        ]
+    }
+    
+    // MARK: - Helpers
+    
+    /**
+     * Creates stereo test audio: a 440 Hz tone on the left, 660 Hz on the right.
+     */
+    static func makeTestPCM(duration: Double, sampleRate: Double = 44100) -> ResidentPCM {
+        let frameCount = Int(duration * sampleRate)
+        let left = (0..<frameCount).map { Float(sin(2 * Double.pi * 440 * Double($0) / sampleRate)) * 0.5 }
+        let right = (0..<frameCount).map { Float(sin(2 * Double.pi * 660 * Double($0) / sampleRate)) * 0.5 }
+        return ResidentPCM(samples: [left, right], sampleRate: sampleRate)
+    }
+    
+    /**
+     * Writes a mono test track with a known loop to a temporary file: an
+     * intro of low drones, then a phrase of plucked notes repeated, with
+     * quiet noise throughout.
+     */
+    static func makeLoopingTrackFile(introDuration: Double = 6, loopDuration: Double = 12, repeats: Int = 3,
+                                     sampleRate: Double = 44100) -> URL? {
+        let frameCount = Int((introDuration + loopDuration * Double(repeats)) * sampleRate)
+        guard let format = AVAudioFormat(standardFormatWithSampleRate: sampleRate, channels: 1),
+              let buffer = AVAudioPCMBuffer(pcmFormat: format, frameCapacity: AVAudioFrameCount(frameCount)),
+              let samples = buffer.floatChannelData?[0] else { return nil }
+        
+        let scale: [Double] = [220, 247, 262, 294, 330, 349, 392, 440]
+        let noteDuration = 0.375
+        var noise: UInt32 = 0x12345678
+        
+        for frame in 0..<frameCount {
+            let time = Double(frame) / sampleRate
+            var value: Double
+            if time < introDuration {
+                let frequency = 55 * Double(1 + Int(time / 1.5) % 3)
+                value = 0.3 * sin(2 * Double.pi * frequency * time)
+            } else {
+                let position = (time - introDuration).truncatingRemainder(dividingBy: loopDuration)
+                let note = Int(position / noteDuration)
+                let frequency = scale[(note * 5 + note / 4) % scale.count]
+                let phase = position - Double(note) * noteDuration
+                let envelope = exp(-4 * phase)
+                value = envelope * (0.4 * sin(2 * Double.pi * frequency * phase) +
+                                    0.15 * sin(4 * Double.pi * frequency * phase))
+            }
+            
+            noise = noise &* 1664525 &+ 1013904223
+            value += (Double(noise) / Double(UInt32.max) - 0.5) * 0.01
+            samples[frame] = Float(value)
+        }
+        buffer.frameLength = AVAudioFrameCount(frameCount)
+        
+        let url = FileManager.default.temporaryDirectory
+            .appendingPathComponent("perpetual-benchmark-\(UUID().uuidString)")
+            .appendingPathExtension("caf")
+        do {
+            let file = try AVAudioFile(forWriting: url, settings: format.settings,
+                                       commonFormat: .pcmFormatFloat32, interleaved: false)
+            try file.write(from: buffer)
+        } catch {
+            print("Failed to write benchmark track: \(error.localizedDescription)")
+            return nil
+        }
+        return url
+    }
+    
+    /// Allocates a channel pointer table with `frameCount` frames per channel
+    static func makeOutput(channelCount: Int, frameCount: Int) -> UnsafeMutablePointer<UnsafeMutablePointer<Float>> {
+        let table = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: max(1, channelCount))
+        for channel in 0..<channelCount {
+            let samples = UnsafeMutablePointer<Float>.allocate(capacity: frameCount)
+            samples.initialize(repeating: 0, count: frameCount)
+            (table + channel).initialize(to: samples)
+        }
+        return table
+    }
+    
+    /// Frees a table created by `makeOutput`
+    static func releaseOutput(_ table: UnsafeMutablePointer<UnsafeMutablePointer<Float>>, channelCount: Int) {
+        for channel in 0..<channelCount {
+            table[channel].deallocate()
+        }
+        table.deallocate()
+    }
+    
+    /// Wall-clock seconds taken by `block`
+    static func measure(_ block: () -> Void) -> TimeInterval {
+        let start = DispatchTime.now().uptimeNanoseconds
+        block()
+        return Double(DispatchTime.now().uptimeNanoseconds - start) / 1_000_000_000
+    }
+}
@@ -0,0 +1,749 @@
+import Foundation
+import Atomics
+
+/**
+ * PCMSource
+ *
+ * De-interleaved float audio that the renderer can read from its render
+ * thread. Conforming types must copy without locking or allocating.
+ */
+public protocol PCMSource: AnyObject {
+    var channelCount: Int { get }
+    var frameCount: Int { get }
+    var sampleRate: Double { get }
+
+    /**
+     * Copies `count` frames starting at `frame` into each destination channel
+     * at `offset`, scaled by `gain`. Frames that are out of range or not
+     * available yet are written as silence.
+     *
+     * - Returns: Number of frames that carried real audio
+     */
+    @discardableResult
+    func read(from frame: Int, count: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+              at offset: Int, gain: Float) -> Int
+}
+
+extension PCMSource {
+    /// Duration in seconds
+    public var duration: TimeInterval {
+        return sampleRate > 0 ? Double(frameCount) / sampleRate : 0
+    }
+
+    /// Copies frames at unity gain
+    @discardableResult
+    public func read(from frame: Int, count: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+                     at offset: Int) -> Int {
+        return read(from: frame, count: count, into: destination, at: offset, gain: 1)
+    }
+}
+
+/**
+ * Copies `count` samples, applying `gain` in the same pass. Unity gain is a
+ * plain copy; anything else costs one multiply per sample.
+ */
+@inline(__always)
+func copySamples(_ source: UnsafePointer<Float>, to target: UnsafeMutablePointer<Float>, count: Int, gain: Float) {
+    if gain == 1 {
+        target.update(from: source, count: count)
+    } else {
+        for index in 0..<count {
+            target[index] = source[index] * gain
+        }
+    }
+}
+
+/**
+ * ResidentPCM
+ *
+ * De-interleaved float samples held in memory for the lifetime of a track.
+ * Either borrows the channel memory of another object (e.g. an
+ * AVAudioPCMBuffer, kept alive via `owner`) or owns a private copy.
+ */
+public final class ResidentPCM: PCMSource {
+    public let channelCount: Int
+    public let frameCount: Int
+    public let sampleRate: Double
+
+    /// Channel pointer table, one pointer per channel
+    public let channels: UnsafeMutablePointer<UnsafeMutablePointer<Float>>
+
+    /// Object that owns borrowed sample memory
+    private let owner: AnyObject?
+
+    /// Whether `channels` point at memory allocated by this instance
+    private let ownsSamples: Bool
+
+    /**
+     * Wraps existing channel memory without copying.
+     *
+     * - Parameters:
+     *   - channels: Channel pointers (the table itself is copied, not the samples)
+     *   - owner: Object keeping the sample memory alive
+     */
+    public init(channels: UnsafePointer<UnsafeMutablePointer<Float>>, channelCount: Int, frameCount: Int,
+                sampleRate: Double, owner: AnyObject?) {
+        self.channelCount = channelCount
+        self.frameCount = frameCount
+        self.sampleRate = sampleRate
+        self.owner = owner
+        self.ownsSamples = false
+        self.channels = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: max(1, channelCount))
+        self.channels.initialize(from: channels, count: channelCount)
+    }
+
+    /**
+     * Copies per-channel sample arrays into owned memory.
+     */
+    public init(samples: [[Float]], sampleRate: Double) {
+        self.channelCount = samples.count
+        self.frameCount = samples.map { $0.count }.min() ?? 0
+        self.sampleRate = sampleRate
+        self.owner = nil
+        self.ownsSamples = true
+        self.channels = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: max(1, samples.count))
+
+        for (index, channel) in samples.enumerated() {
+            let memory = UnsafeMutablePointer<Float>.allocate(capacity: max(1, frameCount))
+            channel.withUnsafeBufferPointer { source in
+                memory.initialize(from: source.baseAddress!, count: frameCount)
+            }
+            (channels + index).initialize(to: memory)
+        }
+    }
+
+    deinit {
+        if ownsSamples {
+            for index in 0..<channelCount {
+                channels[index].deallocate()
+            }
+        }
+        channels.deallocate()
+    }
+
+    @discardableResult
+    public func read(from frame: Int, count: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+                     at offset: Int, gain: Float) -> Int {
+        let start = max(0, min(frame, frameCount))
+        let end = max(start, min(frame + count, frameCount))
+        let lead = start - frame
+        let available = end - start
+
+        for channel in 0..<channelCount {
+            let target = destination[channel] + offset
+            if lead > 0 {
+                target.update(repeating: 0, count: min(lead, count))
+            }
+            if available > 0 {
+                copySamples(channels[channel] + start, to: target + lead, count: available, gain: gain)
+            }
+            let tail = count - max(0, lead) - available
+            if tail > 0 {
+                (target + count - tail).update(repeating: 0, count: tail)
+            }
+        }
+
+        return available
+    }
+}
+
+/**
+ * LoopRenderer
+ *
+ * The pull-model playback core. Owns the PCM source (resident or streamed)
+ * and the segment graph state machine, and fills output buffers on demand. The render path takes
+ * no locks and performs no allocations: the main thread talks to it through
+ * a lock-free command queue, and it reports its position through atomics.
+ *
+ * It has no dependency on AVFoundation, so the same code drives an
+ * `AVAudioSourceNode` on macOS and renders offline anywhere else.
+ */
+public final class LoopRenderer {
+    /// Holder so graphs can cross threads as a single pointer. Once sent, the
+    /// box belongs to the render thread, which edits its graph in place.
+    final class GraphBox {
+        var graph: SegmentGraph
+
+        init(graph: SegmentGraph) {
+            self.graph = graph
+            self.graph.detachStorage()
+        }
+    }
+
+    /// When a loop-point change takes effect
+    public enum LoopPointTiming {
+        /// At the next loop wrap or region boundary, to the sample
+        case nextSeam
+
+        /// Right away; if the read position falls outside the new loop it
+        /// jumps to the loop start under a short crossfade
+        case immediate
+    }
+
+    /// Length of the crossfade used when the read position jumps mid-stream
+    public static let crossfadeFrames = 256
+
+    /// Messages from the main thread to the render thread
+    enum Command {
+        /// Replace the graph; start in `region`, or at `frame` in whichever region contains it
+        case setGraph(Unmanaged<GraphBox>, region: Int?, frame: Int?, generation: Int)
+
+        /// Jump to a region at the next region boundary
+        case transition(to: Int)
+
+        /// Move the bounds of the graph's loop region
+        case setLoopPoints(start: Int, end: Int, timing: LoopPointTiming)
+
+        /// Move the read position to an absolute frame, crossfading from the old one
+        case seek(frame: Int)
+
+        /// Start or pause pulling audio
+        case setRunning(Bool)
+
+        /// Scale everything read from the source (linear gain)
+        case setGain(Float)
+    }
+
+    /// A snapshot of render-side state
+    public struct Position {
+        public var frame: Int
+        public var region: Int
+        public var iteration: Int
+        public var isFinished: Bool
+
+        /// Which `setGraph` call this position belongs to
+        public var generation: Int
+    }
+
+    /// The audio being played
+    public let pcm: PCMSource
+
+    /// Main-thread copy of the graph most recently sent to the renderer
+    public private(set) var graph: SegmentGraph?
+
+    /// Incremented by every `setGraph`; positions from older graphs are stale
+    public private(set) var generation = 0
+
+    /// Where the main thread last asked playback to continue, until the render thread catches up
+    private var requestedRegion: Int?
+    private var requestedFrame: Int?
+
+    /// Transition queued by the main thread that playback hasn't reached yet
+    private var queuedTransition: Int?
+
+    // MARK: - Thread Hand-off
+
+    /// Main → render commands
+    private let commands = SPSCQueue<Command>(capacity: 64)
+
+    /// Render → main graphs that were replaced and must be released off the render thread
+    private let retiredGraphs = SPSCQueue<Unmanaged<GraphBox>>(capacity: 64)
+
+    // Published render state (written by the render thread only)
+    private let publishedFrame = UnsafeAtomic<Int>.create(0)
+    private let publishedRegion = UnsafeAtomic<Int>.create(0)
+    private let publishedIteration = UnsafeAtomic<Int>.create(0)
+    private let publishedFinished = UnsafeAtomic<Bool>.create(false)
+    private let publishedGeneration = UnsafeAtomic<Int>.create(0)
+
+    /// Total frames taken from the graph since creation
+    private let renderedFrames = UnsafeAtomic<Int>.create(0)
+
+    /// Uptime of the first frame taken after `markStart()`, and whether one is still awaited
+    private let firstFrameUptime = UnsafeAtomic<UInt64>.create(0)
+    private let awaitingFirstFrame = UnsafeAtomic<Bool>.create(false)
+
+    /// Seeks sent by the main thread, and seeks the render thread has applied
+    private var sentSeeks = 0
+    private let appliedSeeks = UnsafeAtomic<Int>.create(0)
+
+    // MARK: - Render-Thread State
+
+    private var current: Unmanaged<GraphBox>?
+    private var currentGeneration = 0
+    private var cursor: SegmentGraphCursor
+    private var isRunning = false
+
+    /// Linear gain applied while samples are copied out of the source
+    private var gain: Float = 1
+
+    /// Loop points waiting for the next seam (latest wins)
+    private var pendingLoopStart = 0
+    private var pendingLoopEnd = 0
+    private var hasPendingLoopPoints = false
+
+    /// Abandoned read position faded out under the new one after a jump
+    private var fadeSourceFrame = 0
+    private var fadeRemaining = 0
+
+    /// Preallocated channels the abandoned stream is read into while crossfading
+    private let fadeScratch: UnsafeMutablePointer<UnsafeMutablePointer<Float>>
+
+    /// Preallocated destination pointer table for host adapters
+    public let outputChannels: UnsafeMutablePointer<UnsafeMutablePointer<Float>>
+
+    /// Copy of everything rendered, for meters (nil unless requested at init)
+    public let meterRing: SPSCSampleRing?
+
+    // MARK: - Lifecycle
+
+    /**
+     * - Parameters:
+     *   - pcm: Audio to play
+     *   - meterCapacity: Frames of rendered output to keep for a meter; 0 disables the tap
+     */
+    public init(pcm: PCMSource, meterCapacity: Int = 0) {
+        self.pcm = pcm
+        self.cursor = SegmentGraphCursor(graph: SegmentGraph())
+        self.meterRing = meterCapacity > 0 ? SPSCSampleRing(channelCount: pcm.channelCount, capacity: meterCapacity) : nil
+
+        let channelCount = max(1, pcm.channelCount)
+        self.fadeScratch = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: channelCount)
+        for channel in 0..<channelCount {
+            let samples = UnsafeMutablePointer<Float>.allocate(capacity: LoopRenderer.crossfadeFrames)
+            samples.initialize(repeating: 0, count: LoopRenderer.crossfadeFrames)
+            (fadeScratch + channel).initialize(to: samples)
+        }
+
+        // Host adapters overwrite these before every render; start them somewhere valid
+        self.outputChannels = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: channelCount)
+        self.outputChannels.initialize(from: fadeScratch, count: channelCount)
+    }
+
+    deinit {
+        // Release graphs still in flight in either direction
+        while let command = commands.pop() {
+            if case .setGraph(let box, _, _, _) = command {
+                box.release()
+            }
+        }
+        drainRetiredGraphs()
+        current?.release()
+
+        outputChannels.deallocate()
+        for channel in 0..<max(1, pcm.channelCount) {
+            fadeScratch[channel].deallocate()
+        }
+        fadeScratch.deallocate()
+        publishedFrame.destroy()
+        publishedRegion.destroy()
+        publishedIteration.destroy()
+        publishedFinished.destroy()
+        publishedGeneration.destroy()
+        renderedFrames.destroy()
+        firstFrameUptime.destroy()
+        awaitingFirstFrame.destroy()
+        appliedSeeks.destroy()
+    }
+
+    // MARK: - Control (main thread)
+
+    /**
+     * Sends a new graph to the render thread.
+     *
+     * - Parameters:
+     *   - graph: Graph to play
+     *   - region: Region to start in (defaults to the graph entry)
+     *   - frame: If set, continue at this absolute frame instead, so playback
+     *            keeps its place when the graph is edited
+     */
+    public func setGraph(_ graph: SegmentGraph, region: Int? = nil, frame: Int? = nil) {
+        drainRetiredGraphs()
+        self.graph = graph
+        generation += 1
+        requestedRegion = region
+        requestedFrame = frame
+        queuedTransition = nil
+
+        let box = Unmanaged.passRetained(GraphBox(graph: graph))
+        if !send(.setGraph(box, region: region, frame: frame, generation: generation)) {
+            box.release()
+        }
+    }
+
+    /// Queues a jump to `region` at the next region boundary
+    public func queueTransition(to region: Int) {
+        if send(.transition(to: region)) {
+            queuedTransition = region
+        }
+    }
+
+    /**
+     * Moves the loop region of the current graph without replacing the graph.
+     * Cheap enough to call on every drag event: nothing is rebuilt or copied.
+     *
+     * - Parameters:
+     *   - startFrame: New loop start
+     *   - endFrame: New loop end (exclusive)
+     *   - timing: Whether to wait for the next seam or apply right away
+     */
+    public func setLoopPoints(startFrame: Int, endFrame: Int, timing: LoopPointTiming = .nextSeam) {
+        let start = max(0, min(startFrame, pcm.frameCount))
+        let end = max(start, min(endFrame, pcm.frameCount))
+        graph?.setLoopBounds(startFrame: start, endFrame: end)
+        send(.setLoopPoints(start: start, end: end, timing: timing))
+    }
+
+    /**
+     * Moves playback to an absolute frame. The render thread picks the jump
+     * up at the start of its next block, so latency is at most one hardware
+     * buffer regardless of loop length, and nothing is copied or rescheduled.
+     */
+    public func seek(toFrame frame: Int) {
+        if send(.seek(frame: frame)) {
+            sentSeeks += 1
+            requestedRegion = nil
+            requestedFrame = frame
+        }
+    }
+
+    /// Whether a seek has been sent that the render thread hasn't applied yet
+    public var hasPendingSeek: Bool {
+        return appliedSeeks.load(ordering: .acquiring) != sentSeeks
+    }
+
+    /// Starts or pauses rendering; while paused the renderer outputs silence
+    public func setRunning(_ running: Bool) {
+        send(.setRunning(running))
+    }
+
+    /**
+     * Sets the playback gain, e.g. for loudness normalization. It is applied
+     * while samples are copied out of the source, so it adds one multiply
+     * per sample and no extra pass. Takes effect at the next block.
+     */
+    public func setGain(_ gain: Float) {
+        send(.setGain(gain))
+    }
+
+    /// Latest render-side position
+    public var position: Position {
+        return Position(frame: publishedFrame.load(ordering: .relaxed),
+                        region: publishedRegion.load(ordering: .relaxed),
+                        iteration: publishedIteration.load(ordering: .relaxed),
+                        isFinished: publishedFinished.load(ordering: .relaxed),
+                        generation: publishedGeneration.load(ordering: .acquiring))
+    }
+
+    /// Whether the render thread has picked up the most recent graph
+    public var isCaughtUp: Bool {
+        return publishedGeneration.load(ordering: .acquiring) == generation
+    }
+
+    /// Total frames taken from the graph since the renderer was created
+    public var totalRenderedFrames: Int {
+        return renderedFrames.load(ordering: .relaxed)
+    }
+
+    /**
+     * Asks the render thread to timestamp the next frame it takes from the
+     * graph. Call before `setRunning(true)` to measure start latency.
+     */
+    public func markStart() {
+        awaitingFirstFrame.store(true, ordering: .releasing)
+    }
+
+    /// Uptime in nanoseconds of the first frame rendered after `markStart()`, once there is one
+    public var firstFrameTime: UInt64? {
+        guard !awaitingFirstFrame.load(ordering: .acquiring) else { return nil }
+        let uptime = firstFrameUptime.load(ordering: .relaxed)
+        return uptime > 0 ? uptime : nil
+    }
+
+    /**
+     * Predicts the source ranges the render thread will read over the next
+     * `frames` frames, following loop wraps and region changes, so a
+     * streaming source can decode them ahead of time. Main thread only.
+     */
+    public func upcomingReads(frames: Int) -> [Range<Int>] {
+        guard let graph = graph else { return [] }
+
+        var preview: SegmentGraphCursor
+        if isCaughtUp && !hasPendingSeek {
+            let position = self.position
+            guard !position.isFinished else { return [] }
+            preview = SegmentGraphCursor(graph: graph, region: position.region,
+                                         frame: position.frame, iteration: position.iteration)
+            if queuedTransition == position.region {
+                queuedTransition = nil
+            }
+        } else if let frame = requestedFrame {
+            preview = SegmentGraphCursor(graph: graph)
+            preview.move(to: frame, in: graph.region(containing: frame) ?? graph.entry, graph: graph)
+        } else {
+            preview = SegmentGraphCursor(graph: graph, region: requestedRegion)
+        }
+
+        preview.pendingTransition = queuedTransition
+
+        var ranges: [Range<Int>] = []
+        var remaining = frames
+        while remaining > 0, let run = preview.nextRun(graph: graph, maxFrames: remaining) {
+            ranges.append(run)
+            remaining -= run.count
+        }
+        return ranges
+    }
+
+    /**
+     * Releases graphs the render thread has swapped out. Called whenever the
+     * main thread sends a graph, and safe to call periodically.
+     */
+    public func drainRetiredGraphs() {
+        while let box = retiredGraphs.pop() {
+            box.release()
+        }
+    }
+
+    @discardableResult
+    private func send(_ command: Command) -> Bool {
+        let sent = commands.push(command)
+        if !sent {
+            print("LoopRenderer command queue full; dropping command")
+        }
+        return sent
+    }
+
+    // MARK: - Rendering (render thread)
+
+    /**
+     * Fills `frameCount` frames of each destination channel, starting at
+     * `offset`, with the next frames of the graph. Frames the graph does not
+     * cover (paused, finished, no graph) are zero-filled.
+     *
+     * Real-time safe: no locks, no allocations, no Objective-C messaging.
+     *
+     * - Returns: Number of frames taken from the graph
+     */
+    @discardableResult
+    public func render(frameCount: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+                       offset: Int = 0) -> Int {
+        applyPendingCommands()
+
+        var written = 0
+        let channelCount = pcm.channelCount
+
+        if isRunning, let box = current {
+            // Read the graph through the box rather than a local copy, so loop
+            // point edits between runs stay in place
+            let holder = box.takeUnretainedValue()
+
+            while written < frameCount {
+                let region = cursor.region
+                let iteration = cursor.iteration
+                guard let run = cursor.nextRun(graph: holder.graph, maxFrames: frameCount - written) else { break }
+
+                pcm.read(from: run.lowerBound, count: run.count, into: destination, at: offset + written, gain: gain)
+                if fadeRemaining > 0 {
+                    mixCrossfade(into: destination, at: offset + written, count: run.count)
+                }
+                written += run.count
+
+                // A wrap or region change is a seam; deferred loop points land here
+                if hasPendingLoopPoints && (cursor.region != region || cursor.iteration != iteration) {
+                    applyLoopPoints(start: pendingLoopStart, end: pendingLoopEnd, timing: .nextSeam, atSeam: true)
+                }
+            }
+        }
+
+        // Silence whatever the graph didn't cover
+        if written < frameCount {
+            for channel in 0..<channelCount {
+                (destination[channel] + offset + written).update(repeating: 0, count: frameCount - written)
+            }
+        }
+
+        // Meter exactly what goes out; if the UI falls behind the block is dropped
+        meterRing?.write(from: destination, offset: offset, frameCount: frameCount)
+
+        publishedFrame.store(cursor.frame, ordering: .relaxed)
+        publishedRegion.store(cursor.region, ordering: .relaxed)
+        publishedIteration.store(cursor.iteration, ordering: .relaxed)
+        publishedFinished.store(cursor.isFinished, ordering: .relaxed)
+        publishedGeneration.store(currentGeneration, ordering: .releasing)
+        renderedFrames.wrappingIncrement(by: written, ordering: .relaxed)
+
+        // Reading the host clock is real-time safe
+        if written > 0 && awaitingFirstFrame.load(ordering: .relaxed) {
+            firstFrameUptime.store(DispatchTime.now().uptimeNanoseconds, ordering: .relaxed)
+            awaitingFirstFrame.store(false, ordering: .releasing)
+        }
+
+        return written
+    }
+
+    /// Whether the graph has played to its end. Render thread only.
+    public var isGraphFinished: Bool {
+        return current != nil && cursor.isFinished
+    }
+
+    /**
+     * Applies every queued command. Render thread only.
+     */
+    private func applyPendingCommands() {
+        while let command = commands.pop() {
+            switch command {
+            case .setGraph(let box, let region, let frame, let generation):
+                if let old = current {
+                    // Never free on the render thread; if the retire queue is full, leak instead
+                    _ = retiredGraphs.push(old)
+                }
+                current = box
+                currentGeneration = generation
+                hasPendingLoopPoints = false
+                fadeRemaining = 0
+
+                let graph = box.takeUnretainedValue().graph
+                if let frame = frame {
+                    cursor = SegmentGraphCursor(graph: graph)
+                    cursor.move(to: frame, in: graph.region(containing: frame) ?? graph.entry, graph: graph)
+                } else {
+                    cursor = SegmentGraphCursor(graph: graph, region: region)
+                }
+
+            case .transition(let region):
+                cursor.pendingTransition = region
+
+            case .setLoopPoints(let start, let end, let timing):
+                applyLoopPoints(start: start, end: end, timing: timing)
+
+            case .seek(let frame):
+                if let box = current {
+                    let graph = box.takeUnretainedValue().graph
+                    if isRunning && !cursor.isFinished {
+                        beginCrossfade(from: cursor.frame)
+                    }
+                    cursor.move(to: frame, in: graph.region(containing: frame) ?? cursor.region, graph: graph)
+                }
+                appliedSeeks.wrappingIncrement(ordering: .releasing)
+
+            case .setRunning(let running):
+                isRunning = running
+
+            case .setGain(let newGain):
+                gain = newGain
+            }
+        }
+    }
+
+    /**
+     * Moves the loop region of the playing graph. Render thread only.
+     *
+     * Outside the loop the change is harmless and applies at once. Inside it,
+     * `.nextSeam` defers the change until the current pass ends, so the pass
+     * plays out on the old end and the next one starts on the new start.
+     */
+    private func applyLoopPoints(start: Int, end: Int, timing: LoopPointTiming, atSeam: Bool = false) {
+        hasPendingLoopPoints = false
+        guard let box = current, end > start else { return }
+        let holder = box.takeUnretainedValue()
+        guard let loop = holder.graph.loopRegion else { return }
+
+        let inLoop = !cursor.isFinished && cursor.region == loop
+        if inLoop && timing == .nextSeam && !atSeam {
+            pendingLoopStart = start
+            pendingLoopEnd = end
+            hasPendingLoopPoints = true
+            return
+        }
+
+        let oldStart = holder.graph.regions[loop].startFrame
+        holder.graph.setLoopBounds(startFrame: start, endFrame: end)
+        let newStart = holder.graph.regions[loop].startFrame
+        let newEnd = holder.graph.regions[loop].endFrame
+
+        if inLoop {
+            if atSeam && cursor.frame == oldStart {
+                // Just wrapped onto the old start: begin this pass on the new one
+                cursor.jump(to: newStart, graph: holder.graph)
+            } else if cursor.frame < newStart || cursor.frame >= newEnd {
+                beginCrossfade(from: cursor.frame)
+                cursor.jump(to: newStart, graph: holder.graph)
+            }
+        } else if !cursor.isFinished,
+                  holder.graph.regions[cursor.region].next == loop,
+                  cursor.frame >= newStart && cursor.frame < newEnd {
+            // The lead-in now overlaps the loop; carry on into it without a jump
+            cursor.move(to: cursor.frame, in: loop, graph: holder.graph)
+        }
+    }
+
+    /// Starts fading out the stream at `frame` under whatever is rendered next
+    private func beginCrossfade(from frame: Int) {
+        fadeSourceFrame = frame
+        fadeRemaining = LoopRenderer.crossfadeFrames
+    }
+
+    /**
+     * Blends the abandoned stream under freshly written frames with an
+     * equal-power curve. Render thread only.
+     */
+    private func mixCrossfade(into destination: UnsafePointer<UnsafeMutablePointer<Float>>, at start: Int, count: Int) {
+        let length = LoopRenderer.crossfadeFrames
+        let frames = min(count, fadeRemaining)
+        pcm.read(from: fadeSourceFrame, count: frames, into: fadeScratch, at: 0, gain: gain)
+
+        for index in 0..<frames {
+            let progress = Float(length - fadeRemaining + index) / Float(length)
+            let gainIn = sin(progress * .pi / 2)
+            let gainOut = cos(progress * .pi / 2)
+
+            for channel in 0..<pcm.channelCount {
+                destination[channel][start + index] = destination[channel][start + index] * gainIn
+                    + fadeScratch[channel][index] * gainOut
+            }
+        }
+
+        fadeSourceFrame += frames
+        fadeRemaining -= frames
+    }
+
+    // MARK: - Offline Rendering
+
+    /**
+     * Renders `frameCount` frames into caller-owned channel memory in
+     * `blockSize` pulls, exactly as a host would. Stops early when the graph
+     * finishes.
+     *
+     * - Returns: Number of frames taken from the graph
+     */
+    @discardableResult
+    public func renderOffline(frameCount: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+                              blockSize: Int = 512) -> Int {
+        var rendered = 0
+
+        while rendered < frameCount {
+            let taken = render(frameCount: min(blockSize, frameCount - rendered), into: destination, offset: rendered)
+            rendered += taken
+
+            if taken == 0 {
+                break
+            }
+        }
+
+        return rendered
+    }
+
+    /**
+     * Renders up to `frameCount` frames offline into new per-channel arrays.
+     */
+    public func renderOffline(frameCount: Int, blockSize: Int = 512) -> [[Float]] {
+        let channelCount = pcm.channelCount
+        let table = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: max(1, channelCount))
+        for channel in 0..<channelCount {
+            (table + channel).initialize(to: UnsafeMutablePointer<Float>.allocate(capacity: max(1, frameCount)))
+        }
+        defer {
+            for channel in 0..<channelCount {
+                table[channel].deallocate()
+            }
+            table.deallocate()
+        }
+
+        let rendered = renderOffline(frameCount: frameCount, into: table, blockSize: blockSize)
+
+        return (0..<channelCount).map { channel in
+            Array(UnsafeBufferPointer(start: table[channel], count: rendered))
+        }
+    }
+}
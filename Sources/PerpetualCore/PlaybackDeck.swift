@@ -0,0 +1,190 @@
+import Foundation
+import Atomics
+
+/**
+ * PlaybackDeck
+ *
+ * Hosts the playing `LoopRenderer` behind a single output, with the next
+ * track's renderer armed behind it. When the current graph ends partway
+ * through a block, the rest of that block is rendered from the successor,
+ * so back-to-back tracks meet sample to sample with no gap and nothing is
+ * scheduled or attached at the boundary.
+ *
+ * Like the renderer it hosts, the deck takes no locks on the render thread:
+ * renderers arrive through a command queue and leave through a retire queue
+ * that the main thread drains.
+ */
+public final class PlaybackDeck {
+    /// Messages from the main thread to the render thread
+    enum Command {
+        /// Play this renderer from the next block on
+        case setCurrent(Unmanaged<LoopRenderer>)
+
+        /// Take over from the current renderer once its graph finishes (nil disarms)
+        case setSuccessor(Unmanaged<LoopRenderer>?)
+    }
+
+    /// Output format every hosted renderer must match
+    public let channelCount: Int
+    public let sampleRate: Double
+
+    /// Main → render commands
+    private let commands = SPSCQueue<Command>(capacity: 16)
+
+    /// Render → main renderers that were replaced and must be released off the render thread
+    private let retiredRenderers = SPSCQueue<Unmanaged<LoopRenderer>>(capacity: 16)
+
+    /// Number of automatic hand-offs to a successor so far
+    private let handoffCount = UnsafeAtomic<Int>.create(0)
+
+    // MARK: - Render-Thread State
+
+    private var current: Unmanaged<LoopRenderer>?
+    private var successor: Unmanaged<LoopRenderer>?
+
+    /// Preallocated destination pointer table for host adapters
+    public let outputChannels: UnsafeMutablePointer<UnsafeMutablePointer<Float>>
+
+    /// One frame of silence the output table points at until a host fills it in
+    private let placeholder: UnsafeMutablePointer<Float>
+
+    // MARK: - Lifecycle
+
+    public init(channelCount: Int, sampleRate: Double) {
+        self.channelCount = channelCount
+        self.sampleRate = sampleRate
+
+        placeholder = UnsafeMutablePointer<Float>.allocate(capacity: 1)
+        placeholder.initialize(to: 0)
+        outputChannels = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: max(1, channelCount))
+        outputChannels.initialize(repeating: placeholder, count: max(1, channelCount))
+    }
+
+    deinit {
+        // Release renderers still in flight in either direction
+        while let command = commands.pop() {
+            switch command {
+            case .setCurrent(let renderer):
+                renderer.release()
+            case .setSuccessor(let renderer):
+                renderer?.release()
+            }
+        }
+        drainRetiredRenderers()
+        current?.release()
+        successor?.release()
+
+        outputChannels.deallocate()
+        placeholder.deallocate()
+        handoffCount.destroy()
+    }
+
+    // MARK: - Control (main thread)
+
+    /// Whether a renderer for `pcm` can play on this deck
+    public func accepts(_ pcm: PCMSource) -> Bool {
+        return pcm.channelCount == channelCount && pcm.sampleRate == sampleRate
+    }
+
+    /**
+     * Switches to `renderer` at the next block. The renderer should already
+     * have its graph; whatever was playing is retired.
+     */
+    public func play(_ renderer: LoopRenderer) {
+        drainRetiredRenderers()
+        let reference = Unmanaged.passRetained(renderer)
+        if !send(.setCurrent(reference)) {
+            reference.release()
+        }
+    }
+
+    /**
+     * Arms `renderer` to take over, sample-accurately, when the current graph
+     * finishes. Replaces any renderer armed before; nil disarms.
+     */
+    public func queueNext(_ renderer: LoopRenderer?) {
+        drainRetiredRenderers()
+        let reference = renderer.map { Unmanaged.passRetained($0) }
+        if !send(.setSuccessor(reference)) {
+            reference?.release()
+        }
+    }
+
+    /// Number of automatic hand-offs the render thread has made
+    public var handoffs: Int {
+        return handoffCount.load(ordering: .acquiring)
+    }
+
+    /**
+     * Releases renderers the render thread has swapped out. Called whenever
+     * the main thread sends a renderer, and safe to call periodically.
+     */
+    public func drainRetiredRenderers() {
+        while let renderer = retiredRenderers.pop() {
+            renderer.release()
+        }
+    }
+
+    @discardableResult
+    private func send(_ command: Command) -> Bool {
+        let sent = commands.push(command)
+        if !sent {
+            print("PlaybackDeck command queue full; dropping command")
+        }
+        return sent
+    }
+
+    // MARK: - Rendering (render thread)
+
+    /**
+     * Fills `frameCount` frames of each destination channel from the current
+     * renderer, continuing into the successor if the current graph ends
+     * within the block.
+     *
+     * Real-time safe: no locks, no allocations, no Objective-C messaging.
+     */
+    public func render(frameCount: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>) {
+        applyPendingCommands()
+
+        guard let playing = current else {
+            for channel in 0..<channelCount {
+                destination[channel].update(repeating: 0, count: frameCount)
+            }
+            return
+        }
+
+        let renderer = playing.takeUnretainedValue()
+        let taken = renderer.render(frameCount: frameCount, into: destination)
+
+        guard taken < frameCount, renderer.isGraphFinished, let next = successor else { return }
+
+        // The successor starts on the first frame the finished graph left silent
+        _ = retiredRenderers.push(playing)
+        current = next
+        successor = nil
+        next.takeUnretainedValue().render(frameCount: frameCount - taken, into: destination, offset: taken)
+        handoffCount.wrappingIncrement(ordering: .releasing)
+    }
+
+    /**
+     * Applies every queued command. Render thread only.
+     */
+    private func applyPendingCommands() {
+        while let command = commands.pop() {
+            switch command {
+            case .setCurrent(let renderer):
+                if let old = current {
+                    // Never free on the render thread; if the retire queue is full, leak instead
+                    _ = retiredRenderers.push(old)
+                }
+                current = renderer
+
+            case .setSuccessor(let renderer):
+                if let old = successor {
+                    _ = retiredRenderers.push(old)
+                }
+                successor = renderer
+            }
+        }
+    }
+}
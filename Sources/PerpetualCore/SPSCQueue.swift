@@ -0,0 +1,82 @@
+import Atomics
+
+/**
+ * SPSCQueue
+ *
+ * A bounded, lock-free single-producer/single-consumer queue.
+ * Used to hand values between the main thread and the audio render thread
+ * without locks or allocations: storage is allocated once up front, and
+ * push/pop only touch two atomic indices.
+ *
+ * Exactly one thread may push and exactly one (other) thread may pop.
+ */
+public final class SPSCQueue<Element> {
+    /// Number of slots (always a power of two)
+    public let capacity: Int
+    
+    private let mask: Int
+    private let storage: UnsafeMutablePointer<Element>
+    
+    /// Index of the next slot to read (owned by the consumer)
+    private let head = UnsafeAtomic<Int>.create(0)
+    
+    /// Index of the next slot to write (owned by the producer)
+    private let tail = UnsafeAtomic<Int>.create(0)
+    
+    /**
+     * Creates a queue holding at least `capacity` elements.
+     */
+    public init(capacity: Int) {
+        var size = 1
+        while size < max(2, capacity) {
+            size <<= 1
+        }
+        self.capacity = size
+        self.mask = size - 1
+        self.storage = UnsafeMutablePointer<Element>.allocate(capacity: size)
+    }
+    
+    deinit {
+        // Release anything still queued
+        while pop() != nil {}
+        storage.deallocate()
+        head.destroy()
+        tail.destroy()
+    }
+    
+    /**
+     * Appends an element. Producer side only.
+     *
+     * - Returns: false if the queue is full and the element was dropped
+     */
+    @discardableResult
+    public func push(_ element: Element) -> Bool {
+        let writeIndex = tail.load(ordering: .relaxed)
+        let readIndex = head.load(ordering: .acquiring)
+        
+        guard writeIndex - readIndex < capacity else { return false }
+        
+        (storage + (writeIndex & mask)).initialize(to: element)
+        tail.store(writeIndex + 1, ordering: .releasing)
+        return true
+    }
+    
+    /**
+     * Removes the oldest element. Consumer side only.
+     */
+    public func pop() -> Element? {
+        let readIndex = head.load(ordering: .relaxed)
+        let writeIndex = tail.load(ordering: .acquiring)
+        
+        guard readIndex != writeIndex else { return nil }
+        
+        let element = (storage + (readIndex & mask)).move()
+        head.store(readIndex + 1, ordering: .releasing)
+        return element
+    }
+    
+    /// Number of queued elements (approximate when read from the producer side)
+    public var count: Int {
+        return tail.load(ordering: .acquiring) - head.load(ordering: .acquiring)
+    }
+}
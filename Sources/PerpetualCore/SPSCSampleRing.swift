@@ -0,0 +1,112 @@
+import Atomics
+
+/**
+ * SPSCSampleRing
+ *
+ * A lock-free single-producer/single-consumer ring of interleaved float
+ * frames, for streaming audio off the render thread. Writes copy whole
+ * blocks and never allocate or block; a block that doesn't fit is dropped
+ * and counted, so a slow consumer can't stall the producer.
+ */
+public final class SPSCSampleRing {
+    /// Interleaved channels per frame
+    public let channelCount: Int
+
+    /// Frames the ring holds (always a power of two)
+    public let capacity: Int
+
+    private let mask: Int
+    private let storage: UnsafeMutablePointer<Float>
+
+    /// Frames read so far (owned by the consumer)
+    private let head = UnsafeAtomic<Int>.create(0)
+
+    /// Frames written so far (owned by the producer)
+    private let tail = UnsafeAtomic<Int>.create(0)
+
+    /// Blocks dropped because the ring was full
+    private let droppedBlocks = UnsafeAtomic<Int>.create(0)
+
+    /**
+     * Creates a ring holding at least `capacity` frames of `channelCount` channels.
+     */
+    public init(channelCount: Int, capacity: Int) {
+        var size = 1
+        while size < max(2, capacity) {
+            size <<= 1
+        }
+        self.channelCount = max(1, channelCount)
+        self.capacity = size
+        self.mask = size - 1
+        self.storage = UnsafeMutablePointer<Float>.allocate(capacity: size * self.channelCount)
+        self.storage.initialize(repeating: 0, count: size * self.channelCount)
+    }
+
+    deinit {
+        storage.deallocate()
+        head.destroy()
+        tail.destroy()
+        droppedBlocks.destroy()
+    }
+
+    /**
+     * Interleaves and appends `frameCount` frames of de-interleaved channels
+     * starting at `offset`. Producer side only; real-time safe.
+     *
+     * - Returns: false if the block didn't fit and was dropped
+     */
+    @discardableResult
+    public func write(from channels: UnsafePointer<UnsafeMutablePointer<Float>>, offset: Int, frameCount: Int) -> Bool {
+        let writeIndex = tail.load(ordering: .relaxed)
+        let readIndex = head.load(ordering: .acquiring)
+
+        guard frameCount <= capacity - (writeIndex - readIndex) else {
+            droppedBlocks.wrappingIncrement(ordering: .relaxed)
+            return false
+        }
+
+        for frame in 0..<frameCount {
+            let slot = ((writeIndex + frame) & mask) * channelCount
+            for channel in 0..<channelCount {
+                storage[slot + channel] = channels[channel][offset + frame]
+            }
+        }
+
+        tail.store(writeIndex + frameCount, ordering: .releasing)
+        return true
+    }
+
+    /**
+     * Reads up to `maxFrames` interleaved frames into `destination`.
+     * Consumer side only.
+     *
+     * - Returns: Number of frames read
+     */
+    public func read(into destination: UnsafeMutablePointer<Float>, maxFrames: Int) -> Int {
+        let readIndex = head.load(ordering: .relaxed)
+        let writeIndex = tail.load(ordering: .acquiring)
+        let frames = min(maxFrames, writeIndex - readIndex)
+        guard frames > 0 else { return 0 }
+
+        // Copy in at most two contiguous pieces around the wrap
+        let start = readIndex & mask
+        let first = min(frames, capacity - start)
+        destination.update(from: storage + start * channelCount, count: first * channelCount)
+        if frames > first {
+            (destination + first * channelCount).update(from: storage, count: (frames - first) * channelCount)
+        }
+
+        head.store(readIndex + frames, ordering: .releasing)
+        return frames
+    }
+
+    /// Frames waiting to be read
+    public var availableFrames: Int {
+        return tail.load(ordering: .acquiring) - head.load(ordering: .acquiring)
+    }
+
+    /// Blocks the producer had to drop
+    public var dropCount: Int {
+        return droppedBlocks.load(ordering: .relaxed)
+    }
+}
@@ -0,0 +1,321 @@
+import Foundation
+
+/**
+ * SegmentGraph
+ *
+ * Describes a track as a set of named regions of the resident audio buffer
+ * and the transitions between them (intro → loop A ⇄ loop B → outro), the way
+ * adaptive game audio middleware models interactive music.
+ *
+ * Regions are plain frame ranges into the one resident buffer, so moving
+ * between them never copies audio. Each region either plays once, repeats a
+ * fixed number of times, or repeats until a transition is requested. Requested
+ * transitions are applied at the next region boundary, to the sample.
+ */
+public struct SegmentGraph {
+    /// How a region behaves when playback reaches its end
+    public enum Behavior: Equatable {
+        /// Play once, then continue into `next`
+        case sequential
+
+        /// Repeat the region `times` times, then continue into `next`
+        case loop(times: Int)
+
+        /// Repeat the region until a transition is queued
+        case onDemand
+    }
+
+    /// A named frame range of the resident buffer
+    public struct Region: Identifiable {
+        public var id: Int
+        public var name: String
+        public var startFrame: Int
+        public var endFrame: Int
+        public var behavior: Behavior
+
+        /// Index of the region that follows this one (nil = end of playback)
+        public var next: Int?
+
+        public var frameCount: Int {
+            return max(0, endFrame - startFrame)
+        }
+    }
+
+    /// All regions, indexed by `Region.id`
+    public private(set) var regions: [Region] = []
+
+    /// Region where playback starts
+    public var entry: Int = 0
+
+    public init() {}
+
+    // MARK: - Building
+
+    /**
+     * Appends a region to the graph.
+     *
+     * - Returns: The index of the new region, for use as a `next` target
+     */
+    @discardableResult
+    public mutating func addRegion(name: String, startFrame: Int, endFrame: Int,
+                            behavior: Behavior, next: Int? = nil) -> Int {
+        let index = regions.count
+        regions.append(Region(id: index,
+                              name: name,
+                              startFrame: max(0, startFrame),
+                              endFrame: max(startFrame, endFrame),
+                              behavior: behavior,
+                              next: next))
+        return index
+    }
+
+    /// Sets the region that follows `region`
+    public mutating func connect(_ region: Int, to next: Int?) {
+        guard regions.indices.contains(region) else { return }
+        regions[region].next = next
+    }
+
+    /// Returns the index of the first region with the given name
+    public func index(named name: String) -> Int? {
+        return regions.firstIndex { $0.name == name }
+    }
+
+    /// Returns the region that contains the given frame, preferring looping regions.
+    /// Does not allocate, so it is safe to call from the render thread.
+    public func region(containing frame: Int) -> Int? {
+        var firstMatch: Int?
+        for region in regions where frame >= region.startFrame && frame < region.endFrame {
+            if region.behavior != .sequential {
+                return region.id
+            }
+            if firstMatch == nil {
+                firstMatch = region.id
+            }
+        }
+        return firstMatch
+    }
+
+    /// Index of the first repeating region; in a single-loop graph this is the loop
+    public var loopRegion: Int? {
+        return regions.firstIndex { $0.behavior != .sequential }
+    }
+
+    // MARK: - Editing
+
+    /**
+     * Moves the loop region to new bounds, keeping any lead-in that ends at
+     * the old loop start attached to the new one.
+     *
+     * Edits happen in place, so on a graph with unshared storage (see
+     * `detachStorage`) this does not allocate.
+     *
+     * - Returns: false if the graph has no loop region
+     */
+    @discardableResult
+    public mutating func setLoopBounds(startFrame: Int, endFrame: Int) -> Bool {
+        guard let loop = loopRegion else { return false }
+        let oldStart = regions[loop].startFrame
+        let start = max(0, startFrame)
+        let end = max(start, endFrame)
+
+        for index in regions.indices where index != loop {
+            if regions[index].next == loop && regions[index].endFrame == oldStart {
+                regions[index].endFrame = max(regions[index].startFrame, start)
+            }
+        }
+
+        regions[loop].startFrame = start
+        regions[loop].endFrame = end
+        return true
+    }
+
+    /// Gives this graph its own region storage so later in-place edits never copy
+    public mutating func detachStorage() {
+        regions = regions.map { $0 }
+    }
+
+    // MARK: - Factories
+
+    /**
+     * Builds the classic single-loop graph: a lead-in that plays once,
+     * followed by a loop region repeated `loopCount` times (0 = forever).
+     * The lead-in is kept even when empty so the loop start can move later.
+     */
+    public static func singleLoop(frameCount: Int, loopStartFrame: Int, loopEndFrame: Int, loopCount: Int) -> SegmentGraph {
+        var graph = SegmentGraph()
+        let loopStart = max(0, min(loopStartFrame, frameCount))
+        let loopEnd = max(loopStart, min(loopEndFrame, frameCount))
+
+        let loop = graph.addRegion(name: "Loop",
+                                   startFrame: loopStart,
+                                   endFrame: loopEnd,
+                                   behavior: loopCount > 0 ? .loop(times: loopCount) : .onDemand)
+        graph.entry = graph.addRegion(name: "Intro", startFrame: 0, endFrame: loopStart,
+                                      behavior: .sequential, next: loop)
+
+        return graph
+    }
+}
+
+/**
+ * SegmentGraphCursor
+ *
+ * The playback state machine for a `SegmentGraph`. It hands out contiguous
+ * frame runs of the resident buffer and resolves region boundaries, loop
+ * iterations and queued transitions. It is a plain value with no allocations,
+ * so it is safe to drive from a render callback and trivial to run offline.
+ */
+public struct SegmentGraphCursor {
+    /// Index of the region currently playing
+    public private(set) var region: Int
+
+    /// Absolute frame in the resident buffer that will be read next
+    public private(set) var frame: Int
+
+    /// Completed iterations of the current region
+    public private(set) var iteration: Int = 0
+
+    /// Whether playback has run off the end of the graph
+    public private(set) var isFinished: Bool = false
+
+    /// Region to jump to at the next region boundary
+    public var pendingTransition: Int?
+
+    /**
+     * Creates a cursor at the start of `region`, or the graph entry if nil.
+     */
+    public init(graph: SegmentGraph, region: Int? = nil) {
+        let start = region ?? graph.entry
+        self.region = start
+        self.frame = graph.regions.indices.contains(start) ? graph.regions[start].startFrame : 0
+        self.isFinished = !graph.regions.indices.contains(start)
+    }
+
+    /**
+     * Recreates a cursor from a reported position, e.g. to look ahead of the
+     * render thread without touching its state.
+     */
+    public init(graph: SegmentGraph, region: Int, frame: Int, iteration: Int) {
+        self.init(graph: graph, region: region)
+        if !isFinished {
+            let current = graph.regions[region]
+            self.frame = max(current.startFrame, min(frame, current.endFrame))
+            self.iteration = iteration
+        }
+    }
+
+    /**
+     * Moves the cursor to an absolute frame inside `region` and resets its iteration count.
+     */
+    public mutating func move(to frame: Int, in region: Int, graph: SegmentGraph) {
+        guard graph.regions.indices.contains(region) else {
+            isFinished = true
+            return
+        }
+        let target = graph.regions[region]
+        self.region = region
+        self.frame = max(target.startFrame, min(frame, target.endFrame))
+        self.iteration = 0
+        self.isFinished = false
+
+        if self.frame >= target.endFrame {
+            crossBoundary(graph: graph)
+        }
+    }
+
+    /**
+     * Moves the read position within the current region without touching the
+     * iteration count, e.g. after the region's bounds were edited.
+     */
+    public mutating func jump(to frame: Int, graph: SegmentGraph) {
+        guard !isFinished, graph.regions.indices.contains(region) else { return }
+        let current = graph.regions[region]
+        self.frame = max(current.startFrame, min(frame, current.endFrame))
+
+        if self.frame >= current.endFrame {
+            crossBoundary(graph: graph)
+        }
+    }
+
+    /**
+     * Returns the next contiguous run of at most `maxFrames` frames and advances
+     * past it. Region boundaries fall exactly between runs, so a caller that
+     * copies runs back to back gets a sample-accurate stream.
+     *
+     * - Returns: The source frame range, or nil when playback has finished
+     */
+    public mutating func nextRun(graph: SegmentGraph, maxFrames: Int) -> Range<Int>? {
+        guard !isFinished, maxFrames > 0 else { return nil }
+
+        // The region may have been emptied or shrunk behind the cursor
+        if frame >= graph.regions[region].endFrame {
+            crossBoundary(graph: graph)
+            if isFinished { return nil }
+        }
+
+        let current = graph.regions[region]
+        let count = min(maxFrames, current.endFrame - frame)
+        let run = frame..<(frame + count)
+        frame += count
+
+        if frame >= current.endFrame {
+            crossBoundary(graph: graph)
+        }
+
+        return run
+    }
+
+    /**
+     * Resolves what happens at the end of the current region: a queued
+     * transition wins, then the region's own behavior decides.
+     */
+    private mutating func crossBoundary(graph: SegmentGraph) {
+        // Empty regions are skipped; bound the walk so a cycle of empty regions can't spin
+        for _ in 0...graph.regions.count {
+            let current = graph.regions[region]
+            iteration += 1
+
+            if let target = pendingTransition {
+                pendingTransition = nil
+                enter(target, graph: graph)
+            } else {
+                switch current.behavior {
+                case .sequential:
+                    follow(current.next, graph: graph)
+                case .loop(let times):
+                    if iteration < times {
+                        frame = current.startFrame
+                    } else {
+                        follow(current.next, graph: graph)
+                    }
+                case .onDemand:
+                    frame = current.startFrame
+                }
+            }
+
+            if isFinished || graph.regions[region].frameCount > 0 {
+                return
+            }
+        }
+
+        isFinished = true
+    }
+
+    private mutating func enter(_ target: Int, graph: SegmentGraph) {
+        guard graph.regions.indices.contains(target) else {
+            isFinished = true
+            return
+        }
+        region = target
+        iteration = 0
+        frame = graph.regions[target].startFrame
+    }
+
+    private mutating func follow(_ next: Int?, graph: SegmentGraph) {
+        if let next = next {
+            enter(next, graph: graph)
+        } else {
+            isFinished = true
+        }
+    }
+}
@@ -0,0 +1,327 @@
+import Foundation
+import Atomics
+
+/**
+ * StreamedPCM
+ *
+ * A PCM source that keeps only a small ring of fixed-size decoded chunks in
+ * memory instead of the whole file. A background queue decodes the chunks
+ * the renderer is about to read (see `LoopRenderer.upcomingReads`), reusing
+ * the least recently needed slot, so playback memory stays constant no matter
+ * how long the track or the loop is.
+ *
+ * The render thread finds chunks through an atomic chunk → slot map and
+ * validates each copy with a per-slot sequence number, so a slot that is
+ * refilled mid-copy yields silence rather than torn audio. A chunk that
+ * isn't decoded in time also plays as silence and counts as an underrun.
+ */
+public final class StreamedPCM: PCMSource {
+    /**
+     * Decodes `frameCount` frames starting at `startFrame` into the given
+     * channel pointers. Called on the decode queue only.
+     *
+     * - Returns: Number of frames decoded
+     */
+    public typealias Decoder = (_ startFrame: Int, _ frameCount: Int,
+                                _ destination: UnsafePointer<UnsafeMutablePointer<Float>>) -> Int
+
+    /// Default chunk length in frames
+    public static let defaultChunkFrames = 16384
+
+    /// Default number of chunk slots (about 12 s at 44.1 kHz)
+    public static let defaultSlotCount = 32
+
+    public let channelCount: Int
+    public let frameCount: Int
+    public let sampleRate: Double
+
+    /// Frames per chunk
+    public let chunkFrames: Int
+
+    /// Number of chunks held in memory at once
+    public let slotCount: Int
+
+    /// Number of chunks in the whole file
+    public let chunkCount: Int
+
+    private let decoder: Decoder
+    private let decodeQueue = DispatchQueue(label: "com.perpetual.streamedpcm", qos: .userInitiated)
+
+    // MARK: - Slot Storage
+
+    /// Sample memory for every slot: slot-major, then channel
+    private let samples: UnsafeMutablePointer<Float>
+
+    /// Per-slot channel pointer tables handed to the decoder
+    private let slotChannels: UnsafeMutablePointer<UnsafeMutablePointer<Float>>
+
+    /// Chunk → slot holding it (-1 = not resident)
+    private let chunkSlotStorage: UnsafeMutablePointer<UnsafeAtomic<Int>.Storage>
+
+    /// Slot → chunk it holds (-1 = empty)
+    private let slotChunkStorage: UnsafeMutablePointer<UnsafeAtomic<Int>.Storage>
+
+    /// Slot write sequence; odd while the slot is being refilled
+    private let slotSequenceStorage: UnsafeMutablePointer<UnsafeAtomic<Int>.Storage>
+
+    /// Reads that had to play silence because a chunk wasn't resident
+    private let underrunCount = UnsafeAtomic<Int>.create(0)
+
+    // MARK: - Decode-Queue State
+
+    /// Tick at which each slot was last part of a prefetch request
+    private var slotLastNeeded: [Int]
+    private var tick = 0
+
+    /// Latest prefetch request, coalesced between decode passes
+    private let requestLock = NSLock()
+    private var requestedChunks: [Int] = []
+    private var isDecodeScheduled = false
+
+    // MARK: - Lifecycle
+
+    /**
+     * Creates a streamed source.
+     *
+     * - Parameters:
+     *   - decoder: Random-access decoder for the underlying file
+     *   - chunkFrames: Frames per chunk
+     *   - slotCount: Chunks held in memory at once
+     */
+    public init(channelCount: Int, frameCount: Int, sampleRate: Double, decoder: @escaping Decoder,
+                chunkFrames: Int = StreamedPCM.defaultChunkFrames, slotCount: Int = StreamedPCM.defaultSlotCount) {
+        self.channelCount = channelCount
+        self.frameCount = frameCount
+        self.sampleRate = sampleRate
+        self.decoder = decoder
+        self.chunkFrames = max(1, chunkFrames)
+        self.slotCount = max(2, slotCount)
+        self.chunkCount = max(1, (frameCount + self.chunkFrames - 1) / self.chunkFrames)
+        self.slotLastNeeded = Array(repeating: -1, count: self.slotCount)
+
+        let channels = max(1, channelCount)
+        let slotSamples = self.chunkFrames * channels
+        samples = UnsafeMutablePointer<Float>.allocate(capacity: self.slotCount * slotSamples)
+        samples.initialize(repeating: 0, count: self.slotCount * slotSamples)
+
+        slotChannels = UnsafeMutablePointer<UnsafeMutablePointer<Float>>.allocate(capacity: self.slotCount * channels)
+        for slot in 0..<self.slotCount {
+            for channel in 0..<channels {
+                (slotChannels + slot * channels + channel).initialize(to: samples + slot * slotSamples + channel * self.chunkFrames)
+            }
+        }
+
+        chunkSlotStorage = UnsafeMutablePointer<UnsafeAtomic<Int>.Storage>.allocate(capacity: chunkCount)
+        for chunk in 0..<chunkCount {
+            (chunkSlotStorage + chunk).initialize(to: UnsafeAtomic<Int>.Storage(-1))
+        }
+
+        slotChunkStorage = UnsafeMutablePointer<UnsafeAtomic<Int>.Storage>.allocate(capacity: self.slotCount)
+        slotSequenceStorage = UnsafeMutablePointer<UnsafeAtomic<Int>.Storage>.allocate(capacity: self.slotCount)
+        for slot in 0..<self.slotCount {
+            (slotChunkStorage + slot).initialize(to: UnsafeAtomic<Int>.Storage(-1))
+            (slotSequenceStorage + slot).initialize(to: UnsafeAtomic<Int>.Storage(0))
+        }
+    }
+
+    deinit {
+        // Decode passes hold a strong reference, so none can be running here
+        for chunk in 0..<chunkCount {
+            _ = UnsafeAtomic<Int>(at: chunkSlotStorage + chunk).destroy()
+        }
+        chunkSlotStorage.deallocate()
+
+        for slot in 0..<slotCount {
+            _ = UnsafeAtomic<Int>(at: slotChunkStorage + slot).destroy()
+            _ = UnsafeAtomic<Int>(at: slotSequenceStorage + slot).destroy()
+        }
+        slotChunkStorage.deallocate()
+        slotSequenceStorage.deallocate()
+
+        slotChannels.deallocate()
+        samples.deallocate()
+        underrunCount.destroy()
+    }
+
+    /// Bytes of sample memory held by the chunk ring
+    public var residentBytes: Int {
+        return slotCount * chunkFrames * max(1, channelCount) * MemoryLayout<Float>.size
+    }
+
+    /// Reads that played silence because their chunk wasn't decoded yet
+    public var underruns: Int {
+        return underrunCount.load(ordering: .relaxed)
+    }
+
+    private func chunkSlot(_ chunk: Int) -> UnsafeAtomic<Int> {
+        return UnsafeAtomic(at: chunkSlotStorage + chunk)
+    }
+
+    private func slotChunk(_ slot: Int) -> UnsafeAtomic<Int> {
+        return UnsafeAtomic(at: slotChunkStorage + slot)
+    }
+
+    private func slotSequence(_ slot: Int) -> UnsafeAtomic<Int> {
+        return UnsafeAtomic(at: slotSequenceStorage + slot)
+    }
+
+    // MARK: - Reading (render thread)
+
+    @discardableResult
+    public func read(from frame: Int, count: Int, into destination: UnsafePointer<UnsafeMutablePointer<Float>>,
+                     at offset: Int, gain: Float) -> Int {
+        var copied = 0
+        var available = 0
+
+        while copied < count {
+            let position = frame + copied
+            let chunk = position >= 0 ? position / chunkFrames : -1
+            let within = position - max(0, chunk) * chunkFrames
+            let run = chunk >= 0 ? min(count - copied, chunkFrames - within) : min(count - copied, -position)
+            var isValid = false
+
+            if chunk >= 0 && position < frameCount {
+                let slot = chunkSlot(chunk).load(ordering: .acquiring)
+                if slot >= 0 {
+                    let sequence = slotSequence(slot).load(ordering: .acquiring)
+                    if sequence & 1 == 0 {
+                        for channel in 0..<channelCount {
+                            copySamples(slotChannels[slot * channelCount + channel] + within,
+                                        to: destination[channel] + offset + copied,
+                                        count: run,
+                                        gain: gain)
+                        }
+
+                        // Discard the copy if the slot was refilled underneath it
+                        atomicMemoryFence(ordering: .acquiring)
+                        isValid = slotSequence(slot).load(ordering: .relaxed) == sequence
+                            && slotChunk(slot).load(ordering: .relaxed) == chunk
+                    }
+                }
+            }
+
+            if isValid {
+                available += max(0, min(run, frameCount - position))
+            } else {
+                for channel in 0..<channelCount {
+                    (destination[channel] + offset + copied).update(repeating: 0, count: run)
+                }
+                if chunk >= 0 && position < frameCount {
+                    underrunCount.wrappingIncrement(ordering: .relaxed)
+                }
+            }
+
+            copied += run
+        }
+
+        return available
+    }
+
+    // MARK: - Prefetching
+
+    /**
+     * Asks the decode queue to make the chunks covering `ranges` resident,
+     * most urgent first. Requests made while a pass is running replace each
+     * other, so calling this at UI rate is cheap.
+     */
+    public func prefetch(_ ranges: [Range<Int>]) {
+        var chunks: [Int] = []
+        for range in ranges where !range.isEmpty {
+            let first = max(0, range.lowerBound / chunkFrames)
+            let last = min(chunkCount - 1, (range.upperBound - 1) / chunkFrames)
+            guard first <= last else { continue }
+            for chunk in first...last where !chunks.contains(chunk) {
+                chunks.append(chunk)
+            }
+        }
+
+        // Never ask for more than fits, or the request would evict itself
+        if chunks.count > slotCount {
+            chunks.removeLast(chunks.count - slotCount)
+        }
+
+        requestLock.lock()
+        requestedChunks = chunks
+        let shouldSchedule = !isDecodeScheduled
+        isDecodeScheduled = true
+        requestLock.unlock()
+
+        if shouldSchedule {
+            decodeQueue.async { self.decodePass() }
+        }
+    }
+
+    /**
+     * Blocks until every prefetch requested so far has been decoded. For
+     * offline rendering, which outruns real time; never call from the render thread.
+     */
+    public func waitForPrefetch() {
+        decodeQueue.sync {}
+    }
+
+    /**
+     * Decodes every missing chunk of the latest request. Decode queue only.
+     */
+    private func decodePass() {
+        while true {
+            requestLock.lock()
+            let chunks = requestedChunks
+            requestedChunks = []
+            if chunks.isEmpty {
+                isDecodeScheduled = false
+                requestLock.unlock()
+                return
+            }
+            requestLock.unlock()
+
+            tick += 1
+            for chunk in chunks {
+                let slot = chunkSlot(chunk).load(ordering: .relaxed)
+                if slot >= 0 {
+                    slotLastNeeded[slot] = tick
+                }
+            }
+
+            for chunk in chunks where chunkSlot(chunk).load(ordering: .relaxed) < 0 {
+                let slot = leastRecentlyNeededSlot()
+                fill(slot: slot, with: chunk)
+                slotLastNeeded[slot] = tick
+            }
+        }
+    }
+
+    /// The slot whose chunk was needed longest ago (empty slots first)
+    private func leastRecentlyNeededSlot() -> Int {
+        var best = 0
+        for slot in 1..<slotCount where slotLastNeeded[slot] < slotLastNeeded[best] {
+            best = slot
+        }
+        return best
+    }
+
+    /**
+     * Decodes `chunk` into `slot`, unpublishing whatever the slot held first.
+     */
+    private func fill(slot: Int, with chunk: Int) {
+        let previous = slotChunk(slot).load(ordering: .relaxed)
+        if previous >= 0 {
+            chunkSlot(previous).store(-1, ordering: .releasing)
+        }
+
+        slotSequence(slot).wrappingIncrement(ordering: .acquiringAndReleasing)
+
+        let startFrame = chunk * chunkFrames
+        let wanted = min(chunkFrames, frameCount - startFrame)
+        let table = slotChannels + slot * max(1, channelCount)
+        let decoded = max(0, min(wanted, decoder(startFrame, wanted, table)))
+        if decoded < chunkFrames {
+            for channel in 0..<channelCount {
+                (table[channel] + decoded).update(repeating: 0, count: chunkFrames - decoded)
+            }
+        }
+
+        slotChunk(slot).store(chunk, ordering: .relaxed)
+        slotSequence(slot).wrappingIncrement(ordering: .releasing)
+        chunkSlot(chunk).store(slot, ordering: .releasing)
+    }
+}
@@ -0,0 +1,111 @@
+import Foundation
+import PerpetualCore
+import XCTest
+
+/**
+ * LoopRendererTests
+ *
+ * Renders graphs offline over a ramp, where every sample holds its own
+ * frame number, so the output spells out exactly which source frame played
+ * where. Blocks are deliberately not aligned with region boundaries.
+ */
+final class LoopRendererTests: XCTestCase {
+    // MARK: - Segment Boundaries
+
+    func testLoopWrapsAtTheLoopEnd() {
+        let renderer = makeRenderer(frameCount: 400)
+        renderer.setGraph(SegmentGraph.singleLoop(frameCount: 400, loopStartFrame: 100, loopEndFrame: 200, loopCount: 0))
+        renderer.setRunning(true)
+
+        let output = renderer.renderOffline(frameCount: 350, blockSize: 37)[0]
+
+        XCTAssertEqual(output, ramp(0..<200) + ramp(100..<200) + ramp(100..<150))
+    }
+
+    func testTransitionWaitsForTheRegionBoundary() {
+        var graph = SegmentGraph()
+        let loopA = graph.addRegion(name: "Loop A", startFrame: 100, endFrame: 200, behavior: .onDemand)
+        let loopB = graph.addRegion(name: "Loop B", startFrame: 200, endFrame: 300, behavior: .onDemand)
+        graph.entry = graph.addRegion(name: "Intro", startFrame: 0, endFrame: 100, behavior: .sequential, next: loopA)
+
+        let renderer = makeRenderer(frameCount: 400)
+        renderer.setGraph(graph)
+        renderer.setRunning(true)
+
+        let lead = renderer.renderOffline(frameCount: 150, blockSize: 37)[0]
+        renderer.queueTransition(to: loopB)
+        let rest = renderer.renderOffline(frameCount: 200, blockSize: 37)[0]
+
+        // Loop A plays out its pass, then loop B starts on the next sample
+        XCTAssertEqual(lead, ramp(0..<150))
+        XCTAssertEqual(rest, ramp(150..<200) + ramp(200..<300) + ramp(200..<250))
+        XCTAssertEqual(renderer.position.region, loopB)
+    }
+
+    func testFiniteLoopContinuesIntoTheNextRegion() {
+        var graph = SegmentGraph()
+        let outro = graph.addRegion(name: "Outro", startFrame: 300, endFrame: 350, behavior: .sequential)
+        graph.entry = graph.addRegion(name: "Loop", startFrame: 100, endFrame: 200, behavior: .loop(times: 2), next: outro)
+
+        let renderer = makeRenderer(frameCount: 400)
+        renderer.setGraph(graph)
+        renderer.setRunning(true)
+
+        let output = renderer.renderOffline(frameCount: 400, blockSize: 64)[0]
+
+        XCTAssertEqual(output, ramp(100..<200) + ramp(100..<200) + ramp(300..<350))
+        XCTAssertTrue(renderer.position.isFinished)
+    }
+
+    // MARK: - Loop Points
+
+    func testDeferredLoopPointsTakeEffectAtTheNextSeam() {
+        let renderer = makeRenderer(frameCount: 1000)
+        renderer.setGraph(SegmentGraph.singleLoop(frameCount: 1000, loopStartFrame: 100, loopEndFrame: 300, loopCount: 0))
+        renderer.setRunning(true)
+
+        let lead = renderer.renderOffline(frameCount: 150, blockSize: 64)[0]
+        renderer.setLoopPoints(startFrame: 400, endFrame: 500, timing: .nextSeam)
+        let rest = renderer.renderOffline(frameCount: 350, blockSize: 64)[0]
+
+        // The current pass keeps the old end; every later pass uses the new loop
+        XCTAssertEqual(lead, ramp(0..<150))
+        XCTAssertEqual(rest, ramp(150..<300) + ramp(400..<500) + ramp(400..<500))
+    }
+
+    // MARK: - Seeking
+
+    func testSeekCrossfadesFromTheOldPosition() {
+        let renderer = makeRenderer(frameCount: 2000)
+        renderer.setGraph(SegmentGraph.singleLoop(frameCount: 2000, loopStartFrame: 500, loopEndFrame: 1800, loopCount: 0))
+        renderer.setRunning(true)
+
+        _ = renderer.renderOffline(frameCount: 100, blockSize: 100)
+        renderer.seek(toFrame: 1000)
+        XCTAssertTrue(renderer.hasPendingSeek)
+
+        let fade = LoopRenderer.crossfadeFrames
+        let output = renderer.renderOffline(frameCount: fade * 2, blockSize: 128)[0]
+        XCTAssertFalse(renderer.hasPendingSeek)
+
+        // The jump lands in the first block after the seek, under the fade
+        for index in 0..<fade {
+            let progress = Float(index) / Float(fade)
+            let expected = Float(1000 + index) * sin(progress * .pi / 2) + Float(100 + index) * cos(progress * .pi / 2)
+            XCTAssertEqual(output[index], expected, accuracy: 0.01, "frame \(index)")
+        }
+        XCTAssertEqual(Array(output[fade...]), ramp((1000 + fade)..<(1000 + fade * 2)))
+    }
+
+    // MARK: - Helpers
+
+    /// A mono renderer over `frameCount` frames whose samples are their frame numbers
+    private func makeRenderer(frameCount: Int) -> LoopRenderer {
+        let pcm = ResidentPCM(samples: [ramp(0..<frameCount)], sampleRate: 44100)
+        return LoopRenderer(pcm: pcm)
+    }
+
+    private func ramp(_ frames: Range<Int>) -> [Float] {
+        return frames.map { Float($0) }
+    }
+}
@@ -0,0 +1,66 @@
+import Foundation
+import PerpetualCore
+import XCTest
+
+/**
+ * PlaybackDeckTests
+ *
+ * Pulls a deck in host-sized blocks the way its source node does. Each
+ * track is a ramp with its own offset, so a gap or overlap at the hand-off
+ * shows up as a missing or repeated value.
+ */
+final class PlaybackDeckTests: XCTestCase {
+    func testHandoffToTheSuccessorLeavesNoGap() {
+        let deck = PlaybackDeck(channelCount: 1, sampleRate: 44100)
+        deck.play(makeRenderer(frameCount: 300, offset: 0))
+        deck.queueNext(makeRenderer(frameCount: 300, offset: 10_000))
+
+        // The first track ends partway through the third block
+        let output = render(deck, frameCount: 512, blockSize: 128)
+
+        XCTAssertEqual(output, ramp(0..<300, offset: 0) + ramp(0..<212, offset: 10_000))
+        XCTAssertEqual(deck.handoffs, 1)
+    }
+
+    func testDeckWithoutSuccessorFallsSilent() {
+        let deck = PlaybackDeck(channelCount: 1, sampleRate: 44100)
+        deck.play(makeRenderer(frameCount: 300, offset: 1))
+
+        let output = render(deck, frameCount: 512, blockSize: 128)
+
+        XCTAssertEqual(output, ramp(0..<300, offset: 1) + [Float](repeating: 0, count: 212))
+        XCTAssertEqual(deck.handoffs, 0)
+    }
+
+    // MARK: - Helpers
+
+    /// A running mono renderer that plays `frameCount` frames of a ramp once
+    private func makeRenderer(frameCount: Int, offset: Float) -> LoopRenderer {
+        let pcm = ResidentPCM(samples: [ramp(0..<frameCount, offset: offset)], sampleRate: 44100)
+        var graph = SegmentGraph()
+        graph.addRegion(name: "Track", startFrame: 0, endFrame: frameCount, behavior: .sequential)
+
+        let renderer = LoopRenderer(pcm: pcm)
+        renderer.setGraph(graph)
+        renderer.setRunning(true)
+        return renderer
+    }
+
+    /// Renders `frameCount` frames of the deck's single channel in `blockSize` pulls
+    private func render(_ deck: PlaybackDeck, frameCount: Int, blockSize: Int) -> [Float] {
+        var output = [Float](repeating: .nan, count: frameCount)
+        output.withUnsafeMutableBufferPointer { samples in
+            var rendered = 0
+            while rendered < frameCount {
+                deck.outputChannels[0] = samples.baseAddress! + rendered
+                deck.render(frameCount: min(blockSize, frameCount - rendered), into: deck.outputChannels)
+                rendered += blockSize
+            }
+        }
+        return output
+    }
+
+    private func ramp(_ frames: Range<Int>, offset: Float) -> [Float] {
+        return frames.map { Float($0) + offset }
+    }
+}